@@ -0,0 +1,344 @@
+/*
+ * tauschema_batch.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_batch.h"
+#include "tauschema_stats.h"
+
+#define RANGE( lo, hi ) ((uint64_t)(lo) | ((uint64_t)(hi) << 32))
+#define RANGE_LO( r ) ((uint32_t)(r))
+#define RANGE_HI( r ) ((uint32_t)((r) >> 32))
+
+/**
+ * Decode the messages lo ... hi-1.
+ *
+ * @return size_t - number of messages decoded successfully
+ */
+static size_t decode( tausch_pool_t *pool, uint32_t lo, uint32_t hi )
+{
+    size_t ok = 0;
+    for( uint32_t i = lo; i < hi; i++ )
+    {
+        tausch_cflater_t cfl;
+        bool rv;
+        if( pool->off == NULL )
+        {
+            const tausch_view_t *m = &pool->msg[i];
+            rv = tausch_cflater_init( &cfl, pool->schema, m->buf, m->len );
+        }
+        else
+        {
+            rv = tausch_cflater_init( &cfl, pool->schema, pool->msg->buf, pool->msg->len );
+            const tausch_iter_t *iter = tausch_cflater_iter( tausch_cflater_seek( &cfl, pool->off[i] ) );
+            rv = rv && tausch_iter_is_ok( iter ) && !tausch_iter_is_end( iter );
+        }
+        if( rv && pool->fn( &cfl, i, pool->ctx ) )
+        {
+            ok += 1;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Take up to TAUSCH_BATCH_CHUNK messages from the front of the own range.
+ *
+ * @return bool - false when the range is empty
+ */
+static bool take( tausch_worker_t *w, uint32_t *lo, uint32_t *hi )
+{
+    uint64_t r = atomic_load( &w->range );
+    while( RANGE_LO( r ) < RANGE_HI( r ) )
+    {
+        uint32_t l = RANGE_LO( r );
+        uint32_t h = RANGE_HI( r );
+        uint32_t e = (h - l) > TAUSCH_BATCH_CHUNK ? l + TAUSCH_BATCH_CHUNK : h;
+        if( atomic_compare_exchange_weak( &w->range, &r, RANGE( e, h ) ) )
+        {
+            *lo = l;
+            *hi = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Move the back half of the victim range into the own range, the last message is
+ * taken whole. The own range must be empty, then no other worker does touch it.
+ *
+ * @return bool - false when the victim range is empty
+ */
+static bool steal( tausch_worker_t *w, tausch_worker_t *victim )
+{
+    uint64_t r = atomic_load( &victim->range );
+    while( RANGE_LO( r ) < RANGE_HI( r ) )
+    {
+        uint32_t l = RANGE_LO( r );
+        uint32_t h = RANGE_HI( r );
+        uint32_t mid = l + (h - l) / 2;
+        if( atomic_compare_exchange_weak( &victim->range, &r, RANGE( l, mid ) ) )
+        {
+            atomic_store( &w->range, RANGE( mid, h ) );
+            w->steals += 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Work on the batch until no worker has messages left.
+ */
+static void work( tausch_worker_t *w )
+{
+    tausch_pool_t *pool = w->pool;
+    size_t me = w - pool->worker;
+    bool found = true;
+    while( found )
+    {
+        uint32_t lo, hi;
+        while( take( w, &lo, &hi ) )
+        {
+            w->ok += decode( pool, lo, hi );
+        }
+        found = false;
+        for( size_t k = 1; (k < pool->nworker) && !found; k++ )
+        {
+            found = steal( w, &pool->worker[(me + k) % pool->nworker] );
+        }
+    }
+}
+
+static void* worker_main( void *arg )
+{
+    tausch_worker_t *w = arg;
+    tausch_pool_t *pool = w->pool;
+    uint64_t gen = 0;
+
+    pthread_mutex_lock( &pool->lock );
+    while( true )
+    {
+        while( (!pool->quit) && (pool->gen == gen) )
+        {
+            pthread_cond_wait( &pool->start, &pool->lock );
+        }
+        if( pool->quit ) break;
+        gen = pool->gen;
+        pthread_mutex_unlock( &pool->lock );
+
+        work( w );
+#ifdef TAUSCH_STATS
+        tausch_stats_merge();   // the counters of this worker into the total
+#endif
+
+        pthread_mutex_lock( &pool->lock );
+        pool->busy -= 1;
+        if( pool->busy == 0 ) pthread_cond_signal( &pool->done );
+    }
+    pthread_mutex_unlock( &pool->lock );
+    return NULL;
+}
+
+/**
+ * Start the worker threads.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ * @param worker : tausch_worker_t* - array of workers
+ * @param n : size_t - number of workers in array
+ * @return bool - false when the threads can not be started
+ */
+bool tausch_pool_init( tausch_pool_t *pool, tausch_worker_t *worker, size_t n )
+{
+    if( pool == NULL ) return false;
+    pool->worker = NULL;
+    pool->nworker = 0;
+    if( (worker == NULL) || (n == 0) ) return false;
+
+    pool->worker = worker;
+    pool->gen = 0;
+    pool->busy = 0;
+    pool->quit = false;
+    pool->schema = NULL;
+    pool->msg = NULL;
+    pool->off = NULL;
+    pool->fn = NULL;
+    pool->ctx = NULL;
+    pthread_mutex_init( &pool->lock, NULL );
+    pthread_cond_init( &pool->start, NULL );
+    pthread_cond_init( &pool->done, NULL );
+
+    for( size_t i = 0; i < n; i++ )
+    {
+        worker[i].pool = pool;
+        worker[i].ok = 0;
+        worker[i].steals = 0;
+        atomic_init( &worker[i].range, 0 );
+        if( pthread_create( &worker[i].thread, NULL, worker_main, &worker[i] ) != 0 )
+        {
+            tausch_pool_close( pool );
+            return false;
+        }
+        pool->nworker = i + 1;
+    }
+    return true;
+}
+
+/**
+ * Run the batch over the messages or over the elements when off is given.
+ *
+ * @return size_t - number of items decoded successfully
+ */
+static size_t run( tausch_pool_t *pool, tausch_schema_t *schema, const tausch_view_t *msg, const tsch_size_t *off,
+    size_t n, tausch_batch_f fn, void *ctx )
+{
+    if( (pool == NULL) || (pool->nworker == 0) ) return 0;
+    if( (schema == NULL) || (msg == NULL) || (fn == NULL) || (n == 0) || (n > UINT32_MAX) ) return 0;
+
+    pool->schema = schema;
+    pool->msg = msg;
+    pool->off = off;
+    pool->fn = fn;
+    pool->ctx = ctx;
+    for( size_t i = 0; i < pool->nworker; i++ )
+    {
+        // even split, the stealing balances the uneven messages
+        tausch_worker_t *w = &pool->worker[i];
+        w->ok = 0;
+        w->steals = 0;
+        atomic_store( &w->range, RANGE( n * i / pool->nworker, n * (i + 1) / pool->nworker ) );
+    }
+
+    pthread_mutex_lock( &pool->lock );
+    pool->gen += 1;
+    pool->busy = pool->nworker;
+    pthread_cond_broadcast( &pool->start );
+    while( pool->busy > 0 )
+    {
+        pthread_cond_wait( &pool->done, &pool->lock );
+    }
+    pthread_mutex_unlock( &pool->lock );
+
+    size_t ok = 0;
+    for( size_t i = 0; i < pool->nworker; i++ )
+    {
+        ok += pool->worker[i].ok;
+    }
+    return ok;
+}
+
+/**
+ * Decode the batch of messages in the pool.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ * @param schema : tausch_schema_t* - schema of the messages, shared read only by the workers
+ * @param msg : tausch_view_t* - array of messages
+ * @param n : size_t - number of messages, up to 2^32 - 1
+ * @param fn : tausch_batch_f - the decoder of single message
+ * @param ctx : void* - context for the decoder
+ * @return size_t - number of messages decoded successfully, the empty messages are failures
+ */
+size_t tausch_pool_run( tausch_pool_t *pool, tausch_schema_t *schema, const tausch_view_t *msg, size_t n,
+    tausch_batch_f fn, void *ctx )
+{
+    return run( pool, schema, msg, NULL, n, fn, ctx );
+}
+
+/**
+ * Find the elements of the root scope with a single pass over the message.
+ *
+ * @param msg : const uint8_t* - the message
+ * @param len : size_t - the message buffer size
+ * @param off : size_t* - array where the offsets of the elements are stored
+ * @param noff : size_t - size of the array, only the first noff offsets are stored
+ * @return size_t - number of the elements in the message, TSCH_NOTHING when the message is broken
+ */
+tsch_size_t tausch_batch_elements( const uint8_t *msg, tsch_size_t len, tsch_size_t *off, tsch_size_t noff )
+{
+    tausch_citer_t ci;
+    tsch_size_t n = 0;
+
+    if( msg == NULL ) return TSCH_NOTHING;
+    (void)tausch_citer_init( &ci, msg, len );
+    while( tausch_citer_next( &ci ) )
+    {
+        if( tausch_iter_is_stuffing( tausch_citer_get( &ci ) ) ) continue;
+        if( n < noff ) off[n] = ci.iter.idx;
+        n += 1;
+    }
+    if( !tausch_iter_is_eof( tausch_citer_get( &ci ) ) ) return TSCH_NOTHING;
+    return n;
+}
+
+/**
+ * Decode the elements of the root scope of a single message in the pool.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ * @param schema : tausch_schema_t* - schema of the message, shared read only by the workers
+ * @param msg : const uint8_t* - the message
+ * @param len : size_t - the message buffer size
+ * @param off : size_t* - offsets of the elements from tausch_batch_elements()
+ * @param n : size_t - number of elements
+ * @param fn : tausch_batch_f - the decoder of single element
+ * @param ctx : void* - context for the decoder
+ * @return size_t - number of elements decoded successfully
+ */
+size_t tausch_pool_run_elements( tausch_pool_t *pool, tausch_schema_t *schema, const uint8_t *msg,
+    tsch_size_t len, const tsch_size_t *off, size_t n, tausch_batch_f fn, void *ctx )
+{
+    tausch_view_t whole = { .buf = msg, .len = len };
+    if( (msg == NULL) || (off == NULL) ) return 0;
+    return run( pool, schema, &whole, off, n, fn, ctx );
+}
+
+/**
+ * Stop and join the worker threads.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ */
+void tausch_pool_close( tausch_pool_t *pool )
+{
+    if( (pool == NULL) || (pool->worker == NULL) ) return;
+
+    pthread_mutex_lock( &pool->lock );
+    pool->quit = true;
+    pthread_cond_broadcast( &pool->start );
+    pthread_mutex_unlock( &pool->lock );
+
+    for( size_t i = 0; i < pool->nworker; i++ )
+    {
+        pthread_join( pool->worker[i].thread, NULL );
+    }
+    pthread_cond_destroy( &pool->done );
+    pthread_cond_destroy( &pool->start );
+    pthread_mutex_destroy( &pool->lock );
+    pool->worker = NULL;
+    pool->nworker = 0;
+}
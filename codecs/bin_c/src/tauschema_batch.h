@@ -0,0 +1,218 @@
+/*
+ * tauschema_batch.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_BATCH_H_
+#define SRC_TAUSCHEMA_BATCH_H_
+
+#include "tauschema_check.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * Number of messages a worker takes from its own range at once.
+ */
+#ifndef TAUSCH_BATCH_CHUNK
+#define TAUSCH_BATCH_CHUNK 4
+#endif
+
+/**
+ * Callback that decodes a single message of the batch or element of the root scope.
+ * It is called from the worker threads, many of them at the same time.
+ *
+ * @param cfl : tausch_cflater_t* - read only flaterator at the beginning of the message or on the element
+ * @param n : size_t - index of the message in the batch or of the element
+ * @param ctx : void* - the context given to tausch_pool_run()
+ * @return bool - true when the message was decoded successfully
+ */
+typedef bool (*tausch_batch_f)( tausch_cflater_t *cfl, size_t n, void *ctx );
+
+typedef struct tausch_pool_s tausch_pool_t;
+
+/**
+ * State of one worker thread of the pool.
+ */
+typedef struct
+{
+    /// Range of message indexes not yet taken, first in low and end in high 32 bits.
+    /** Owner takes from the front, the other workers steal the back half.
+     */
+    _Alignas(64) _Atomic uint64_t range;
+
+    /// The pool the worker belongs to
+    tausch_pool_t *pool;
+
+    /// The thread
+    pthread_t thread;
+
+    /// Number of messages decoded successfully in the current batch
+    size_t ok;
+
+    /// Number of times the worker did steal from others
+    size_t steals;
+
+} tausch_worker_t;
+
+/**
+ * Fixed pool of threads that decode batches of messages. The workers and the
+ * schema are shared by the batches, the schema is only read.
+ */
+struct tausch_pool_s
+{
+    /// Array of the workers
+    tausch_worker_t *worker;
+
+    /// Number of workers, 0 when the pool is not running
+    size_t nworker;
+
+    /// Protects the fields below
+    pthread_mutex_t lock;
+
+    /// Signaled when the batch is started or the pool is closed
+    pthread_cond_t start;
+
+    /// Signaled when the last worker did finish the batch
+    pthread_cond_t done;
+
+    /// Sequence number of the batch
+    uint64_t gen;
+
+    /// Number of workers still working on the batch
+    size_t busy;
+
+    /// The workers shall exit
+    bool quit;
+
+    /// Schema of the messages
+    tausch_schema_t *schema;
+
+    /// The messages of current batch, or the single message of the elements
+    const tausch_view_t *msg;
+
+    /// Offsets of the root elements in the message, NULL when decoding messages
+    const tsch_size_t *off;
+
+    /// The decoder of current batch
+    tausch_batch_f fn;
+
+    /// Context for the decoder
+    void *ctx;
+};
+
+/**
+ * Compile-time allocation of the pool and its workers.
+ *
+ * @param name - name of the pool variable
+ * @param n - number of workers
+ */
+#define TAUSCH_POOL_NEW( name, n ) \
+    tausch_worker_t name ## _worker[ n ]; \
+    tausch_pool_t name
+
+/**
+ * Start the worker threads.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ * @param worker : tausch_worker_t* - array of workers
+ * @param n : size_t - number of workers in array
+ * @return bool - false when the threads can not be started
+ *
+ * @example
+ * TAUSCH_POOL_NEW( pool, 8 );
+ * tausch_pool_init( &pool, pool_worker, 8 );
+ */
+bool tausch_pool_init( tausch_pool_t *pool, tausch_worker_t *worker, size_t n )
+;
+
+/**
+ * Decode the batch of messages in the pool. Every message is given to fn once
+ * with a read only flaterator, the messages are spread over the workers and
+ * the idle workers steal from the busy ones. Returns when all are decoded.
+ * Only one batch can run in the pool at once.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ * @param schema : tausch_schema_t* - schema of the messages, shared read only by the workers
+ * @param msg : tausch_view_t* - array of messages
+ * @param n : size_t - number of messages, up to 2^32 - 1
+ * @param fn : tausch_batch_f - the decoder of single message
+ * @param ctx : void* - context for the decoder
+ * @return size_t - number of messages decoded successfully, the empty messages are failures
+ */
+size_t tausch_pool_run( tausch_pool_t *pool, tausch_schema_t *schema, const tausch_view_t *msg, size_t n,
+    tausch_batch_f fn, void *ctx )
+;
+
+/**
+ * Find the elements of the root scope with a single pass over the message. The
+ * content of the sized scopes is jumped over, the stuffing is not an element.
+ *
+ * @param msg : const uint8_t* - the message
+ * @param len : size_t - the message buffer size
+ * @param off : size_t* - array where the offsets of the elements are stored
+ * @param noff : size_t - size of the array, only the first noff offsets are stored
+ * @return size_t - number of the elements in the message, TSCH_NOTHING when the message is broken
+ *
+ * @example
+ * tsch_size_t n = tausch_batch_elements( msg, len, NULL, 0 );
+ * tsch_size_t *off = malloc( n * sizeof(tsch_size_t) );
+ * tausch_batch_elements( msg, len, off, n );
+ */
+tsch_size_t tausch_batch_elements( const uint8_t *msg, tsch_size_t len, tsch_size_t *off, tsch_size_t noff )
+;
+
+/**
+ * Decode the elements of the root scope of a single message in the pool. The
+ * element ranges are spread over the workers like the messages of a batch, fn is
+ * given a read only flaterator on the element and the index of the element, so
+ * the results stored by the index are in the order of the message.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ * @param schema : tausch_schema_t* - schema of the message, shared read only by the workers
+ * @param msg : const uint8_t* - the message
+ * @param len : size_t - the message buffer size
+ * @param off : size_t* - offsets of the elements from tausch_batch_elements()
+ * @param n : size_t - number of elements
+ * @param fn : tausch_batch_f - the decoder of single element
+ * @param ctx : void* - context for the decoder
+ * @return size_t - number of elements decoded successfully
+ */
+size_t tausch_pool_run_elements( tausch_pool_t *pool, tausch_schema_t *schema, const uint8_t *msg,
+    tsch_size_t len, const tsch_size_t *off, size_t n, tausch_batch_f fn, void *ctx )
+;
+
+/**
+ * Stop and join the worker threads.
+ *
+ * @param pool : tausch_pool_t* - the pool
+ */
+void tausch_pool_close( tausch_pool_t *pool )
+;
+
+#endif /* SRC_TAUSCHEMA_BATCH_H_ */
@@ -30,44 +30,51 @@
  */
 
 #include "tauschema_check.h"
+#include "tauschema_stats.h"
+#include "tauschema_trace.h"
 #include "string.h"
 #include <stdarg.h>
 
 bool tausch_schema_init( tausch_schema_t *schema, const uint8_t *tlv, tsch_size_t len )
 {
-    tausch_iter_t iter;
+    tausch_citer_t ci;
+    const tausch_iter_t *iter = tausch_citer_get( &ci );
 
-    (void)tausch_iter_init( &iter, (uint8_t*)tlv, len );
+    (void)tausch_citer_init( &ci, tlv, len );
     schema->rows.buf = NULL;
     schema->rows.len = 0;
     schema->names.buf = NULL;
     schema->names.len = 0;
     schema->descriptions.buf = NULL;
     schema->descriptions.len = 0;
+    schema->index = NULL;
+    schema->expanded = NULL;
+    schema->slot = NULL;
+    schema->hash = NULL;
 
-    while( tausch_iter_next( &iter ) )
+    while( tausch_citer_next( &ci ) )
     {
-        switch( iter.tag )
+        switch( iter->tag )
         {
             case 1:
             {
                 // names
-                schema->names.buf = &iter.buf[iter.val];
-                schema->names.len = tausch_iter_vlen( &iter );
+                schema->names.buf = &tlv[iter->val];
+                schema->names.len = tausch_iter_vlen( iter );
                 break;
             }
             case 2:
             {
                 // descriptions
-                schema->descriptions.buf = &iter.buf[iter.val];
-                schema->descriptions.len = tausch_iter_vlen( &iter );
+                schema->descriptions.buf = &tlv[iter->val];
+                schema->descriptions.len = tausch_iter_vlen( iter );
                 break;
             }
             case 3:
             {
                 // rows
-                schema->rows.buf = &iter.buf[iter.val];
-                schema->rows.len = tausch_iter_vlen( &iter );
+                schema->rows.buf = &tlv[iter->val];
+                schema->rows.len = tausch_iter_vlen( iter );
                 break;
             }
             default:
@@ -75,24 +82,375 @@ bool tausch_schema_init( tausch_schema_t *schema, const uint8_t *tlv, tsch_size_
                 break;
         }
     }
-    return tausch_iter_is_ok( &iter );
+    return tausch_iter_is_ok( iter );
+}
+
+/**
+ * Find out the amount of bytes the row takes in the rows of schema.
+ *
+ * @param schema : tausch_schema_t* - the schema.
+ * @param idx : size_t - the row.
+ * @return size_t - amount of bytes, 0 on failure.
+ */
+static tsch_size_t tausch_flatrow_size( const tausch_schema_t *schema, tsch_size_t idx )
+{
+    tausch_citer_t ci;
+    tsch_size_t vals = ( (schema->descriptions.buf != NULL) && (schema->descriptions.len > 0) ) ? 6 : 5;
+
+    if( idx >= schema->rows.len ) return 0;
+    (void)tausch_citer_init( &ci, schema->rows.buf + idx, schema->rows.len - idx );
+    for( tsch_size_t k = 0; k < vals; k++ )
+    {
+        if( tausch_iter_decode_vluint( &ci.iter ) == TSCH_NOTHING ) return 0;
+    }
+    return ci.iter.next;
+}
+
+tsch_size_t tausch_schema_expand( tausch_schema_t *schema, tausch_schema_row_t *mem, tsch_size_t size, tsch_size_t *slot )
+{
+    tausch_flatrow_t row;
+    tsch_size_t len = schema->rows.len;
+    tsch_size_t count = 0;
+    tsch_size_t n = 0;
+
+    schema->expanded = NULL;
+    schema->slot = NULL;
+    if( (schema->rows.buf == NULL) || (len == 0) ) return 0;
+
+    // count the rows first, the memory is written only when they fit
+    for( tsch_size_t idx = 0; idx < len; idx += n )
+    {
+        n = tausch_flatrow_size( schema, idx );
+        if( n == 0 ) return 0;
+        count += 1;
+    }
+    if( (mem == NULL) || (slot == NULL) || (count > size) ) return count;
+
+    tausch_flatrow_init( &row, schema );
+    count = 0;
+    for( tsch_size_t idx = 0; idx < len; idx += n )
+    {
+        n = tausch_flatrow_size( schema, idx );
+        if( !tausch_flatrow_decode( &row, idx ) ) return 0;
+        slot[idx] = count;
+        for( tsch_size_t k = 1; k < n; k++ ) slot[idx + k] = TSCH_NOTHING;
+        mem[count].item = row.item;
+        mem[count].name = row.name;
+        mem[count].desc = row.desc;
+        mem[count].sub = row.sub;
+        mem[count].next = row.next;
+        mem[count].ntype = row.ntype;
+        count += 1;
+    }
+    schema->expanded = mem;
+    schema->slot = slot;
+    return count;
+}
+
+/**
+ * Build the lookup table of the scope that has its first item at the row sub.
+ *
+ * @param schema : tausch_schema_t* - the schema.
+ * @param sub : size_t - the first row of the scope.
+ * @param by_name : bool - the table is by name, otherwise by tag.
+ * @param t : tsch_size_t* - memory for the table, NULL to only find out the size.
+ * @param avail : uint64_t - amount of elements available in t.
+ * @return uint64_t - amount of elements in the table, 0 on failure.
+ */
+static uint64_t tausch_schema_table( tausch_schema_t *schema, tsch_size_t sub, bool by_name, tsch_size_t *t, uint64_t avail )
+{
+    tausch_flatrow_t row;
+    uint64_t n = 0;
+    tsch_size_t lo = TSCH_NOTHING;
+    tsch_size_t hi = 0;
+
+    tausch_flatrow_init( &row, schema );
+    for( tsch_size_t idx = sub; (idx > 0) && (n <= schema->rows.len); idx = row.next )
+    {
+        if( !tausch_flatrow_decode( &row, idx ) ) return 0;
+        tsch_size_t key = by_name ? row.name : row.item;
+        if( key < lo ) lo = key;
+        if( key > hi ) hi = key;
+        n += 1;
+    }
+    if( n > schema->rows.len ) return 0;   // the rows are looping
+
+    // direct array when it is not bigger than the sorted pairs
+    bool dense = (n > 0) && (((uint64_t)hi - lo) < (2 * n));
+    uint64_t span = dense ? (uint64_t)hi - lo + 1 : n;
+    uint64_t rv = 3 + (dense ? span : 2 * n);
+    if( (t == NULL) || (rv > avail) ) return rv;
+
+    t[0] = (n > 0) ? lo : 0;
+    t[1] = span;
+    t[2] = dense;
+    if( dense ) memset( &t[3], 0, span * sizeof(*t) );
+    n = 0;
+    for( tsch_size_t idx = sub; idx > 0; idx = row.next )
+    {
+        (void)tausch_flatrow_decode( &row, idx );
+        tsch_size_t key = by_name ? row.name : row.item;
+        if( dense )
+        {
+            // the first of the same keys is found as when walking the siblings
+            if( t[3 + key - lo] == 0 ) t[3 + key - lo] = idx;
+        }
+        else
+        {
+            // insertion keeps the same keys in the order of siblings
+            uint64_t j = n;
+            for( ; (j > 0) && (t[3 + 2 * (j - 1)] > key); j-- )
+            {
+                t[3 + 2 * j] = t[3 + 2 * (j - 1)];
+                t[4 + 2 * j] = t[4 + 2 * (j - 1)];
+            }
+            t[3 + 2 * j] = key;
+            t[4 + 2 * j] = idx;
+        }
+        n += 1;
+    }
+    return rv;
+}
+
+tsch_size_t tausch_schema_index( tausch_schema_t *schema, tsch_size_t *mem, tsch_size_t size )
+{
+    tausch_flatrow_t row;
+    uint64_t pos = schema->rows.len;   // the tables follow the table positions of scopes
+    bool map = (mem != NULL) && (pos <= size);
+    tsch_size_t n = 0;
+
+    schema->index = NULL;
+    if( (schema->rows.buf == NULL) || (schema->rows.len == 0) ) return 0;
+    if( map ) memset( mem, 0, pos * sizeof(*mem) );
+
+    tausch_flatrow_init( &row, schema );
+    for( tsch_size_t idx = 0; idx < schema->rows.len; idx += n )
+    {
+        n = tausch_flatrow_size( schema, idx );
+        if( (n == 0) || !tausch_flatrow_decode( &row, idx ) ) return 0;
+        if( row.sub == 0 ) continue;   // not a scope
+
+        uint64_t avail = ( (mem != NULL) && (size > pos) ) ? size - pos : 0;
+        uint64_t tags = tausch_schema_table( schema, row.sub, false, (avail > 0) ? &mem[pos] : NULL, avail );
+        avail = (avail > tags) ? avail - tags : 0;
+        uint64_t names = tausch_schema_table( schema, row.sub, true, (avail > 0) ? &mem[pos + tags] : NULL, avail );
+        if( (tags == 0) || (names == 0) || ( (pos + tags + names) >= TSCH_NOTHING ) ) return 0;
+        if( map ) mem[idx] = pos;
+        pos += tags + names;
+    }
+    if( (mem != NULL) && (pos <= size) ) schema->index = mem;
+    return pos;
+}
+
+/**
+ * Find the row of the scope by tag or by name from the tables of tausch_schema_index().
+ *
+ * @param schema : tausch_schema_t* - the schema.
+ * @param scope : size_t - the row of the scope.
+ * @param key : size_t - the tag or the name.
+ * @param by_name : bool - the key is name, otherwise tag.
+ * @return size_t - the row, 0 when not in the scope, TSCH_NOTHING when there is no table.
+ */
+static tsch_size_t tausch_schema_lookup( const tausch_schema_t *schema, tsch_size_t scope, tsch_size_t key, bool by_name )
+{
+    if( (schema->index == NULL) || (scope >= schema->rows.len) || (schema->index[scope] == 0) ) return TSCH_NOTHING;
+
+    const tsch_size_t *t = &schema->index[schema->index[scope]];
+    if( by_name ) t += 3 + (t[2] ? t[1] : 2 * t[1]);   // the names follow the tags
+    if( t[2] )
+    {
+        key -= t[0];
+        return (key < t[1]) ? t[3 + key] : 0;
+    }
+    tsch_size_t lo = 0;
+    tsch_size_t hi = t[1];
+    while( lo < hi )
+    {
+        tsch_size_t mid = lo + (hi - lo) / 2;
+        if( t[3 + 2 * mid] < key ) lo = mid + 1;
+        else hi = mid;
+    }
+    return ( (lo < t[1]) && (t[3 + 2 * lo] == key) ) ? t[4 + 2 * lo] : 0;
+}
+
+/**
+ * Compare the name at off in the names with the key of len bytes.
+ *
+ * @return int - <0 when the name is before the key, 0 when equal and >0 when after.
+ */
+static int tausch_schema_namecmp( const tausch_view_t *names, size_t off, const uint8_t *key, size_t len )
+{
+    size_t avail = off < names->len ? names->len - off : 0;
+    const uint8_t *s = &names->buf[off];
+    int cmp = memcmp( s, key, len < avail ? len : avail );
+    if( cmp != 0 ) return cmp;
+    if( len < avail ) return s[len] == 0 ? 0 : 1;
+    return -1;
+}
+
+/**
+ * Hash of the name, FNV-1a with seed.
+ */
+static uint32_t tausch_schema_namehash( const uint8_t *key, size_t len, uint32_t seed )
+{
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b1u);
+    for( size_t i = 0; i < len; i++ )
+    {
+        h ^= key[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+/**
+ * Find the length of the name at off in the names.
+ */
+static size_t tausch_schema_namelen( const tausch_view_t *names, size_t off )
+{
+    const uint8_t *e = memchr( &names->buf[off], 0, names->len - off );
+    return (e != NULL) ? (size_t)(e - &names->buf[off]) : names->len - off;
+}
+
+/**
+ * Place the names of bucket into the free slots with the hash of seed d + 1.
+ *
+ * @return bool - true when all the names got own slot, otherwise nothing is placed.
+ */
+static bool tausch_schema_hash_place( const tausch_view_t *names, const tsch_size_t *order, tsch_size_t n,
+    tsch_size_t *slot, tsch_size_t m, tsch_size_t d )
+{
+    for( tsch_size_t i = 0; i < n; i++ )
+    {
+        tsch_size_t off = order[i];
+        tsch_size_t p = tausch_schema_namehash( &names->buf[off], tausch_schema_namelen( names, off ), d + 1 ) % m;
+        if( slot[p] != 0 )
+        {
+            // collision, take back the names of this trial
+            for( tsch_size_t k = 0; k < i; k++ )
+            {
+                off = order[k];
+                p = tausch_schema_namehash( &names->buf[off], tausch_schema_namelen( names, off ), d + 1 ) % m;
+                slot[p] = 0;
+            }
+            return false;
+        }
+        slot[p] = off + 1;
+    }
+    return true;
+}
+
+tsch_size_t tausch_schema_hash( tausch_schema_t *schema, tsch_size_t *mem, tsch_size_t size )
+{
+    const tausch_view_t *names = &schema->names;
+    uint64_t n = 0;
+
+    schema->hash = NULL;
+    if( (names->buf == NULL) || (names->len == 0) ) return 0;
+    for( size_t off = 0; off < names->len; off += tausch_schema_namelen( names, off ) + 1 )
+    {
+        if( names->buf[off] != 0 ) n += 1;   // the empty name is not hashed
+    }
+
+    // layout: r, m, displacement[r], slot[m], and for building order[n], end[r]
+    uint64_t r = n / 2 + 1;
+    uint64_t m = n + n / 4 + 1;
+    uint64_t rv = 2 + r + m + n + r;
+    if( rv >= TSCH_NOTHING ) return 0;
+    if( (mem == NULL) || (rv > size) ) return rv;
+
+    tsch_size_t *disp = &mem[2];
+    tsch_size_t *slot = &disp[r];
+    tsch_size_t *order = &slot[m];
+    tsch_size_t *end = &order[n];
+    mem[0] = r;
+    mem[1] = m;
+    memset( disp, 0, (r + m) * sizeof(*mem) );
+    memset( end, 0, r * sizeof(*mem) );
+
+    // sort the names by bucket
+    tsch_size_t most = 0;
+    for( size_t off = 0; off < names->len; off += tausch_schema_namelen( names, off ) + 1 )
+    {
+        if( names->buf[off] == 0 ) continue;
+        tsch_size_t b = tausch_schema_namehash( &names->buf[off], tausch_schema_namelen( names, off ), 0 ) % r;
+        end[b] += 1;
+        if( end[b] > most ) most = end[b];
+    }
+    for( tsch_size_t b = 1; b < r; b++ ) end[b] += end[b - 1];
+    for( size_t off = 0; off < names->len; off += tausch_schema_namelen( names, off ) + 1 )
+    {
+        if( names->buf[off] == 0 ) continue;
+        tsch_size_t b = tausch_schema_namehash( &names->buf[off], tausch_schema_namelen( names, off ), 0 ) % r;
+        end[b] -= 1;   // counts down to the start of the bucket
+        order[end[b]] = off;
+    }
+    for( tsch_size_t b = 0; b + 1 < r; b++ ) end[b] = end[b + 1];
+    end[r - 1] = n;
+
+    // the biggest buckets get their displacement first while most of the slots are free
+    for( tsch_size_t k = most; k > 0; k-- )
+    {
+        for( tsch_size_t b = 0; b < r; b++ )
+        {
+            tsch_size_t start = (b > 0) ? end[b - 1] : 0;
+            if( (end[b] - start) != k ) continue;
+            tsch_size_t d = 0;
+            while( !tausch_schema_hash_place( names, &order[start], k, slot, m, d ) )
+            {
+                d += 1;
+                if( (d >= 0xffff) || (d >= TSCH_NOTHING - 1) ) return 0;
+            }
+            disp[b] = d;
+        }
+    }
+    schema->hash = mem;
+    return rv;
 }
 
 tsch_size_t tausch_schema_name_n( tausch_schema_t *schema, char *name_x )
 {
-    // TODO: tausch_schema_name_n is not implemented !
+    const tausch_view_t *names = &schema->names;
+    const uint8_t *key = (const uint8_t*)name_x;
+    size_t len = strlen( name_x );
+
+    if( (names->buf == NULL) || (names->len == 0) || (len == 0) ) return 0;
+
+    if( schema->hash != NULL )
+    {
+        const tsch_size_t *t = schema->hash;
+        tsch_size_t b = tausch_schema_namehash( key, len, 0 ) % t[0];
+        tsch_size_t p = tausch_schema_namehash( key, len, t[2 + b] + 1 ) % t[1];
+        tsch_size_t off = t[2 + t[0] + p];
+        return ( (off > 0) && (tausch_schema_namecmp( names, off - 1, key, len ) == 0) ) ? off - 1 : 0;
+    }
+
+    // the names are sorted, the middle byte is moved back to the start of its name
+    size_t lo = 0;
+    size_t hi = names->len;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        while( (mid > lo) && (names->buf[mid - 1] != 0) ) mid -= 1;
+        int cmp = tausch_schema_namecmp( names, mid, key, len );
+        if( cmp == 0 ) return mid;
+        if( cmp < 0 ) lo = mid + tausch_schema_namelen( names, mid ) + 1;
+        else hi = mid;
+    }
     return 0;
 }
 
-tsch_size_t tausch_schema_str( tausch_blob_t *strings, char *name_x, tsch_size_t name_len, tsch_size_t name_n )
+tsch_size_t tausch_schema_str( const tausch_view_t *strings, char *name_x, tsch_size_t name_len, tsch_size_t name_n )
 {
     tsch_size_t rv = 0;
     name_x[0] = 0;
     if( name_n < strings->len )
     {
-        strncpy( name_x, (char*)&strings->buf[name_n], name_len );
-        strings->buf[name_len - 1] = 0;
-        rv = strlen( (char*)&strings->buf[name_n] );
+        strncpy( name_x, (const char*)&strings->buf[name_n], name_len );
+        name_x[name_len - 1] = 0;
+        rv = strlen( (const char*)&strings->buf[name_n] );
     }
     return rv;
 }
@@ -111,30 +469,46 @@ bool tausch_flatrow_init( tausch_flatrow_t *row, tausch_schema_t *schema )
 
 bool tausch_flatrow_decode( tausch_flatrow_t *row, tsch_size_t idx )
 {
-    tausch_iter_t iter;
+    tausch_citer_t iter;
 
     if( idx >= row->schema->rows.len ) return false;
 
-    tausch_iter_init( &iter, row->schema->rows.buf + idx, row->schema->rows.len - idx );
+    if( row->schema->expanded != NULL )
+    {
+        // the row is already decoded by tausch_schema_expand()
+        tsch_size_t k = row->schema->slot[idx];
+        if( k == TSCH_NOTHING ) return false;   // not the start of a row
+        const tausch_schema_row_t *x = &row->schema->expanded[k];
+        row->item = x->item;
+        row->name = x->name;
+        row->desc = x->desc;
+        row->ntype = x->ntype;
+        row->sub = x->sub;
+        row->next = x->next;
+        return true;
+    }
+
+    TAUSCH_STAT( rows, 1 );
+    tausch_citer_init( &iter, row->schema->rows.buf + idx, row->schema->rows.len - idx );
 
-    row->item = tausch_iter_decode_vluint( &iter );
+    row->item = tausch_iter_decode_vluint( &iter.iter );
     if( row->item == TSCH_NOTHING ) return false;
 
-    row->name = tausch_iter_decode_vluint( &iter );
+    row->name = tausch_iter_decode_vluint( &iter.iter );
     if( row->item == TSCH_NOTHING ) return false;
 
-    row->ntype = tausch_iter_decode_vluint( &iter );
+    row->ntype = tausch_iter_decode_vluint( &iter.iter );
     if( row->ntype == TSCH_NOTHING ) return false;
 
-    row->sub = tausch_iter_decode_vluint( &iter );
+    row->sub = tausch_iter_decode_vluint( &iter.iter );
     if( row->sub == TSCH_NOTHING ) return false;
 
-    row->next = tausch_iter_decode_vluint( &iter );
+    row->next = tausch_iter_decode_vluint( &iter.iter );
     if( row->next == TSCH_NOTHING ) return false;
 
     if( (row->schema->descriptions.buf != NULL) && (row->schema->descriptions.len > 0) )
     {
-        row->desc = tausch_iter_decode_vluint( &iter );
+        row->desc = tausch_iter_decode_vluint( &iter.iter );
         if( row->desc == TSCH_NOTHING ) return false;
     }
 
@@ -148,6 +522,9 @@ bool tausch_flater_init( tausch_flater_t *flat, tausch_schema_t *schema, uint8_t
     (void)tausch_flatrow_init( &flat->row, schema );
     flat->scope = 0;
     flat->idx = TSCH_NOTHING;
+#ifdef TAUSCH_TRACE
+    flat->t0 = tausch_trace_now();
+#endif
     return true;
 }
 
@@ -172,7 +549,8 @@ static tsch_size_t tausch_nargs( va_list argptr )
 static tausch_flater_t* v_tausch_flater_go_to( tausch_flater_t *flat, va_list argptr )
 {
     tsch_size_t item;
-    while( (item = va_arg( argptr, tsch_size_t )) > 0 )
+    // narrow tsch_size_t arguments are promoted when passed through '...'
+    while( (item = (tsch_size_t)va_arg( argptr, __typeof__( +(tsch_size_t)0 ) )) > 0 )
     {
         if( (flat->idx > 0) && (flat->idx != TSCH_NOTHING) && (flat->row.sub > 0) && (flat->scope != flat->idx) )
         {
@@ -185,6 +563,19 @@ static tausch_flater_t* v_tausch_flater_go_to( tausch_flater_t *flat, va_list ar
                 break;
             }
         }
+        flat->idx = tausch_schema_lookup( flat->row.schema, flat->scope, item, true );
+        if( flat->idx != TSCH_NOTHING )
+        {
+            // the row is known from the table of scope, find it from the binary too
+            tausch_flatrow_decode( &flat->row, flat->idx );
+            if( (flat->idx > 0) && (flat->iter.buf != NULL) && (!tausch_iter_go_to_tag( &flat->iter, flat->row.item )) )
+            {
+                flat->idx = 0;
+                tausch_flatrow_decode( &flat->row, flat->idx );
+            }
+            continue;
+        }
+
         //start from the beginning of scope
         tausch_flatrow_decode( &flat->row, flat->scope );
         flat->idx = flat->row.sub;
@@ -277,6 +668,11 @@ tausch_flater_t* tausch_flater_next( tausch_flater_t *flat )
         flat->idx = 0;
         tausch_flatrow_decode( &flat->row, flat->idx );
     }
+    else if( (flat->idx = tausch_schema_lookup( flat->row.schema, flat->scope, flat->iter.tag, false )) != TSCH_NOTHING )
+    {
+        // the row is known from the table of scope
+        tausch_flatrow_decode( &flat->row, flat->idx );
+    }
     else
     {
         // start search from the beginning of the scope of schema
@@ -284,22 +680,51 @@ tausch_flater_t* tausch_flater_next( tausch_flater_t *flat )
         flat->idx = flat->row.sub;
         tausch_flatrow_decode( &flat->row, flat->idx );
 
-        while( (flat->idx > 0) && (flat->idx != TSCH_NOTHING) && (flat->iter.tag != flat->row.item) )
+        while( (flat->idx > 0) && (flat->idx != TSCH_NOTHING) &&
+            (TAUSCH_STAT( compares, 1 ), flat->iter.tag != flat->row.item) )
         {
             flat->idx = flat->row.next;
             tausch_flatrow_decode( &flat->row, flat->idx );
         }
         // if the schemaitem was not found in the scope, then pidx is 0
     }
+#ifdef TAUSCH_TRACE
+    if( (flat->t0 != 0) && (flat->iter.buf != NULL) && tausch_iter_is_eof( &flat->iter ) )
+    {
+        tausch_trace_done( TAUSCH_TRACE_MESSAGE, 0, flat->t0 );
+        flat->t0 = 0;   // the message is done
+    }
+#endif
     return flat;
 }
 
+tausch_flater_t* tausch_flater_seek( tausch_flater_t *flat, tsch_size_t offset )
+{
+    // like the reset, the row of root scope is decoded by the next
+    flat->idx = TSCH_NOTHING;
+    flat->scope = 0;
+    tausch_iter_reset( &flat->iter );
+    if( (flat->iter.buf == NULL) || (offset >= flat->iter.ebuf) )
+    {
+        // dead end, the iterator is not ok until reset
+        flat->idx = 0;
+        tausch_flatrow_decode( &flat->row, flat->idx );
+        flat->iter.idx = flat->iter.next = flat->iter.val = flat->iter.ebuf;
+        return flat;
+    }
+    // the clean iterator at root decodes the next TLV from the offset
+    flat->iter.idx = offset;
+    flat->iter.next = offset;
+    flat->iter.val = offset;
+    return tausch_flater_next( flat );
+}
+
 tausch_flater_t* tausch_flater_go_eof( tausch_flater_t *flat )
 {
     tausch_flater_reset( flat );
     if( flat->iter.buf != NULL )
     {
-        if( (!tausch_iter_exit_scope( &flat->iter )) || (!tausch_iter_is_eof( &flat->iter )) )
+        if( !tausch_iter_go_eof( &flat->iter ) )
         {
             tausch_flater_reset( flat );
         }
@@ -310,6 +735,9 @@ tausch_flater_t* tausch_flater_go_eof( tausch_flater_t *flat )
 tausch_flater_t tausch_flater_clone( tausch_flater_t *flat )
 {
     tausch_flater_t rv = *flat;
+#ifdef TAUSCH_TRACE
+    rv.t0 = 0;   // only the flaterator of tausch_flater_init() finishes the message
+#endif
     if( (rv.idx > 0) && (rv.idx != TSCH_NOTHING) && (rv.row.sub > 0) )//&& (rv.scope != rv.idx) )
     {
         // the iterator has been stopping on the scope
@@ -323,16 +751,47 @@ tausch_flater_t tausch_flater_clone( tausch_flater_t *flat )
     return rv;
 }
 
-char* tausch_flater_tag_x( tausch_flater_t *flat )
+const char* tausch_flater_tag_x( tausch_flater_t *flat )
 {
-    uint8_t *buf = flat->row.schema->names.buf;
+    const uint8_t *buf = flat->row.schema->names.buf;
     if( (flat->idx > 0) && (flat->idx != TSCH_NOTHING) && (buf != NULL) )
     {
-        return (char*)buf + flat->row.name;
+        return (const char*)buf + flat->row.name;
     }
     return 0;
 }
 
+bool tausch_cflater_init( tausch_cflater_t *cfl, tausch_schema_t *schema, const uint8_t *msg, tsch_size_t msg_len )
+{
+    if( cfl == NULL ) return false;
+    // the only place where the const is dropped, none of the cflater methods write
+    return tausch_flater_init( &cfl->flat, schema, (uint8_t*)msg, msg_len );
+}
+
+tausch_cflater_t* tausch_cflater_reset( tausch_cflater_t *cfl )
+{
+    (void)tausch_flater_reset( &cfl->flat );
+    return cfl;
+}
+
+tausch_cflater_t* tausch_cflater_next( tausch_cflater_t *cfl )
+{
+    (void)tausch_flater_next( &cfl->flat );
+    return cfl;
+}
+
+tausch_cflater_t tausch_cflater_clone( tausch_cflater_t *cfl )
+{
+    tausch_cflater_t rv = { .flat = tausch_flater_clone( &cfl->flat ) };
+    return rv;
+}
+
+tausch_cflater_t* tausch_cflater_seek( tausch_cflater_t *cfl, tsch_size_t offset )
+{
+    (void)tausch_flater_seek( &cfl->flat, offset );
+    return cfl;
+}
+
 static bool valconv_uint2uint( uint8_t *to, uint8_t tolen, uint8_t *from, uint8_t fromlen )
 {
     uint64_t in = 0;
@@ -387,15 +846,15 @@ static bool valconv_sint2sint( uint8_t *to, uint8_t tolen, uint8_t *from, uint8_
 static bool valconv_float2float( uint8_t *to, uint8_t tolen, uint8_t *from, uint8_t fromlen )
 {
     double resd;
-    uint64_t in;
-    memcpy( &in, from, fromlen );
     if( fromlen == 4 )
     {
-        resd = *(float*)&in;
+        float f;
+        memcpy( &f, from, 4 );
+        resd = f;
     }
     else if( fromlen == 8 )
     {
-        resd = *(double*)&in;
+        memcpy( &resd, from, 8 );
     }
     else
     {
@@ -420,15 +879,17 @@ static bool valconv_float2float( uint8_t *to, uint8_t tolen, uint8_t *from, uint
 static bool valconv_float2uint( uint8_t *to, uint8_t tolen, uint8_t *from, uint8_t fromlen )
 {
     uint64_t res = 0;
-    uint64_t in;
-    memcpy( &in, from, fromlen );
     if( fromlen == 4 )
     {
-        res = *(float*)&in;
+        float f;
+        memcpy( &f, from, 4 );
+        res = f;
     }
     else if( fromlen == 8 )
     {
-        res = *(double*)&in;
+        double d;
+        memcpy( &d, from, 8 );
+        res = d;
     }
     else
     {
@@ -445,15 +906,17 @@ static bool valconv_float2uint( uint8_t *to, uint8_t tolen, uint8_t *from, uint8
 static bool valconv_float2sint( uint8_t *to, uint8_t tolen, uint8_t *from, uint8_t fromlen )
 {
     int64_t res = 0;
-    uint64_t in;
-    memcpy( &in, from, fromlen );
     if( fromlen == 4 )
     {
-        res = *(float*)&in;
+        float f;
+        memcpy( &f, from, 4 );
+        res = f;
     }
     else if( fromlen == 8 )
     {
-        res = *(double*)&in;
+        double d;
+        memcpy( &d, from, 8 );
+        res = d;
     }
     else
     {
@@ -569,17 +1032,20 @@ static bool valconv_float2bool( uint8_t *to, uint8_t tolen, uint8_t *from, uint8
     memset( to, 0, tolen );
     if( fromlen == 4 )
     {
-        float f = *(float*)from;
+        float f;
+        memcpy( &f, from, 4 );
         *to = ( (f > 0.001) || (f < -0.001)) ? 1 : 0;
     }
     else if( fromlen == 8 )
     {
-        double f = *(double*)from;
+        double f;
+        memcpy( &f, from, 8 );
         *to = ( (f > 0.001) || (f < -0.001)) ? 1 : 0;
     }
     else if( fromlen == 16 )
     {
-        long double f = *(long double*)from;
+        long double f;
+        memcpy( &f, from, sizeof(f) );
         *to = ( (f > 0.001) || (f < -0.001)) ? 1 : 0;
     }
     else
@@ -727,18 +1193,21 @@ static bool valconv( tausch_ntype_t totyp, uint8_t *to, uint8_t tolen, tausch_nt
 static tsch_size_t v_tausch_flater_rd_donotuse( tausch_flater_t *flat, tausch_ntype_t typ, uint8_t *buf,
     tsch_size_t len, va_list argptr )
 {
+    TAUSCH_TRACE_BEGIN( t0 );
     tsch_size_t rv = 0;
     tausch_flater_t fl = tausch_flater_clone( flat );
 
     // go to position if indexes are provided
     v_tausch_flater_go_to( &fl, argptr );
 
-    if( fl.idx == 0 ) return 0;   // finding the item has failed, nothing to read
-
-    tsch_size_t vlen = tausch_iter_vlen( &fl.iter );   // take the value length from iterator
+    tsch_size_t vlen = (fl.idx != 0) ? tausch_iter_vlen( &fl.iter ) : 0;   // take the value length from iterator
 
     // now we are in position for reading
-    if( ( (fl.row.ntype == TSCH_BLOB) || (fl.row.ntype == TSCH_UTF8)) && (typ == TSCH_BLOB) )
+    if( fl.idx == 0 )
+    {
+        rv = 0;   // finding the item has failed, nothing to read
+    }
+    else if( ( (fl.row.ntype == TSCH_BLOB) || (fl.row.ntype == TSCH_UTF8)) && (typ == TSCH_BLOB) )
     {
         // using BLOB read method
         tausch_blob_t tmp = { .buf = buf, .len = len };
@@ -771,6 +1240,7 @@ static tsch_size_t v_tausch_flater_rd_donotuse( tausch_flater_t *flat, tausch_nt
         rv = 0;   // we do not know how to read such thing
     }
 
+    TAUSCH_TRACE_END( TAUSCH_TRACE_READ, fl.idx != 0 ? fl.row.name : 0, t0 );
     return rv;
 }
 
@@ -800,6 +1270,29 @@ tsch_size_t tausch_flater_rd_blob( tausch_flater_t *flat, tausch_blob_t *blob, .
     return v_tausch_flater_rd_donotuse( flat, TSCH_BLOB, blob->buf, blob->len, argptr );
 }
 
+bool tausch_flater_view_donotuse( tausch_flater_t *flat, tausch_view_t *view, ... )
+{
+    va_list argptr;
+
+    view->buf = NULL;
+    view->len = 0;
+
+    if( flat->idx == 0 ) return false;   // the flaterator is stuck
+
+    if( flat->iter.buf == NULL ) return false;   // no iterator provided
+
+    va_start( argptr, view );
+
+    tausch_flater_t fl = tausch_flater_clone( flat );
+    v_tausch_flater_go_to( &fl, argptr );
+
+    if( fl.idx == 0 ) return false;   // finding the item has failed
+
+    if( (fl.row.ntype != TSCH_BLOB) && (fl.row.ntype != TSCH_UTF8) ) return false;
+
+    return tausch_iter_view( &fl.iter, view );
+}
+
 tsch_size_t tausch_flater_write_any( tausch_flater_t *flat, tsch_size_t nam, tausch_ntype_t typ, uint8_t *buf,
     tsch_size_t len )
 {
@@ -824,6 +1317,17 @@ tsch_size_t tausch_flater_write_any( tausch_flater_t *flat, tsch_size_t nam, tau
             fl.iter.buf = NULL;
             tausch_flater_go_to( &fl, nam );
             fl.iter.buf = flat->iter.buf;
+            if( (fl.idx != 0) && (fl.iter.holes != NULL) )
+            {
+                // use the smallest stuffing of the scope that does fit the item
+                tausch_iter_t it = fl.iter;
+                tsch_size_t vlen = len;
+                if( (typ != TSCH_BLOB) && (typ != TSCH_UTF8) && (fl.row.ntype < TSCH_UTF8) )
+                {
+                    vlen = valuelengths[fl.row.ntype] > 8 ? 8 : valuelengths[fl.row.ntype];
+                }
+                if( tausch_iter_go_to_hole( &it, tausch_tlv_size( fl.row.item, vlen ) ) ) fl.iter = it;
+            }
         }
     }
 
@@ -921,7 +1425,7 @@ tsch_size_t tausch_flater_write_str( tausch_flater_t *flat, tsch_size_t nam, cha
     return tausch_flater_write_any( flat, nam, TSCH_UTF8, (uint8_t*)str, strnlen( str, flat->iter.ebuf ) );
 }
 
-bool tausch_flater_write_scope( tausch_flater_t *flat, tsch_size_t nam, tausch_flater_scope_writer_f writer )
+static bool flater_write_scope( tausch_flater_t *flat, tsch_size_t nam, tausch_flater_scope_writer_f writer )
 {
     bool rv = true;
 
@@ -948,12 +1452,18 @@ bool tausch_flater_write_scope( tausch_flater_t *flat, tsch_size_t nam, tausch_f
     fl_ini.iter.buf = flat->iter.buf;
     *flat = fl_ini;
 
+    // the window of the stuffing in the message
+    tsch_size_t wbeg = fl.iter.idx;
+    tsch_size_t wend = fl.iter.next;
+
     // change the buffer space to hold also EOS
     fl.iter.buf = &flat->iter.buf[fl.iter.idx];
     fl.iter.next -= fl.iter.idx;
     fl.iter.idx = 0;
     fl.iter.ebuf = fl.iter.next - 1;
     fl.iter.next -= 2;
+    fl.iter.eof = NULL;   // the window has its own fake EOF
+    fl.iter.holes = NULL;   // and offsets
     if( fl.iter.next <= fl.iter.idx ) return false;   // absolutely no space to write anything
     fl.iter.val = TSCH_NOTHING;
     fl.iter.buf[fl.iter.next] = 7;   // write the EOF into place
@@ -1005,7 +1515,36 @@ bool tausch_flater_write_scope( tausch_flater_t *flat, tsch_size_t nam, tausch_f
             return 0;
         }
     }
+    if( flat->iter.eof != NULL )
+    {
+        // the window did move the EOF, find it again from the written scope
+        *flat->iter.eof = TSCH_NOTHING;
+        (void)tausch_iter_eof( &flat->iter );
+    }
+    if( flat->iter.holes != NULL )
+    {
+        // the scope was written over the stuffing, index the stuffing the window left after it
+        tausch_iter_t t = flat->iter;
+        tsch_size_t from = rv ? wbeg + fl.iter.idx + 1 : wbeg;
+        tausch_holes_cut( t.holes, wbeg, from );
+        t.idx = t.next = t.val = from;
+        t.lc = 0;
+        while( (t.idx < wend) && tausch_iter_next( &t ) && tausch_iter_is_stuffing( &t ) && (t.idx < wend) )
+        {
+            tausch_holes_add( &t );
+        }
+        // the window left its EOF after the scope, the message ends there
+        if( tausch_iter_is_eof( &t ) && (t.idx < wend) ) tausch_holes_cut( t.holes, t.idx, TSCH_NOTHING );
+    }
 
     return rv;
 }
 
+bool tausch_flater_write_scope( tausch_flater_t *flat, tsch_size_t nam, tausch_flater_scope_writer_f writer )
+{
+    TAUSCH_TRACE_BEGIN( t0 );
+    bool rv = flater_write_scope( flat, nam, writer );
+    TAUSCH_TRACE_END( TAUSCH_TRACE_WRITE_SCOPE, nam, t0 );
+    return rv;
+}
+
@@ -64,6 +64,19 @@ typedef struct tausch_schema_s tausch_schema_t;
 typedef struct tausch_flatrow_s tausch_flatrow_t;
 typedef struct tausch_flaterator_s tausch_flater_t;
 
+/**
+ * The flatrow of schema decoded into fixed width, see tausch_schema_expand().
+ */
+typedef struct
+{
+    tsch_size_t item;
+    tsch_size_t name;
+    tsch_size_t desc;
+    tsch_size_t sub;
+    tsch_size_t next;
+    uint8_t ntype;
+} tausch_schema_row_t;
+
 /**
  * Structure that describes how to read out the schema from the memory.
  *
@@ -95,13 +108,25 @@ typedef struct tausch_flaterator_s tausch_flater_t;
 struct tausch_schema_s
 {
     /// pointer to the memory that does conation VLUINT array of numbers
-    tausch_blob_t rows;
+    tausch_view_t rows;
 
     /// pointer to the memory where name strings start
-    tausch_blob_t names;
+    tausch_view_t names;
 
     /// pointer to the memory where description strings start
-    tausch_blob_t descriptions;
+    tausch_view_t descriptions;
+
+    /// lookup tables of the scopes built by tausch_schema_index(), NULL when not built
+    tsch_size_t *index;
+
+    /// rows decoded by tausch_schema_expand(), one element per row, NULL when not expanded
+    tausch_schema_row_t *expanded;
+
+    /// element of expanded for every byte of the rows, TSCH_NOTHING inside the row
+    tsch_size_t *slot;
+
+    /// perfect hash of the names built by tausch_schema_hash(), NULL when not built
+    tsch_size_t *hash;
 
 // pointer to the memory where string compression table resides
 //tausch_blob_t compress;
@@ -120,7 +145,67 @@ struct tausch_schema_s
 bool tausch_schema_init( tausch_schema_t *schema, const uint8_t *tlv, tsch_size_t len );
 
 /**
- * Find the name index from the names array using binary searching algorithm of the strings.
+ * Build the lookup tables from the tag and from the name to the row for every scope of the schema
+ * into the caller memory and attach them to the schema. The tausch_flater_next() and the
+ * tausch_flater_go_to() find the row then directly instead of walking over the siblings of scope.
+ *
+ * The memory starts with the table position of every scope indexed by its row, followed by the
+ * tables of tags and names of the scopes. The table is direct array of rows when the keys are
+ * dense, otherwise sorted array of key and row pairs that is binary searched.
+ *
+ * @attention The memory shall not be freed as long the schema is used.
+ *
+ * @param schema : tausch_schema_t* - initiated schema.
+ * @param mem : tsch_size_t* - memory for the tables, NULL to only find out the size.
+ * @param size : size_t - amount of elements in the mem.
+ * @return size_t - amount of elements needed, 0 on failure. The tables are attached to the
+ *      schema only when it is not more than size.
+ */
+tsch_size_t tausch_schema_index( tausch_schema_t *schema, tsch_size_t *mem, tsch_size_t size );
+
+/**
+ * Decode the rows of the schema once into the caller memory and attach them to the schema. The
+ * tausch_flatrow_decode() copies the row then instead of decoding the VLUINTs. The rows are
+ * stored one element per row, and the slot map gives for every byte of the rows the element of
+ * the row that starts there, so that the row index is still used directly. The offsets inside
+ * a row are TSCH_NOTHING in the map, they are not decoded.
+ *
+ * The memory is sizeof(tausch_schema_row_t) per row in mem and sizeof(tsch_size_t) per byte of
+ * the rows in slot. A row takes about 5 bytes, so with uint32_t tsch_size_t it is about 44 bytes
+ * per row.
+ *
+ * @attention The memory shall not be freed as long the schema is used.
+ *
+ * @param schema : tausch_schema_t* - initiated schema.
+ * @param mem : tausch_schema_row_t* - memory for the rows, NULL to only find out the size.
+ * @param size : size_t - amount of elements in the mem.
+ * @param slot : tsch_size_t* - memory of schema->rows.len elements for the slot map.
+ * @return size_t - amount of rows, the elements needed in mem, 0 on failure. The rows are
+ *      attached to the schema only when it is not more than size.
+ */
+tsch_size_t tausch_schema_expand( tausch_schema_t *schema, tausch_schema_row_t *mem, tsch_size_t size, tsch_size_t *slot );
+
+/**
+ * Build the perfect hash of the names of schema into the caller memory and attach it to the
+ * schema. The tausch_schema_name_n() finds the name then with two hashes and one compare
+ * instead of the binary search.
+ *
+ * The memory contains the displacement of every bucket and the slots of names, the part
+ * after them is used only while building.
+ *
+ * @attention The memory shall not be freed as long the schema is used.
+ *
+ * @param schema : tausch_schema_t* - initiated schema.
+ * @param mem : tsch_size_t* - memory for the hash, NULL to only find out the size.
+ * @param size : size_t - amount of elements in the mem.
+ * @return size_t - amount of elements needed, 0 on failure. The hash is attached to the
+ *      schema only when it is not more than size.
+ */
+tsch_size_t tausch_schema_hash( tausch_schema_t *schema, tsch_size_t *mem, tsch_size_t size );
+
+/**
+ * Find the name index from the names array using binary searching algorithm of the strings,
+ * or from the perfect hash when it is built by tausch_schema_hash().
  *
  * @param schema : tausch_schema_t* - the schema from which the name is looked for.
  * @param name_x : UTF-8* - the name of the item.
@@ -136,7 +221,7 @@ tsch_size_t tausch_schema_name_n( tausch_schema_t *schema, char *name_x );
  * if it is not then the remainder of the string will be copied and total remainder available
  * is placed in return value.
  *
- * @param strings : tausch_blob_t* - pointer to the blob containing array of strings.
+ * @param strings : tausch_view_t* - pointer to the view containing array of strings, it is not modified.
  * @param name_x : char* - pointer to memory where to store the name string.
  * @param name_len : size_t - amount of memory available for the name string.
  * @param name_n : size_t - the index in name.
@@ -145,7 +230,7 @@ tsch_size_t tausch_schema_name_n( tausch_schema_t *schema, char *name_x );
  * @see TAUSCH_SCHEMA_STR_NAME
  * @see TAUSCH_SCHEMA_STR_DESC
  */
-tsch_size_t tausch_schema_str( tausch_blob_t *strings, char *name_x, tsch_size_t name_len, tsch_size_t name_n );
+tsch_size_t tausch_schema_str( const tausch_view_t *strings, char *name_x, tsch_size_t name_len, tsch_size_t name_n );
 
 /**
  * Copy a name string to memory array nam_x that does have name index nam_n fromt schema sch.
@@ -252,6 +337,10 @@ struct tausch_flaterator_s
 
     tausch_iter_t iter;
 
+#ifdef TAUSCH_TRACE
+    /// Time of tausch_flater_init(), 0 when the message is done or in clone
+    uint64_t t0;
+#endif
 };
 
 /**
@@ -308,7 +397,19 @@ tausch_flater_t* tausch_flater_reset( tausch_flater_t *flat );
 tausch_flater_t* tausch_flater_next( tausch_flater_t *flat );
 
 /**
- * Advance the iterator to the EOF.
+ * Move the flaterator onto the element of the root scope that starts at the offset,
+ * for example one recorded by tausch_batch_elements(). The elements before it are
+ * not walked. When the offset is out of message the iterator is not ok until reset.
+ *
+ * @param flat : tausch_flater_t* - the flaterator to move.
+ * @param offset : size_t - offset of the TLV of the element in message.
+ * @return tausch_flater_t* - the same object as argument.
+ */
+tausch_flater_t* tausch_flater_seek( tausch_flater_t *flat, tsch_size_t offset );
+
+/**
+ * Advance the iterator to the EOF. The EOF is found without walking the message
+ * when the EOF tracker is attached with tausch_iter_track( &flat->iter, &eof ).
  *
  * @param flat : tausch_flater_t* -the flaterator to advance.
  * @return tausch_flater_t* - the same object as argument.
@@ -352,9 +453,9 @@ tausch_flater_t tausch_flater_clone( tausch_flater_t *flat );
  * no string possible.
  *
  * @param flat : tausch_flater_t* - the flaterator object.
- * @return char* - pointer to the tag name string (utf-8).
+ * @return const char* - pointer to the tag name string (utf-8) in the schema.
  */
-char* tausch_flater_tag_x( tausch_flater_t *flat );
+const char* tausch_flater_tag_x( tausch_flater_t *flat );
 
 /**
  * Get the tag of current item in string enumerator format.
@@ -421,6 +522,28 @@ char* tausch_flater_tag_x( tausch_flater_t *flat );
  tausch_blob_t* : tausch_flater_rd_blob((flat), (tausch_blob_t*)(value), ##__VA_ARGS__,0)  \
 )
 
+/**
+ * Produce view of the BLOB or UTF8 value in the message without copying it. It does
+ * not change current flaterator. The view is valid as long as the message buffer is
+ * and the value is not overwritten.
+ *
+ * @param flat : tausch_flater_t* - the flaterator to use basis for the reading.
+ * @param view : tausch_view_t* - the view to fill in.
+ * @param ... : size_t - indexes of the names, does not need to be 0 ending
+ * @return bool - true on success, false on error.
+ *
+ * @example
+ * tausch_view_t serial;
+ * if( tausch_flater_view( &fl, &serial, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_serial,
+ *     TAUSCH_NAM_DEVICE_INFO_data ) )
+ * {
+ *     forward( serial.buf, serial.len );
+ * }
+ */
+#define tausch_flater_view( flat, view, ... ) ({                                         \
+    bool tausch_flater_view_donotuse( tausch_flater_t *, tausch_view_t *, ... );        \
+    tausch_flater_view_donotuse( (flat), (view), ##__VA_ARGS__, 0 ); })
+
 /**
  * Write the value based of current item into message. It does not change current flaterator
  * and does create a copy of it before the flaterator will be advanced to the field.
@@ -458,6 +581,103 @@ char* tausch_flater_tag_x( tausch_flater_t *flat );
  char*          : tausch_flater_write_str((flat), (nam), (char*)(value) )  \
 )
 
+/**
+ * Read only flaterator. It does only have the methods that never write into the message,
+ * so the message can be const ROM, a page mapped PROT_READ or a buffer shared by many
+ * threads, each thread having its own cflater.
+ */
+typedef struct
+{
+    /// The flaterator, the codec never writes through its iter
+    tausch_flater_t flat;
+} tausch_cflater_t;
+
+/**
+ * Initiate the read only flaterator structure
+ *
+ * @param cfl : tausch_cflater_t* - the read only flaterator.
+ * @param schema : tausch_schema_t* - the schema for verifications and automation.
+ * @param msg : const uint8_t* - the message buffer.
+ * @param msg_len : size_t - the message buffer size.
+ * @return bool - true on success false on failure.
+ */
+bool tausch_cflater_init( tausch_cflater_t *cfl, tausch_schema_t *schema, const uint8_t *msg, tsch_size_t msg_len );
+
+/**
+ * Reset the read only flaterator to beginning
+ *
+ * @param cfl : tausch_cflater_t* - pointer to the object to reset.
+ * @return tausch_cflater_t* - pointer to the same object as the argument.
+ */
+tausch_cflater_t* tausch_cflater_reset( tausch_cflater_t *cfl );
+
+/**
+ * Advance the read only flaterator to next element on message.
+ *
+ * @see tausch_flater_next
+ */
+tausch_cflater_t* tausch_cflater_next( tausch_cflater_t *cfl );
+
+/**
+ * Clone the read only flaterator.
+ *
+ * @see tausch_flater_clone
+ */
+tausch_cflater_t tausch_cflater_clone( tausch_cflater_t *cfl );
+
+/**
+ * Move the read only flaterator onto the element of the root scope at the offset.
+ *
+ * @see tausch_flater_seek
+ */
+tausch_cflater_t* tausch_cflater_seek( tausch_cflater_t *cfl, tsch_size_t offset );
+
+/**
+ * Iterate in flat tree to the name in the sub-scope after the current position.
+ *
+ * @see tausch_flater_go_to
+ */
+#define tausch_cflater_go_to( cfl, ... ) ({                                             \
+    tausch_cflater_t *_cfl = (cfl);                                                     \
+    (void)tausch_flater_go_to( &_cfl->flat, ##__VA_ARGS__ ); _cfl; })
+
+/**
+ * Get the current decoded flat tree row.
+ *
+ * @param cfl : tausch_cflater_t* - the read only flaterator.
+ * @return tausch_flatrow_t*
+ */
+#define tausch_cflater_get( cfl ) (&(cfl)->flat.row)
+
+/**
+ * Get the const iterator of the read only flaterator for the queries.
+ *
+ * @param cfl : tausch_cflater_t* - the read only flaterator.
+ * @return const tausch_iter_t*
+ */
+#define tausch_cflater_iter( cfl ) ((const tausch_iter_t*)&(cfl)->flat.iter)
+
+/**
+ * Get the tag of current item in string enumerator format.
+ *
+ * @see tausch_flater_tag_n
+ */
+#define tausch_cflater_tag_n( cfl ) tausch_flater_tag_n( &(cfl)->flat )
+
+/**
+ * Read the value based of current item.
+ *
+ * @see tausch_flater_read
+ */
+#define tausch_cflater_read( cfl, value, ... ) tausch_flater_read( &(cfl)->flat, (value), ##__VA_ARGS__ )
+
+/**
+ * Produce view of the BLOB or UTF8 value in the message without copying it.
+ *
+ * @see tausch_flater_view
+ */
+#define tausch_cflater_view( cfl, view, ... ) tausch_flater_view( &(cfl)->flat, (view), ##__VA_ARGS__ )
+
 
 /**
  * Callback function type for writing scope contents. The scope is already opened and when the function
@@ -30,8 +30,14 @@
  */
 
 #include "tauschema_codec.h"
+#include "tauschema_stats.h"
+#include "tauschema_trace.h"
 #include "string.h"
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 /**
  * Runtime formatting of the buffer.
  * When at the root leve, end of scope is found, it means
@@ -73,6 +79,7 @@ tausch_iter_t* tausch_iter_reset( tausch_iter_t *iter )
     iter->tag = TSCH_NOTHING;
     iter->vlen = 0;
     iter->scope = 0;
+    iter->nopen = 0;
     iter->lc = 0;
     return iter;
 }
@@ -83,7 +90,7 @@ tausch_iter_t* tausch_iter_reset( tausch_iter_t *iter )
  * @arg iter : tausch_iter_t* - pointer to the iterator
  * @return true if it is byte of EOF
  */
-bool tausch_iter_is_eof( tausch_iter_t *iter )
+bool tausch_iter_is_eof( const tausch_iter_t *iter )
 {
     return ( (iter->lc == 3) && (iter->tag > 0) && (iter->tag != TSCH_NOTHING));
 }
@@ -94,7 +101,7 @@ bool tausch_iter_is_eof( tausch_iter_t *iter )
  * @arg iter : tausch_iter_t* - pointer to the iterator
  * @return true if it is byte of EOS or EOF
  */
-bool tausch_iter_is_end( tausch_iter_t *iter )
+bool tausch_iter_is_end( const tausch_iter_t *iter )
 {
     return (iter->lc == 3);
 }
@@ -108,6 +115,7 @@ bool tausch_iter_is_end( tausch_iter_t *iter )
 tausch_iter_t* tausch_iter_format( tausch_iter_t *iter )
 {
     iter->buf[iter->next] = 7;
+    if( iter->eof != NULL ) *iter->eof = iter->next;
     return iter;
 }
 
@@ -116,7 +124,7 @@ tausch_iter_t* tausch_iter_format( tausch_iter_t *iter )
  *
  * @arg iter : tausch_iter_t* - the iterator to verify
  */
-bool tausch_iter_is_ok( tausch_iter_t *iter )
+bool tausch_iter_is_ok( const tausch_iter_t *iter )
 {
     bool notok = false;
     notok |= iter->ebuf == 0;   // there is no buffer pointed
@@ -134,7 +142,7 @@ bool tausch_iter_is_ok( tausch_iter_t *iter )
  *
  * @return true if all the elements of TLV have been parsed
  */
-bool tausch_iter_is_complete( tausch_iter_t *iter )
+bool tausch_iter_is_complete( const tausch_iter_t *iter )
 {
     // we do not check if iter is ok here, because that would reduce dimensions
     return iter->val != iter->next;
@@ -143,7 +151,7 @@ bool tausch_iter_is_complete( tausch_iter_t *iter )
 /**
  * @return true if the value is null
  */
-bool tausch_iter_is_null( tausch_iter_t *iter )
+bool tausch_iter_is_null( const tausch_iter_t *iter )
 {
     return iter->val == TSCH_NOTHING;
 }
@@ -153,7 +161,7 @@ bool tausch_iter_is_null( tausch_iter_t *iter )
  *
  * @return true if the iterator is clean for write
  */
-bool tausch_iter_is_clean( tausch_iter_t *iter )
+bool tausch_iter_is_clean( const tausch_iter_t *iter )
 {
     if( !tausch_iter_is_ok( iter ) ) return false;
     return (iter->next == iter->idx) && (iter->val == iter->next);
@@ -162,7 +170,7 @@ bool tausch_iter_is_clean( tausch_iter_t *iter )
 /**
  * @return size of the stuffing when the iter is stuffing, otherwise 0
  */
-tsch_size_t tausch_iter_is_stuffing( tausch_iter_t *iter )
+tsch_size_t tausch_iter_is_stuffing( const tausch_iter_t *iter )
 {
     if( !tausch_iter_is_ok( iter ) ) return 0;
     if( iter->tag != 0 ) return 0;
@@ -176,71 +184,198 @@ tsch_size_t tausch_iter_is_stuffing( tausch_iter_t *iter )
  * @param iter : tausch_iter_t*
  * @return bool
  */
-bool tausch_iter_is_scope( tausch_iter_t *iter )
+bool tausch_iter_is_scope( const tausch_iter_t *iter )
 {
     return ( (iter->lc & 3) == 1);
 }
 
 /**
- * Return amount of free space in buffer
+ * Return if the iterator is at start of sized scope, the scope that carries its length.
+ * The vlen is then the length of the scope content including its END.
  *
  * @param iter : tausch_iter_t*
- * @return size_t
+ * @return bool
  */
-tsch_size_t tausch_iter_buff_free( tausch_iter_t *iter )
+bool tausch_iter_is_sized( const tausch_iter_t *iter )
+{
+    return tausch_iter_is_scope( iter ) && (iter->vlen > 0);
+}
+
+/**
+ * Attach the EOF tracker to the iterator. The EOF is searched on first use of the tracker.
+ *
+ * @param iter : tausch_iter_t* - the iterator
+ * @param eof : tsch_size_t* - memory of the tracker, NULL to detach
+ * @return tausch_iter_t* - the iter
+ */
+tausch_iter_t* tausch_iter_track( tausch_iter_t *iter, tsch_size_t *eof )
+{
+    iter->eof = eof;
+    if( eof != NULL ) *eof = TSCH_NOTHING;
+    return iter;
+}
+
+/**
+ * Return the offset of EOF. It is taken from the tracker when available,
+ * otherwise the message is walked from the iterator position to EOF.
+ *
+ * @param iter : tausch_iter_t*
+ * @return tsch_size_t - the offset of EOF or TSCH_NOTHING when the message is broken
+ */
+tsch_size_t tausch_iter_eof( tausch_iter_t *iter )
 {
-    if( iter->ebuf == 0 ) return 0;
+    if( iter->ebuf == 0 ) return TSCH_NOTHING;
+    if( iter->eof != NULL )
+    {
+        tsch_size_t eof = *iter->eof;
+        // verify that the tracker still points to T7
+        if( (eof < iter->ebuf) && (iter->buf[eof] == 7) ) return eof;
+    }
     tausch_iter_t ti = *iter;
     while( (!tausch_iter_is_eof( &ti )) && tausch_iter_is_ok( &ti ) )
     {
         (void)tausch_iter_exit_scope( &ti );
     }
-    if( tausch_iter_is_ok( &ti ) )
+    if( !tausch_iter_is_ok( &ti ) ) return TSCH_NOTHING;
+    if( iter->eof != NULL ) *iter->eof = ti.idx;
+    return ti.idx;
+}
+
+/**
+ * Position the iterator onto EOF at root scope.
+ *
+ * @param iter : tausch_iter_t*
+ * @return bool - false when EOF was not found
+ */
+bool tausch_iter_go_eof( tausch_iter_t *iter )
+{
+    tausch_iter_reset( iter );
+    tsch_size_t eof = tausch_iter_eof( iter );
+    if( eof == TSCH_NOTHING ) return false;
+    iter->idx = eof;
+    iter->next = eof + 1;
+    iter->val = TSCH_NOTHING;
+    iter->tag = 1;
+    iter->lc = 3;
+    return true;
+}
+
+/**
+ * Return amount of free space in buffer
+ *
+ * @param iter : tausch_iter_t*
+ * @return size_t
+ */
+tsch_size_t tausch_iter_buff_free( tausch_iter_t *iter )
+{
+    tsch_size_t eof = tausch_iter_eof( iter );
+    if( eof == TSCH_NOTHING ) return 0;
+    return iter->ebuf - eof - 1;
+}
+
+/**
+ * Decode the vluint from 8 bytes loaded as little endian word.
+ *
+ * @arg w - the bytes, first byte of vluint in least significant bits
+ * @arg len - output, number of bytes the vluint takes, 0 if it is longer than 8 bytes
+ *
+ * @return the decoded value
+ */
+static inline uint64_t tausch_vluint_word( uint64_t w, tsch_size_t *len )
+{
+    uint64_t stop = ~w & 0x8080808080808080ull;   // bytes without continuation bit
+    if( stop == 0 )
     {
-        return ti.ebuf - ti.idx - 1;
+        *len = 0;
+        return 0;
     }
-    return 0;
+    unsigned bits = __builtin_ctzll( stop ) + 1;   // bits up to the last byte of vluint
+    *len = bits >> 3;
+    if( bits < 64 ) w &= (1ull << bits) - 1;
+#ifdef __BMI2__
+    return _pext_u64( w, 0x7f7f7f7f7f7f7f7full );
+#else
+    // gather the 7 bit groups in three steps
+    w &= 0x7f7f7f7f7f7f7f7full;
+    w = (w & 0x007f007f007f007full) | ((w & 0x7f007f007f007f00ull) >> 1);
+    w = (w & 0x00003fff00003fffull) | ((w & 0x3fff00003fff0000ull) >> 2);
+    w = (w & 0x000000000fffffffull) | ((w & 0x0fffffff00000000ull) >> 4);
+    return w;
+#endif
 }
 
 /**
  * Decode from binary buffer the variable length unsigned integer
  *
- * @arg iter - the iterator from where to read
+ * When at least 8 bytes are left in the buffer, the vluint is decoded with
+ * single load, otherwise byte by byte.
  *
- * @return the decoded tag value, or TSCH_NOTHING (all bits set) on failure
+ * @arg iter - the iterator from where to read
  *
+ * @return the decoded tag value, or ~0 (all bits set) on failure. The iterator becomes
+ *         invalid when the buffer ends or the value does not fit into tsch_size_t.
  */
 tsch_size_t tausch_iter_decode_vluint( tausch_iter_t *iter )
 {
-    tsch_size_t rv = 0;
-    uint8_t x = 0;
-    uint8_t s = 0;
+    uint64_t rv = 0;
+    bool lost = false;   // some bits did not fit into 64 bits
     if( iter->next != iter->val ) return TSCH_NOTHING;
-    do
+    if( !tausch_iter_is_ok( iter ) ) return TSCH_NOTHING;
+
+    tsch_size_t len = 0;
+    if( (iter->next < iter->ebuf) && (iter->buf[iter->next] < 0x80) )
     {
-        if( !tausch_iter_is_ok( iter ) ) return TSCH_NOTHING;
-        if( iter->next >= iter->ebuf )
-        {
-            iter->ebuf = 0;
-            return TSCH_NOTHING;
-        }
-        x = iter->buf[iter->next];
-        if( (s + 1) < (sizeof(tsch_size_t) * 8) )
-        {
-            // we do not support bigger numbers for vluint
-            rv |= ((tsch_size_t)x & 0x7f) << s;
-            // FIXME: check also tag overflow, some bits may flow over.
-            s += 7;
-        }
-        else
+        // most of tags and lengths fit into single byte
+        iter->next += 1;
+        iter->val = iter->next;
+        return iter->buf[iter->next - 1];
+    }
+    if( (iter->ebuf - iter->next) >= 8 )
+    {
+        uint64_t w;
+        memcpy( &w, &iter->buf[iter->next], sizeof(w) );
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        w = __builtin_bswap64( w );
+#endif
+        rv = tausch_vluint_word( w, &len );
+        iter->next += len;
+    }
+    if( len == 0 )
+    {
+        // near the end of buffer or longer than 8 bytes
+        uint8_t x = 0;
+        unsigned s = 0;
+        rv = 0;
+        do
         {
-            rv = TSCH_NOTHING;
+            if( iter->next >= iter->ebuf )
+            {
+                iter->ebuf = 0;
+                return TSCH_NOTHING;
+            }
+            x = iter->buf[iter->next];
+            if( s < 64 )
+            {
+                rv |= ((uint64_t)x & 0x7f) << s;
+                lost |= (s > 57) && ((x & 0x7f) >> (64 - s));
+                s += 7;
+            }
+            else
+            {
+                lost |= (x & 0x7f) != 0;
+            }
+            iter->next += 1;
         }
-        iter->next += 1;
+        while( (x & 0x80) == 0x80 );
+    }
+    if( lost || (rv >= (uint64_t)TSCH_NOTHING) )
+    {
+        // the value does not fit into tsch_size_t
+        iter->ebuf = 0;
+        return TSCH_NOTHING;
     }
-    while( (x & 0x80) == 0x80 );
     iter->val = iter->next;
-    return rv;
+    return (tsch_size_t)rv;
 }
 
 /**
@@ -289,6 +424,24 @@ tsch_size_t tausch_vluint_len( tsch_size_t val )
     return rv;
 }
 
+/**
+ * Encode the vluint into exactly width bytes, it is padded with 0x80 bytes when the
+ * value takes less. The value must fit into width bytes.
+ *
+ * @arg buf - where to write
+ * @arg val - the value to encode
+ * @arg width - number of bytes to write
+ */
+void tausch_vluint_write( uint8_t *buf, tsch_size_t val, tsch_size_t width )
+{
+    for( tsch_size_t i = 1; i < width; i++ )
+    {
+        *(buf++) = (uint8_t)(val | 0x80);
+        val >>= 7;
+    }
+    *buf = (uint8_t)(val & 0x7f);
+}
+
 /**
  * Decodes from binary buffer next TLV item and stores info inside iter element.
  * It does not skip over stuffing. It stays onto the current scope and jumps
@@ -304,6 +457,7 @@ bool tausch_iter_next( tausch_iter_t *iter )
     tsch_size_t tag = 0;
     tsch_size_t len = 0;
     uint16_t sco = iter->scope;
+    tsch_size_t from = iter->next;
     bool rv = true;
 
     do
@@ -315,6 +469,7 @@ bool tausch_iter_next( tausch_iter_t *iter )
         if( !tausch_iter_is_ok( iter ) )
         {
             // iterator became invalid
+            TAUSCH_STAT( failures, 1 );
             rv = false;
             continue;   // the while cycle handles the exit
         }
@@ -338,7 +493,12 @@ bool tausch_iter_next( tausch_iter_t *iter )
                 iter->scope -= 1;
             }
         }
-        if( tausch_iter_is_scope( iter ) )
+        if( tausch_iter_is_sized( iter ) )
+        {
+            // the length of the scope is known, jump over its content and END
+            iter->next += iter->vlen;
+        }
+        else if( tausch_iter_is_scope( iter ) )
         {
             // we skip over the scope
             iter->scope += 1;
@@ -351,11 +511,38 @@ bool tausch_iter_next( tausch_iter_t *iter )
         tag = tausch_iter_decode_vluint( iter );
         if( !tausch_iter_is_ok( iter ) )
         {
+            TAUSCH_STAT( failures, 1 );
             return false;   // the iterator became invalid
         }
+        TAUSCH_STAT( tlvs, 1 );
         iter->lc = tag & 3;
         iter->tag = tag >> 2;
 
+        if( (iter->lc == 3) && (iter->tag > 1) )
+        {
+            // sized scope, the length of the content including its END follows
+            len = tausch_iter_decode_vluint( iter );
+            if( !tausch_iter_is_ok( iter ) )
+            {
+                TAUSCH_STAT( failures, 1 );
+                return false;   // the iterator became invalid
+            }
+            if( (len == 0) ||
+                ( (iter->next + len) <= iter->next) ||
+                ( (iter->next + len) > iter->ebuf) )
+            {
+                // the scope can not be empty or overflow the buffer
+                iter->val = TSCH_NOTHING;
+                iter->ebuf = 0;
+                TAUSCH_STAT( failures, 1 );
+                return false;   // the iterator became invalid
+            }
+            iter->lc = 1;
+            iter->vlen = len;
+            iter->val = TSCH_NOTHING;
+            continue;   // the while cycle handles the exit
+        }
+
         if( tausch_iter_is_end( iter ) )
         {
             // end of scope
@@ -375,6 +562,7 @@ bool tausch_iter_next( tausch_iter_t *iter )
             len = tausch_iter_decode_vluint( iter );
             if( !tausch_iter_is_ok( iter ) )
             {
+                TAUSCH_STAT( failures, 1 );
                 return false;   // the iterator became invalid
             }
         }
@@ -389,6 +577,7 @@ bool tausch_iter_next( tausch_iter_t *iter )
                 // the buffer overflow is happening
                 iter->val = TSCH_NOTHING;
                 iter->ebuf = 0;
+                TAUSCH_STAT( failures, 1 );
                 return false;   // the iterator became invalid
             }
             iter->val = iter->next;
@@ -402,6 +591,7 @@ bool tausch_iter_next( tausch_iter_t *iter )
     }
     while( rv && (sco < iter->scope) );
 
+    TAUSCH_STAT( scanned, iter->next > from ? iter->next - from : 0 );
     return rv;
 }
 
@@ -418,6 +608,11 @@ bool tausch_iter_enter_scope( tausch_iter_t *iter )
     rv = rv && tausch_iter_is_scope( iter );
     if( rv )
     {
+        if( (iter->nopen == iter->scope) && (iter->scope < TAUSCH_OPEN_DEPTH) )
+        {
+            iter->open[iter->scope] = iter->idx;
+            iter->nopen += 1;
+        }
         iter->idx = iter->next;
         iter->val = iter->next;
         iter->lc = 0;
@@ -462,6 +657,7 @@ bool tausch_iter_exit_scope( tausch_iter_t *iter )
         iter->val = iter->next;
         iter->lc = 0;
         iter->scope -= 1;
+        if( iter->nopen > iter->scope ) iter->nopen = iter->scope;   // back to the opener of outer scope
         rv = true;
     }
     else
@@ -500,6 +696,189 @@ bool tausch_iter_go_to_stuffing( tausch_iter_t *iter )
     return false;   // EOS
 }
 
+/**
+ * The offset of the opener of the current scope, the key of scope in the hole index.
+ * TSCH_NOTHING at root scope, or when the scope was not entered within TAUSCH_OPEN_DEPTH.
+ */
+static tsch_size_t tausch_iter_opener( const tausch_iter_t *iter )
+{
+    if( (iter->scope == 0) || (iter->scope > iter->nopen) ) return TSCH_NOTHING;
+    return iter->open[iter->scope - 1];
+}
+
+/**
+ * Remove the entry from the hole index.
+ */
+static void tausch_holes_remove( tausch_holes_t *holes, tsch_size_t k )
+{
+    holes->count -= 1;
+    holes->hole[k] = holes->hole[holes->count];
+}
+
+/**
+ * Add the stuffing the iterator is on into the hole index. The entries inside it are
+ * removed whatever their depth, the ones that overlap it at the same depth too. The scope
+ * is taken from the iterator, or from the adjacent stuffing when the iterator does not know it.
+ *
+ * @param iter : tausch_iter_t* - the iterator on the stuffing
+ */
+void tausch_holes_add( tausch_iter_t *iter )
+{
+    tausch_holes_t *holes = iter->holes;
+    tsch_size_t idx = iter->idx;
+    tsch_size_t next = iter->next;
+    tsch_size_t open = tausch_iter_opener( iter );
+    bool known = (iter->scope == 0) || (open != TSCH_NOTHING);
+
+    for( tsch_size_t k = 0; k < holes->count; k++ )
+    {
+        tausch_hole_t *h = &holes->hole[k];
+        if( (h->idx > next) || ( (h->idx + h->len) < idx) ) continue;
+        if( (h->idx >= idx) && ( (h->idx + h->len) <= next) )
+        {
+            // inside the new stuffing, also the stuffing of the erased subscopes
+            tausch_holes_remove( holes, k );
+            k -= 1;
+            continue;
+        }
+        if( h->scope != iter->scope ) continue;
+        // overlapping or adjacent stuffing at the same depth is in the same scope
+        if( !known ) open = h->open;
+        known = true;
+        if( (h->idx < next) && ( (h->idx + h->len) > idx) )
+        {
+            tausch_holes_remove( holes, k );
+            k -= 1;
+        }
+    }
+    if( !known ) return;   // the scope is not known, not indexed
+    if( holes->count >= holes->size ) return;   // not indexed
+    tausch_hole_t *h = &holes->hole[holes->count++];
+    h->idx = idx;
+    h->len = next - idx;
+    h->open = open;
+    h->scope = iter->scope;
+}
+
+/**
+ * Remove the entries that overlap the region, it was written over.
+ */
+void tausch_holes_cut( tausch_holes_t *holes, tsch_size_t from, tsch_size_t to )
+{
+    for( tsch_size_t k = 0; k < holes->count; k++ )
+    {
+        tausch_hole_t *h = &holes->hole[k];
+        if( (h->idx < to) && ( (h->idx + h->len) > from) )
+        {
+            tausch_holes_remove( holes, k );
+            k -= 1;
+        }
+    }
+}
+
+/**
+ * Drop the entries of the hole index from the offset on, the EOF was moved there.
+ */
+static void tausch_holes_drop( tausch_holes_t *holes, tsch_size_t from )
+{
+    for( tsch_size_t k = 0; k < holes->count; k++ )
+    {
+        if( holes->hole[k].idx >= from )
+        {
+            tausch_holes_remove( holes, k );
+            k -= 1;
+        }
+    }
+}
+
+/**
+ * Attach the hole index to the iterator and build it from the message. The
+ * message is walked once.
+ *
+ * @param iter : tausch_iter_t* - the iterator
+ * @param holes : tausch_holes_t* - the hole index, NULL to detach
+ * @return tausch_iter_t* - the iter
+ */
+tausch_iter_t* tausch_iter_holes( tausch_iter_t *iter, tausch_holes_t *holes )
+{
+    iter->holes = holes;
+    if( holes == NULL ) return iter;
+    holes->count = 0;
+
+    tausch_iter_t ti = TAUSCH_ITER_INIT( iter->buf, iter->ebuf );
+    for( ;; )
+    {
+        if( tausch_iter_next( &ti ) )
+        {
+            if( tausch_iter_is_stuffing( &ti ) && (holes->count < holes->size) )
+            {
+                tausch_hole_t *h = &holes->hole[holes->count++];
+                h->idx = ti.idx;
+                h->len = ti.next - ti.idx;
+                h->open = tausch_iter_opener( &ti );
+                h->scope = ti.scope;
+            }
+            else if( tausch_iter_is_scope( &ti ) )
+            {
+                (void)tausch_iter_enter_scope( &ti );
+            }
+        }
+        else if( tausch_iter_is_ok( &ti ) && tausch_iter_is_end( &ti ) && (!tausch_iter_is_eof( &ti )) )
+        {
+            if( !tausch_iter_exit_scope( &ti ) ) break;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return iter;
+}
+
+/**
+ * Advance the iterator to the smallest stuffing in its scope that can hold len bytes.
+ * The stuffing is looked up from the hole index attached to the iterator, the entries that
+ * are not stuffing anymore are dropped.
+ *
+ * @param iter : tausch_iter_t* - the iterator with hole index
+ * @param len : tsch_size_t - number of bytes needed, see tausch_tlv_size()
+ * @return bool - true when the iterator was moved onto the stuffing
+ */
+bool tausch_iter_go_to_hole( tausch_iter_t *iter, tsch_size_t len )
+{
+    tausch_holes_t *holes = iter->holes;
+    if( (holes == NULL) || (!tausch_iter_is_ok( iter )) ) return false;
+    tsch_size_t open = tausch_iter_opener( iter );
+    if( (iter->scope > 0) && (open == TSCH_NOTHING) ) return false;   // the scope is not known
+
+    tsch_size_t best = TSCH_NOTHING;
+    for( tsch_size_t k = 0; k < holes->count; k++ )
+    {
+        tausch_hole_t *h = &holes->hole[k];
+        if( (h->scope != iter->scope) || (h->open != open) || (h->len < len) ) continue;
+        if( (best != TSCH_NOTHING) && (holes->hole[best].len <= h->len) ) continue;
+
+        // verify that it is still the same stuffing
+        tausch_iter_t ti = *iter;
+        ti.idx = ti.next = ti.val = h->idx;
+        ti.lc = 0;
+        if( (!tausch_iter_next( &ti )) || (tausch_iter_is_stuffing( &ti ) != h->len) )
+        {
+            tausch_holes_remove( holes, k );
+            if( best == holes->count ) best = k;   // the best was moved into place of removed
+            k -= 1;
+            continue;
+        }
+        best = k;
+    }
+    if( best == TSCH_NOTHING ) return false;
+
+    iter->idx = iter->next = iter->val = holes->hole[best].idx;
+    iter->lc = 0;
+    iter->vlen = 0;
+    return tausch_iter_next( iter );
+}
+
 /**
  * Advance the iterator to the next tag in the scope.
  *
@@ -563,6 +942,8 @@ tsch_size_t tausch_tlv_vlen( tsch_size_t tag, tsch_size_t memlen )
     return rv;
 }
 
+static bool tausch_iter_erase_item( tausch_iter_t *iter );
+
 /**
  * Overwrite the iterator memspace between idx and next, including tag, len and value.
  * It does not take much care of what is in the message already written.
@@ -586,8 +967,11 @@ tsch_size_t tausch_tlv_vlen( tsch_size_t tag, tsch_size_t memlen )
  */
 static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag, uint8_t *buf, tsch_size_t len, bool exact )
 {
-    if( !tausch_iter_is_ok( iter ) ) return 0;
-    if( tausch_iter_is_scope( iter ) ) return 0;
+    if( !tausch_iter_is_ok( iter ) || tausch_iter_is_scope( iter ) )
+    {
+        TAUSCH_STAT( failures, 1 );
+        return 0;
+    }
 
     tausch_iter_t tm = *iter;   // temporary iterator for rollback
 
@@ -602,11 +986,16 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
             {
                 tsch_size_t memlen = iter->ebuf - iter->idx - 1;
                 len = tausch_tlv_vlen( tag, memlen );
-                if( len >= memlen ) return 0;   // was not able to find smaller len
+                if( len >= memlen )
+                {
+                    TAUSCH_STAT( failures, 1 );
+                    return 0;   // was not able to find smaller len
+                }
                 tlvlen = tausch_tlv_size( tag, len );
             }
             else
             {
+                TAUSCH_STAT( failures, 1 );
                 return 0;   // no exact writing possible
             }
         }
@@ -616,12 +1005,15 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
     else if( tausch_iter_is_end( iter ) )
     {
         // if the iterator is at end then we do not overwrite
+        TAUSCH_STAT( failures, 1 );
         return 0;
     }
     tsch_size_t memlen = iter->next - iter->idx;   // now, find the available memory based on iterator
     if( exact && (tlvlen != memlen) )
     {
         *iter = tm;   // we can rollback here
+        TAUSCH_STAT( rollbacks, 1 );
+        TAUSCH_STAT( failures, 1 );
         return 0;   // the input data does not match exactly
     }
 
@@ -633,6 +1025,8 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
         {
             // it is not possible to write even tag
             *iter = tm;
+            TAUSCH_STAT( rollbacks, 1 );
+            TAUSCH_STAT( failures, 1 );
             return 0;
         }
         tlvlen = memlen;
@@ -654,6 +1048,7 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
         if( !ok )
         {
             iter->ebuf = 0;   // we have messed up the message
+            TAUSCH_STAT( failures, 1 );
             return 0;
         }
         if( buf == NULL )
@@ -675,7 +1070,7 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
         iter->next += memlen - tlvlen;
         iter->lc = 0;
 
-        ok = ok && tausch_iter_erase( iter );
+        ok = ok && tausch_iter_erase_item( iter );
 
         tausch_iter_t si = *iter;
         while( tausch_iter_next(&si) && tausch_iter_is_stuffing(&si) )
@@ -683,19 +1078,22 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
             // we have turned a part of item to be stuffing, if stuffing follows
             // then collapse the stuffings into one bigger stuffing
             // next returns false on eof
+            TAUSCH_STAT( merges, 1 );
         }
 
         if( tausch_iter_is_eof(&si) )
         {
             // si idx is on eof, we move the eof to the beginning of iter
             tausch_format_buf(&iter->buf[iter->idx]);
+            if( iter->eof != NULL ) *iter->eof = iter->idx;
+            if( iter->holes != NULL ) tausch_holes_drop( iter->holes, iter->idx );
             memlen = iter->idx - tm.idx;
         }
         else if( si.idx > iter->next )
         {
             // si idx is on something else,
             iter->next = si.idx;
-            ok = ok && tausch_iter_erase( iter );
+            ok = ok && tausch_iter_erase_item( iter );
         }
         else
         {
@@ -706,6 +1104,7 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
     if( !ok )
     {
         iter->ebuf = 0;   // we have messed up the message
+        TAUSCH_STAT( failures, 1 );
         return 0;
     }
 
@@ -720,6 +1119,7 @@ static tsch_size_t tausch_iter_overwrite( tausch_iter_t *iter, tsch_size_t tag,
     {
         // what ? failed ??
         iter->ebuf = 0;
+        TAUSCH_STAT( failures, 1 );
         return 0;
     }
 
@@ -750,10 +1150,14 @@ bool tausch_iter_write_stuffing( tausch_iter_t *iter, tsch_size_t len )
     }
     if( tausch_iter_is_eof( iter ) )
     {
-        return tausch_iter_overwrite( iter, 0, NULL, tausch_tlv_vlen(0,len), true ) > 0;
+        bool rv = tausch_iter_overwrite( iter, 0, NULL, tausch_tlv_vlen(0,len), true ) > 0;
+        if( rv && (iter->holes != NULL) ) tausch_holes_add( iter );
+        return rv;
     }
     len = iter->next - iter->idx;
-    return tausch_iter_overwrite( iter, 0, NULL, tausch_tlv_vlen(0,len), true ) > 0;
+    bool rv = tausch_iter_overwrite( iter, 0, NULL, tausch_tlv_vlen(0,len), true ) > 0;
+    if( rv && (iter->holes != NULL) ) tausch_holes_add( iter );
+    return rv;
 }
 
 /**
@@ -765,21 +1169,148 @@ bool tausch_iter_write_stuffing( tausch_iter_t *iter, tsch_size_t len )
  * @param iter
  * @return
  */
-bool tausch_iter_erase( tausch_iter_t *iter )
+static bool tausch_iter_erase_item( tausch_iter_t *iter )
 {
-    if( !tausch_iter_is_ok( iter ) ) return false;
-    if( !tausch_iter_is_complete( iter ) ) return false;
-    if( tausch_iter_is_end( iter ) ) return false; // end or eof
-    if( tausch_iter_is_scope( iter ) )
+    bool rv = tausch_iter_is_ok( iter ) && tausch_iter_is_complete( iter );
+    rv = rv && !tausch_iter_is_end( iter );   // end or eof
+    if( rv && tausch_iter_is_scope( iter ) )
     {
         tausch_iter_t tm = *iter;
-        // advance the temporary iterator at the end of current scope
-        if( ! tausch_iter_exit_scope( &tm ) ) return false;
+        // advance the temporary iterator over the end of the erased scope
+        rv = tausch_iter_enter_scope( &tm );
+        if( rv && tausch_iter_is_sized( iter ) )
+        {
+            // no need to walk, the length is known
+            tm.idx = tm.next = tm.val = iter->next + iter->vlen;
+            tm.vlen = 0;
+            tm.scope -= 1;
+        }
+        else if( rv )
+        {
+            rv = tausch_iter_exit_scope( &tm );
+        }
         // idx is now at the end of eos also next is at the end
         tm.idx = iter->idx;
-        *iter = tm;
+        tm.nopen = iter->nopen;
+        if( rv ) *iter = tm;
+    }
+    rv = rv && tausch_iter_write_stuffing( iter, iter->next - iter->idx );
+    if( !rv ) TAUSCH_STAT( failures, 1 );
+    return rv;
+}
+
+/**
+ * Erase the current item, turn fully into stuffing. Traced variant of the
+ * tausch_iter_erase_item() for the application.
+ *
+ * @param iter
+ * @return
+ */
+bool tausch_iter_erase( tausch_iter_t *iter )
+{
+    TAUSCH_TRACE_BEGIN( t0 );
+    tsch_size_t tag = iter->tag;
+    bool rv = tausch_iter_erase_item( iter );
+    TAUSCH_TRACE_END( TAUSCH_TRACE_ERASE, tag, t0 );
+    return rv;
+}
+
+/**
+ * Compact the message, all the stuffing is removed. The TLV following stuffing are
+ * moved to the left and the EOF is moved to the new end. The lengths of the sized
+ * scopes are updated, sized scopes deeper than TAUSCH_COMPACT_DEPTH are moved without
+ * compacting their content.
+ *
+ * It is done in single pass over the message, the iterator is reset to the beginning
+ * of the message. On failure the iterator is broken, the message may be too.
+ *
+ * @param iter : tausch_iter_t* - iterator of the message
+ * @return tsch_size_t - the number of bytes reclaimed
+ */
+tsch_size_t tausch_iter_compact( tausch_iter_t *iter )
+{
+    tsch_size_t lpos[TAUSCH_COMPACT_DEPTH];   // new offsets of the length fields of sized scopes
+    tsch_size_t lwidth[TAUSCH_COMPACT_DEPTH];   // widths of the length fields
+    uint16_t lscope[TAUSCH_COMPACT_DEPTH];   // depth of the sized scopes
+    uint16_t nsized = 0;
+    uint16_t depth = 0;
+    tsch_size_t src = 0;   // the TLV to move
+    tsch_size_t dst = 0;   // where to move it
+    uint8_t *buf = iter->buf;
+
+    if( (buf == NULL) || (iter->ebuf == 0) ) return 0;
+    tausch_iter_t ti = TAUSCH_ITER_INIT( buf, iter->ebuf );
+    tausch_iter_reset( iter );
+
+    for( ;; )
+    {
+        ti.idx = ti.next = ti.val = src;
+        tsch_size_t txlc = tausch_iter_decode_vluint( &ti );
+        if( !tausch_iter_is_ok( &ti ) ) break;
+        uint8_t lc = txlc & 3;
+        tsch_size_t tag = txlc >> 2;
+        tsch_size_t lenpos = ti.next;
+        tsch_size_t end = ti.next;   // end of the TLV or of the sized scope header
+        tsch_size_t len = 0;
+        if( (lc == 2) || ( (lc == 3) && (tag > 1) ) )
+        {
+            len = tausch_iter_decode_vluint( &ti );
+            if( !tausch_iter_is_ok( &ti ) ) break;
+            if( ( (ti.next + len) < ti.next) || ( (ti.next + len) > ti.ebuf) ) break;
+            end = ti.next;
+            if( lc == 2 ) end += len;
+        }
+
+        if( (tag == 0) && ( (lc & 1) == 0) )
+        {
+            // the stuffing is dropped
+            src = end;
+            continue;
+        }
+        if( (lc == 3) && (tag == 1) )
+        {
+            // the EOF
+            tausch_format_buf( &buf[dst] );
+            if( iter->eof != NULL ) *iter->eof = dst;
+            if( iter->holes != NULL ) iter->holes->count = 0;   // there is no stuffing left
+            return src - dst;
+        }
+        if( (lc == 3) && (tag > 1) && (nsized >= TAUSCH_COMPACT_DEPTH) )
+        {
+            // too deep sized scope is moved as it is
+            end += len;
+        }
+        else if( (lc == 3) && (tag > 1) )
+        {
+            // sized scope, the length is patched at its END
+            depth += 1;
+            lpos[nsized] = dst + lenpos - src;
+            lwidth[nsized] = end - lenpos;
+            lscope[nsized] = depth;
+            nsized += 1;
+        }
+        else if( lc == 1 )
+        {
+            depth += 1;
+        }
+        else if( lc == 3 )
+        {
+            if( depth == 0 ) break;   // END at root scope is not allowed
+            if( (nsized > 0) && (lscope[nsized - 1] == depth) )
+            {
+                nsized -= 1;
+                tsch_size_t content = lpos[nsized] + lwidth[nsized];
+                tausch_vluint_write( &buf[lpos[nsized]], dst + (end - src) - content, lwidth[nsized] );
+            }
+            depth -= 1;
+        }
+
+        if( dst != src ) memmove( &buf[dst], &buf[src], end - src );
+        dst += end - src;
+        src = end;
     }
-    return tausch_iter_write_stuffing( iter, iter->next - iter->idx );
+    iter->ebuf = 0;   // the message was broken
+    return 0;
 }
 
 /**
@@ -841,7 +1372,7 @@ bool tausch_iter_write_end( tausch_iter_t *iter )
  * @return true if the read was successful
  * @return false if the read was unsuccessful
  */
-bool tausch_iter_read_bool( tausch_iter_t *iter, bool *value )
+bool tausch_iter_read_bool( const tausch_iter_t *iter, bool *value )
 {
     if( !tausch_iter_is_ok( iter ) ) return false;
     if( !tausch_iter_is_complete( iter ) ) return false;
@@ -895,12 +1426,12 @@ bool tausch_iter_write_bool( tausch_iter_t *iter, tsch_size_t tag, bool *value )
  * @return 0 on failure
  * @return number of bytes read out
  */
-tsch_size_t tausch_iter_read_typX( tausch_iter_t *iter, uint8_t *value, tsch_size_t len )
+tsch_size_t tausch_iter_read_typX( const tausch_iter_t *iter, uint8_t *value, tsch_size_t len )
 {
     if( !tausch_iter_is_ok( iter ) ) return 0;
     if( value == NULL ) return 0;
     if( iter->vlen != len ) return 0;
-    memcpy( (void*)value, (void*)&iter->buf[iter->val], len );
+    memcpy( (void*)value, (const void*)&iter->buf[iter->val], len );
     return len;
 }
 
@@ -916,17 +1447,39 @@ tsch_size_t tausch_iter_read_typX( tausch_iter_t *iter, uint8_t *value, tsch_siz
  * @return 0 on failure
  * @return number of bytes read out
  */
-tsch_size_t tausch_iter_read_blob( tausch_iter_t *iter, tausch_blob_t *value )
+tsch_size_t tausch_iter_read_blob( const tausch_iter_t *iter, tausch_blob_t *value )
 {
     if( !tausch_iter_is_ok( iter ) ) return 0;
     if( value == NULL ) return 0;
     if( iter->vlen > value->len ) return 0;
 
-    memcpy( (void*)value->buf, (void*)&iter->buf[iter->val], iter->vlen );
+    memcpy( (void*)value->buf, (const void*)&iter->buf[iter->val], iter->vlen );
     memset( value->buf + iter->vlen, 0, value->len - iter->vlen );
     return iter->vlen;
 }
 
+/**
+ * Produce the view of the iterator value field without copying it. Null items
+ * and booleans do give empty view.
+ *
+ * @arg iter - the iterator
+ * @arg view - the view to fill in
+ *
+ * @return true on success
+ * @return false if the iterator is not on item, view is emptied
+ */
+bool tausch_iter_view( const tausch_iter_t *iter, tausch_view_t *view )
+{
+    view->buf = NULL;
+    view->len = 0;
+    if( !tausch_iter_is_ok( iter ) ) return false;
+    if( (iter->tag == 0) || tausch_iter_is_scope( iter ) || tausch_iter_is_end( iter ) ) return false;
+
+    view->buf = &iter->buf[iter->val];
+    view->len = iter->vlen;
+    return true;
+}
+
 
 /**
  * Write to the location of iterator any finite value. When the iter already
@@ -966,7 +1519,7 @@ tsch_size_t tausch_iter_write_typX( tausch_iter_t *iter, tsch_size_t tag, uint8_
                 {
                     // turn back the area to iter
                     *iter = tm;
-                    tausch_iter_erase( iter );
+                    tausch_iter_erase_item( iter );
                     return 0;
                 }
                 return rv;
@@ -977,7 +1530,7 @@ tsch_size_t tausch_iter_write_typX( tausch_iter_t *iter, tsch_size_t tag, uint8_
             {
                 // it is tag only boolean. value true
                 if( *value ) return true;   // overwriting with same data
-                return tausch_iter_erase( iter );   // turn the item into stuffing
+                return tausch_iter_erase_item( iter );   // turn the item into stuffing
             }
             // it is existing full tlv item with matching tag, overwrite also len must match
             return (tausch_iter_overwrite( iter, tag, value, len, true ) > 0 ? iter->vlen : 0);
@@ -1022,7 +1575,7 @@ tsch_size_t tausch_iter_write_blob( tausch_iter_t *iter, tsch_size_t tag, tausch
             {
                 // turn back the area to iter
                 *iter = tm;
-                tausch_iter_erase( iter );
+                tausch_iter_erase_item( iter );
                 return 0;
             }
             return iter->vlen;
@@ -1063,7 +1616,7 @@ tsch_size_t tausch_iter_write_utf8( tausch_iter_t *iter, tsch_size_t tag, char *
 /**
  * Get the length of the TLV value field
  */
-tsch_size_t tausch_iter_vlen( tausch_iter_t *iter )
+tsch_size_t tausch_iter_vlen( const tausch_iter_t *iter )
 {
     if( !tausch_iter_is_ok( iter ) ) return 0;
     if( iter->val == TSCH_NOTHING ) return 0;
@@ -1074,6 +1627,93 @@ tsch_size_t tausch_iter_vlen( tausch_iter_t *iter )
     return 0;
 }
 
+/**
+ * Run-time initiation of the read only iterator
+ *
+ * @arg ci : tausch_citer_t* - pointer to the iterator to initialize
+ * @arg buf : const uint8_t* - pointer to the buffer
+ * @arg size : size_t - amount of data in the buffer
+ * @return tausch_citer_t* - pointer to the ci
+ */
+tausch_citer_t* tausch_citer_init( tausch_citer_t *ci, const uint8_t *buf, tsch_size_t size )
+{
+    // the only place where the const is dropped, none of the citer methods write
+    (void)tausch_iter_init( &ci->iter, (uint8_t*)buf, size );
+    return ci;
+}
+
+/**
+ * Reset the read only iterator to the beginning, keep ref to buffer.
+ *
+ * @arg ci : tausch_citer_t* - the iterator to be reset
+ * @return tausch_citer_t*
+ */
+tausch_citer_t* tausch_citer_reset( tausch_citer_t *ci )
+{
+    (void)tausch_iter_reset( &ci->iter );
+    return ci;
+}
+
+/**
+ * Advance the read only iterator to the next element.
+ *
+ * @see tausch_iter_next
+ */
+bool tausch_citer_next( tausch_citer_t *ci )
+{
+    return tausch_iter_next( &ci->iter );
+}
+
+/**
+ * Enter the read only iterator into subscope.
+ *
+ * @see tausch_iter_enter_scope
+ */
+bool tausch_citer_enter_scope( tausch_citer_t *ci )
+{
+    return tausch_iter_enter_scope( &ci->iter );
+}
+
+/**
+ * Exit the read only iterator from current scope.
+ *
+ * @see tausch_iter_exit_scope
+ */
+bool tausch_citer_exit_scope( tausch_citer_t *ci )
+{
+    return tausch_iter_exit_scope( &ci->iter );
+}
+
+/**
+ * Advance the read only iterator to the next tag in the scope.
+ *
+ * @see tausch_iter_go_to_tag
+ */
+bool tausch_citer_go_to_tag( tausch_citer_t *ci, tsch_size_t tag )
+{
+    return tausch_iter_go_to_tag( &ci->iter, tag );
+}
+
+/**
+ * Advance the read only iterator to the EOF.
+ *
+ * @see tausch_iter_go_eof
+ */
+bool tausch_citer_go_eof( tausch_citer_t *ci )
+{
+    return tausch_iter_go_eof( &ci->iter );
+}
+
+/**
+ * Decode the VLUINT at the iterator location and advance over it.
+ *
+ * @see tausch_iter_decode_vluint
+ */
+tsch_size_t tausch_citer_decode_vluint( tausch_citer_t *ci )
+{
+    return tausch_iter_decode_vluint( &ci->iter );
+}
+
 /**
  * Produce result blob that references only slice of orig blob.
  *
@@ -42,7 +42,22 @@
 #define tsch_size_t uint8_t
 #endif
 
-#define TSCH_NOTHING (~(tsch_size_t)0)
+#define TSCH_NOTHING ((tsch_size_t)~(tsch_size_t)0)
+
+/**
+ * Maximal depth of sized scopes that tausch_iter_compact() does compact inside.
+ */
+#ifndef TAUSCH_COMPACT_DEPTH
+#define TAUSCH_COMPACT_DEPTH 16
+#endif
+
+/**
+ * Depth of the scopes whose openers the iterator remembers for the hole index, the stuffing
+ * in deeper scopes is not looked up nor added.
+ */
+#ifndef TAUSCH_OPEN_DEPTH
+#define TAUSCH_OPEN_DEPTH 8
+#endif
 
 /**
  * Blob structure that holds the size of memroy available and how many bytes is used in.
@@ -95,6 +110,18 @@ typedef struct
  */
 tausch_blob_t* tausch_blob_slice( tausch_blob_t *result, tausch_blob_t *orig, tsch_size_t offset, tsch_size_t len );
 
+/**
+ * Read only reference to the value in the message buffer. It is valid as long as
+ * the message buffer is and the value is not overwritten.
+ */
+typedef struct
+{
+    /// Pointer to the value in message
+    const uint8_t *buf;
+    /// length of the value in bytes
+    tsch_size_t len;
+} tausch_view_t;
+
 
 /**
  * Runtime formatting of the buffer.
@@ -105,6 +132,52 @@ tausch_blob_t* tausch_blob_slice( tausch_blob_t *result, tausch_blob_t *orig, ts
  */
 void tausch_format_buf( uint8_t *buf );
 
+/**
+ * Stuffing region of the message, the entry of the hole index.
+ */
+typedef struct
+{
+    /// Start of the stuffing
+    tsch_size_t idx;
+
+    /// Length of the stuffing in bytes
+    tsch_size_t len;
+
+    /// Offset of the opener of the scope the stuffing is in, TSCH_NOTHING at root scope
+    tsch_size_t open;
+
+    /// The scope depth of the stuffing
+    uint16_t scope;
+
+} tausch_hole_t;
+
+/**
+ * Side index of the stuffing regions of the message, the memory of entries is provided
+ * by the caller. Holes that do not fit into entries are not indexed.
+ */
+typedef struct
+{
+    /// Caller provided entries
+    tausch_hole_t *hole;
+
+    /// Number of entries available
+    tsch_size_t size;
+
+    /// Number of entries used
+    tsch_size_t count;
+
+} tausch_holes_t;
+
+/**
+ * Compile time creation of the hole index. It does reserve memory in stack or globals.
+ *
+ * @arg name - the name of the hole index variable
+ * @arg entries - maximal number of holes the index can hold
+ */
+#define TAUSCH_HOLES_NEW( name, entries )\
+    tausch_hole_t name ## _entries[ entries ];\
+    tausch_holes_t name = { .hole = name ## _entries, .size = (entries), .count = 0 }
+
 typedef struct
 {
     /// Pointer to the buffer start, if sbuf == NULL, then the iter is invalid.
@@ -130,18 +203,38 @@ typedef struct
     /// Tag value of the item.
     tsch_size_t tag;
 
-    /// Length of the value part.
+    /// Length of the value part, for sized scope the length of the scope content.
     tsch_size_t vlen;
 
     /// The scope depth of the structure.
     uint16_t scope;
 
+    /// Offsets of the openers of the scopes entered, recorded by tausch_iter_enter_scope().
+    /** open[d] is the opener of the scope at depth d + 1, the hole index uses it as the key
+     * of scope. tausch_iter_exit_scope() returns to the opener of the outer scope.
+     */
+    tsch_size_t open[TAUSCH_OPEN_DEPTH];
+
+    /// Number of the depths with the opener known in open.
+    uint16_t nopen;
+
     /// The l and c bits of the tag,
     /**  if lc == 4 then
      * the iterator points to end of buffer.
      */
     uint8_t lc;
 
+    /// Optional tracker of the EOF offset, shared by all copies of the iterator.
+    /** NULL when not tracked, the tracker value TSCH_NOTHING when not known.
+     * All the writes through the iterator keep the tracker up to date.
+     */
+    tsch_size_t *eof;
+
+    /// Optional index of the stuffing, shared by all copies of the iterator.
+    /** NULL when not used. Erase and overwrite keep it up to date.
+     */
+    tausch_holes_t *holes;
+
 } tausch_iter_t;
 
 /**
@@ -171,7 +264,10 @@ tausch_iter_t* tausch_iter_init( tausch_iter_t *iter, uint8_t *buf, tsch_size_t
 	.tag = TSCH_NOTHING, \
 	.vlen = 0, \
 	.scope = 0, \
-	.lc = 0 \
+	.nopen = 0, \
+	.lc = 0, \
+	.eof = NULL, \
+	.holes = NULL \
 }
 
 /**
@@ -225,7 +321,7 @@ tausch_iter_t* tausch_iter_reset( tausch_iter_t *iter )
  * @arg iter : tausch_iter_t* - pointer to the iterator
  * @return true if it is byte of EOF
  */
-bool tausch_iter_is_eof( tausch_iter_t *iter )
+bool tausch_iter_is_eof( const tausch_iter_t *iter )
 ;
 
 /**
@@ -234,7 +330,7 @@ bool tausch_iter_is_eof( tausch_iter_t *iter )
  * @arg iter : tausch_iter_t* - pointer to the iterator
  * @return true if it is byte of EOS or EOF
  */
-bool tausch_iter_is_end( tausch_iter_t *iter )
+bool tausch_iter_is_end( const tausch_iter_t *iter )
 ;
 
 /**
@@ -251,7 +347,7 @@ tausch_iter_t* tausch_iter_format( tausch_iter_t *iter )
  *
  * @arg iter : tausch_iter_t* - the iterator to verify
  */
-bool tausch_iter_is_ok( tausch_iter_t *iter )
+bool tausch_iter_is_ok( const tausch_iter_t *iter )
 ;
 
 /**
@@ -259,13 +355,13 @@ bool tausch_iter_is_ok( tausch_iter_t *iter )
  *
  * @return true if all the elements of TLV have been parsed
  */
-bool tausch_iter_is_complete( tausch_iter_t *iter )
+bool tausch_iter_is_complete( const tausch_iter_t *iter )
 ;
 
 /**
  * @return true if the value is null
  */
-bool tausch_iter_is_null( tausch_iter_t *iter )
+bool tausch_iter_is_null( const tausch_iter_t *iter )
 ;
 
 /**
@@ -273,13 +369,13 @@ bool tausch_iter_is_null( tausch_iter_t *iter )
  *
  * @return true if the iterator is clean for write
  */
-bool tausch_iter_is_clean( tausch_iter_t *iter )
+bool tausch_iter_is_clean( const tausch_iter_t *iter )
 ;
 
 /**
  * @return size of the stuffing when the iter is stuffing, otherwise 0
  */
-tsch_size_t tausch_iter_is_stuffing( tausch_iter_t *iter )
+tsch_size_t tausch_iter_is_stuffing( const tausch_iter_t *iter )
 ;
 
 /**
@@ -288,7 +384,47 @@ tsch_size_t tausch_iter_is_stuffing( tausch_iter_t *iter )
  * @param iter : tausch_iter_t*
  * @return bool
  */
-bool tausch_iter_is_scope( tausch_iter_t *iter )
+bool tausch_iter_is_scope( const tausch_iter_t *iter )
+;
+
+/**
+ * Return if the iterator is at start of sized scope, the scope that carries its length.
+ * The vlen is then the length of the scope content including its END.
+ *
+ * @param iter : tausch_iter_t*
+ * @return bool
+ */
+bool tausch_iter_is_sized( const tausch_iter_t *iter )
+;
+
+/**
+ * Attach the EOF tracker to the iterator. The EOF is searched on first use of the tracker.
+ * When the message is modified not through the iterator, then attach the tracker again.
+ *
+ * @param iter : tausch_iter_t* - the iterator
+ * @param eof : tsch_size_t* - memory of the tracker, NULL to detach
+ * @return tausch_iter_t* - the iter
+ */
+tausch_iter_t* tausch_iter_track( tausch_iter_t *iter, tsch_size_t *eof )
+;
+
+/**
+ * Return the offset of EOF. It is taken from the tracker when available,
+ * otherwise the message is walked from the iterator position to EOF.
+ *
+ * @param iter : tausch_iter_t*
+ * @return tsch_size_t - the offset of EOF or TSCH_NOTHING when the message is broken
+ */
+tsch_size_t tausch_iter_eof( tausch_iter_t *iter )
+;
+
+/**
+ * Position the iterator onto EOF at root scope, as if tausch_iter_next() had stopped there.
+ *
+ * @param iter : tausch_iter_t*
+ * @return bool - false when EOF was not found
+ */
+bool tausch_iter_go_eof( tausch_iter_t *iter )
 ;
 
 /**
@@ -305,8 +441,8 @@ tsch_size_t tausch_iter_buff_free( tausch_iter_t *iter )
  *
  * @arg iter - the iterator from where to read
  *
- * @return the decoded tag value, or ~0 (all bits set) on failure
- *
+ * @return the decoded tag value, or ~0 (all bits set) on failure. The iterator becomes
+ *         invalid when the buffer ends or the value does not fit into tsch_size_t.
  */
 tsch_size_t tausch_iter_decode_vluint( tausch_iter_t *iter )
 ;
@@ -333,6 +469,17 @@ bool tausch_iter_encode_vluint( tausch_iter_t *iter, tsch_size_t val )
 tsch_size_t tausch_vluint_len( tsch_size_t val )
 ;
 
+/**
+ * Encode the vluint into exactly width bytes, it is padded with 0x80 bytes when the
+ * value takes less. The value must fit into width bytes.
+ *
+ * @arg buf - where to write
+ * @arg val - the value to encode
+ * @arg width - number of bytes to write
+ */
+void tausch_vluint_write( uint8_t *buf, tsch_size_t val, tsch_size_t width )
+;
+
 /**
  * Decodes from binary buffer next TLV item and stores info inside iter element.
  * It does not skip over stuffing. It stays onto the current scope and jumps
@@ -377,6 +524,52 @@ bool tausch_iter_exit_scope( tausch_iter_t *iter )
 bool tausch_iter_go_to_stuffing( tausch_iter_t *iter )
 ;
 
+/**
+ * Attach the hole index to the iterator and build it from the message. The
+ * message is walked once.
+ *
+ * @param iter : tausch_iter_t* - the iterator
+ * @param holes : tausch_holes_t* - the hole index, NULL to detach
+ * @return tausch_iter_t* - the iter
+ */
+tausch_iter_t* tausch_iter_holes( tausch_iter_t *iter, tausch_holes_t *holes )
+;
+
+/**
+ * Advance the iterator to the smallest stuffing in its scope that can hold len bytes.
+ * The stuffing is looked up from the hole index attached to the iterator, the entries that
+ * are not stuffing anymore are dropped. Inside the scope the iterator must know the opener
+ * of the scope, it is recorded when entering the scope and kept over the subscopes, up to
+ * the depth TAUSCH_OPEN_DEPTH.
+ *
+ * @param iter : tausch_iter_t* - the iterator with hole index
+ * @param len : tsch_size_t - number of bytes needed, see tausch_tlv_size()
+ * @return bool - true when the iterator was moved onto the stuffing
+ */
+bool tausch_iter_go_to_hole( tausch_iter_t *iter, tsch_size_t len )
+;
+
+/**
+ * Add the stuffing the iterator is on into the hole index attached to it. The entries
+ * inside the stuffing are removed, also the ones of erased subscopes, and the overlapping
+ * entries of the same scope. The stuffing is not indexed when the opener of its scope is not
+ * known to the iterator or to the adjacent stuffing, or when the index is full.
+ *
+ * @param iter : tausch_iter_t* - the iterator on the stuffing
+ */
+void tausch_holes_add( tausch_iter_t *iter )
+;
+
+/**
+ * Remove the entries of the hole index that overlap the region, the region was written over.
+ *
+ * @param holes : tausch_holes_t* - the hole index
+ * @param from : tsch_size_t - start of the region
+ * @param to : tsch_size_t - end of the region, not included
+ */
+void tausch_holes_cut( tausch_holes_t *holes, tsch_size_t from, tsch_size_t to )
+;
+
 /**
  * Advance the iterator to the next tag in the scope.
  *
@@ -436,6 +629,21 @@ bool tausch_iter_write_stuffing( tausch_iter_t *iter, tsch_size_t len )
 bool tausch_iter_erase( tausch_iter_t *iter )
 ;
 
+/**
+ * Compact the message, all the stuffing is removed. The TLV following stuffing are
+ * moved to the left and the EOF is moved to the new end. The lengths of the sized
+ * scopes are updated, sized scopes deeper than TAUSCH_COMPACT_DEPTH are moved without
+ * compacting their content.
+ *
+ * It is done in single pass over the message, the iterator is reset to the beginning
+ * of the message. On failure the iterator is broken, the message may be too.
+ *
+ * @param iter : tausch_iter_t* - iterator of the message
+ * @return tsch_size_t - the number of bytes reclaimed
+ */
+tsch_size_t tausch_iter_compact( tausch_iter_t *iter )
+;
+
 /**
  * Open new scope on the binary stream. Scopes are COLLECTION or VARIADIC
  *
@@ -465,7 +673,7 @@ bool tausch_iter_write_end( tausch_iter_t *iter )
  * @return true if the read was successful
  * @return false if the read was unsuccessful
  */
-bool tausch_iter_read_bool( tausch_iter_t *iter, bool *value )
+bool tausch_iter_read_bool( const tausch_iter_t *iter, bool *value )
 ;
 
 /**
@@ -493,7 +701,7 @@ bool tausch_iter_write_bool( tausch_iter_t *iter, tsch_size_t tag, bool *value )
  * @return 0 on failure
  * @return number of bytes read out
  */
-tsch_size_t tausch_iter_read_typX( tausch_iter_t *iter, uint8_t *value, tsch_size_t len )
+tsch_size_t tausch_iter_read_typX( const tausch_iter_t *iter, uint8_t *value, tsch_size_t len )
 ;
 
 /**
@@ -508,7 +716,20 @@ tsch_size_t tausch_iter_read_typX( tausch_iter_t *iter, uint8_t *value, tsch_siz
  * @return 0 on failure
  * @return number of bytes read out
  */
-tsch_size_t tausch_iter_read_blob( tausch_iter_t *iter, tausch_blob_t *value )
+tsch_size_t tausch_iter_read_blob( const tausch_iter_t *iter, tausch_blob_t *value )
+;
+
+/**
+ * Produce the view of the iterator value field without copying it. Null items
+ * and booleans do give empty view.
+ *
+ * @arg iter - the iterator
+ * @arg view - the view to fill in
+ *
+ * @return true on success
+ * @return false if the iterator is not on item, view is emptied
+ */
+bool tausch_iter_view( const tausch_iter_t *iter, tausch_view_t *view )
 ;
 
 /**
@@ -559,7 +780,123 @@ tsch_size_t tausch_iter_write_utf8( tausch_iter_t *iter, tsch_size_t tag, char *
 /**
  * Get the length of the TLV value field
  */
-tsch_size_t tausch_iter_vlen( tausch_iter_t *iter );
+tsch_size_t tausch_iter_vlen( const tausch_iter_t *iter );
+
+/**
+ * Read only iterator. It is walking the message the same way as the tausch_iter_t,
+ * but it does only have methods that never write into the message buffer. The buffer
+ * can be const ROM, a page mapped PROT_READ or a buffer shared by many threads, each
+ * thread having its own citer.
+ *
+ * The queries and reads of tausch_iter_t take const iterator and are used with
+ * tausch_citer_get().
+ */
+typedef struct
+{
+    /// The iterator, the codec never writes through it
+    tausch_iter_t iter;
+} tausch_citer_t;
+
+/**
+ * Compile-time initiation of the read only iterator
+ *
+ * @arg buf : const uint8_t* - pointer to the buffer
+ * @arg size : size_t - amount of data in the buffer
+ */
+#define TAUSCH_CITER_INIT( buffer, size ) { .iter = TAUSCH_ITER_INIT( (buffer), (size) ) }
+
+/**
+ * Run-time initiation of the read only iterator
+ *
+ * @arg ci : tausch_citer_t* - pointer to the iterator to initialize
+ * @arg buf : const uint8_t* - pointer to the buffer
+ * @arg size : size_t - amount of data in the buffer
+ * @return tausch_citer_t* - pointer to the ci
+ */
+tausch_citer_t* tausch_citer_init( tausch_citer_t *ci, const uint8_t *buf, tsch_size_t size )
+;
+
+/**
+ * Get the const iterator for the queries and reads.
+ *
+ * @arg ci : tausch_citer_t* - the read only iterator
+ * @return const tausch_iter_t*
+ *
+ * @example
+ * if( tausch_iter_is_scope( tausch_citer_get( &ci ) ) ) ...
+ */
+#define tausch_citer_get( ci ) ((const tausch_iter_t*)&(ci)->iter)
+
+/**
+ * Reset the read only iterator to the beginning, keep ref to buffer.
+ *
+ * @arg ci : tausch_citer_t* - the iterator to be reset
+ * @return tausch_citer_t*
+ */
+tausch_citer_t* tausch_citer_reset( tausch_citer_t *ci )
+;
+
+/**
+ * Advance the read only iterator to the next element.
+ *
+ * @see tausch_iter_next
+ */
+bool tausch_citer_next( tausch_citer_t *ci )
+;
+
+/**
+ * Enter the read only iterator into subscope.
+ *
+ * @see tausch_iter_enter_scope
+ */
+bool tausch_citer_enter_scope( tausch_citer_t *ci )
+;
+
+/**
+ * Exit the read only iterator from current scope.
+ *
+ * @see tausch_iter_exit_scope
+ */
+bool tausch_citer_exit_scope( tausch_citer_t *ci )
+;
+
+/**
+ * Advance the read only iterator to the next tag in the scope.
+ *
+ * @see tausch_iter_go_to_tag
+ */
+bool tausch_citer_go_to_tag( tausch_citer_t *ci, tsch_size_t tag )
+;
+
+/**
+ * Advance the read only iterator to the EOF.
+ *
+ * @see tausch_iter_go_eof
+ */
+bool tausch_citer_go_eof( tausch_citer_t *ci )
+;
+
+/**
+ * Decode the VLUINT at the iterator location and advance over it.
+ *
+ * @see tausch_iter_decode_vluint
+ */
+tsch_size_t tausch_citer_decode_vluint( tausch_citer_t *ci )
+;
+
+/**
+ * Copy the value from the message into the variable.
+ *
+ * @see tausch_iter_read
+ */
+#define tausch_citer_read( ci, value ) tausch_iter_read( tausch_citer_get( ci ), (value) )
+
+/**
+ * Produce view of the BLOB or UTF8 value.
+ *
+ * @see tausch_iter_view
+ */
+#define tausch_citer_view( ci, view ) tausch_iter_view( tausch_citer_get( ci ), (view) )
 
 /**
  * Function that shall never be implemented => linking must fail
@@ -0,0 +1,144 @@
+/*
+ * tauschema_file.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Map the file for reading.
+ *
+ * @param file : tausch_file_t* - the reader
+ * @param path : char* - path of the file
+ * @return bool - false when the file can not be mapped
+ */
+bool tausch_file_open( tausch_file_t *file, const char *path )
+{
+    struct stat st;
+    file->map = NULL;
+    file->size = 0;
+    file->msg = 0;
+    file->next = 0;
+    file->ahead = 0;
+
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 ) return false;
+    if( (fstat( fd, &st ) != 0) || (st.st_size <= 0) || ((uint64_t)st.st_size > (uint64_t)SIZE_MAX) )
+    {
+        close( fd );
+        return false;
+    }
+    void *map = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );   // the mapping keeps the file open
+    if( map == MAP_FAILED ) return false;
+
+    // the messages are read from the front to the back
+    (void)madvise( map, (size_t)st.st_size, MADV_SEQUENTIAL );
+    file->map = map;
+    file->size = (uint64_t)st.st_size;
+    return true;
+}
+
+/**
+ * Unmap the file.
+ *
+ * @param file : tausch_file_t* - the reader
+ */
+void tausch_file_close( tausch_file_t *file )
+{
+    if( file->map != NULL ) (void)munmap( (void*)file->map, (size_t)file->size );
+    file->map = NULL;
+    file->size = 0;
+}
+
+/**
+ * Ask the kernel to read in the pages ahead of the offset.
+ */
+static void tausch_file_read_ahead( tausch_file_t *file, uint64_t offset )
+{
+    if( (file->ahead > offset) && ((file->ahead - offset) > (TAUSCH_FILE_READAHEAD / 2)) ) return;
+    uint64_t page = (uint64_t)sysconf( _SC_PAGESIZE );
+    uint64_t from = offset > file->ahead ? offset : file->ahead;
+    from -= from % page;
+    uint64_t to = offset + TAUSCH_FILE_READAHEAD;
+    to = to < file->size ? to : file->size;
+    if( to <= from ) return;
+    (void)madvise( (void*)(file->map + from), (size_t)(to - from), MADV_WILLNEED );
+    file->ahead = to;
+}
+
+/**
+ * Produce the iterator over the next message of file, it is at the beginning
+ * of the message.
+ *
+ * @param file : tausch_file_t* - the reader
+ * @param iter : tausch_iter_t* - the iterator to initialize
+ * @return bool - false at the end of file or when the message is broken or too big
+ */
+bool tausch_file_next( tausch_file_t *file, tausch_iter_t *iter )
+{
+    if( (file->map == NULL) || (file->next >= file->size) ) return false;
+    tausch_file_read_ahead( file, file->next );
+
+    // the message must fit into tsch_size_t, TSCH_NOTHING is reserved
+    uint64_t len = file->size - file->next;
+    if( len >= (uint64_t)TSCH_NOTHING ) len = (uint64_t)TSCH_NOTHING - 1;
+
+    // the iterator does not write when it is only reading
+    tausch_iter_init( iter, (uint8_t*)&file->map[file->next], (tsch_size_t)len );
+    tausch_iter_t it = *iter;
+    if( !tausch_iter_go_eof( &it ) )
+    {
+        iter->ebuf = 0;
+        return false;
+    }
+    iter->ebuf = it.idx + 1;
+    file->msg = file->next;
+    file->next += it.idx + 1;
+    return true;
+}
+
+/**
+ * Continue reading the messages from the offset, for example one stored from file->msg earlier.
+ *
+ * @param file : tausch_file_t* - the reader
+ * @param offset : uint64_t - offset of the message in file
+ * @return bool - false when the offset is out of file
+ */
+bool tausch_file_seek( tausch_file_t *file, uint64_t offset )
+{
+    if( offset >= file->size ) return false;
+    file->next = offset;
+    file->ahead = 0;
+    return true;
+}
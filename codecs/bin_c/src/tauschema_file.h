@@ -0,0 +1,109 @@
+/*
+ * tauschema_file.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_FILE_H_
+#define SRC_TAUSCHEMA_FILE_H_
+
+#include "tauschema_codec.h"
+
+/**
+ * Number of bytes ahead of the current message the kernel is asked to read in.
+ */
+#ifndef TAUSCH_FILE_READAHEAD
+#define TAUSCH_FILE_READAHEAD (4ul << 20)
+#endif
+
+/**
+ * Reader of the file of messages that follow each other, every one terminated with EOF.
+ * The file is mapped read only into memory and the messages are iterated in place, the
+ * file can be bigger than tsch_size_t, only a single message must fit into it. Needs POSIX.
+ *
+ * The iterators produced are over read only memory, writing with them does fault.
+ */
+typedef struct
+{
+    /// The mapping of the file, NULL when nothing is mapped
+    const uint8_t *map;
+
+    /// Size of the file
+    uint64_t size;
+
+    /// Offset of the current message
+    uint64_t msg;
+
+    /// Offset of the next message
+    uint64_t next;
+
+    /// Offset up to which the read ahead has been asked for
+    uint64_t ahead;
+
+} tausch_file_t;
+
+/**
+ * Map the file for reading.
+ *
+ * @param file : tausch_file_t* - the reader
+ * @param path : char* - path of the file
+ * @return bool - false when the file can not be mapped
+ */
+bool tausch_file_open( tausch_file_t *file, const char *path )
+;
+
+/**
+ * Unmap the file.
+ *
+ * @param file : tausch_file_t* - the reader
+ */
+void tausch_file_close( tausch_file_t *file )
+;
+
+/**
+ * Produce the iterator over the next message of file, it is at the beginning
+ * of the message.
+ *
+ * @param file : tausch_file_t* - the reader
+ * @param iter : tausch_iter_t* - the iterator to initialize
+ * @return bool - false at the end of file or when the message is broken or too big
+ */
+bool tausch_file_next( tausch_file_t *file, tausch_iter_t *iter )
+;
+
+/**
+ * Continue reading the messages from the offset, for example one stored from file->msg earlier.
+ *
+ * @param file : tausch_file_t* - the reader
+ * @param offset : uint64_t - offset of the message in file
+ * @return bool - false when the offset is out of file
+ */
+bool tausch_file_seek( tausch_file_t *file, uint64_t offset )
+;
+
+#endif /* SRC_TAUSCHEMA_FILE_H_ */
@@ -0,0 +1,322 @@
+/*
+ * tauschema_index.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_index.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Bitmap of bytes that terminate the vluint, the bytes without continuation bit.
+ * Bit 0 is for the first byte of the block.
+ *
+ * @param buf : uint8_t* - the message
+ * @param start : tsch_size_t - start of the block
+ * @param end : tsch_size_t - end of the message
+ * @return uint64_t - the bitmap of at most 64 bytes
+ */
+static uint64_t tausch_index_stops( const uint8_t *buf, tsch_size_t start, tsch_size_t end )
+{
+    uint64_t rv = 0;
+    tsch_size_t n = end - start;
+#if defined(__AVX2__)
+    if( n >= 64 )
+    {
+        __m256i a = _mm256_loadu_si256( (const __m256i*)&buf[start] );
+        __m256i b = _mm256_loadu_si256( (const __m256i*)&buf[start + 32] );
+        rv = (uint32_t)_mm256_movemask_epi8( a );
+        rv |= (uint64_t)(uint32_t)_mm256_movemask_epi8( b ) << 32;
+        return ~rv;
+    }
+#elif defined(__SSE2__)
+    if( n >= 64 )
+    {
+        for( int i = 0; i < 4; i++ )
+        {
+            __m128i a = _mm_loadu_si128( (const __m128i*)&buf[start + 16 * i] );
+            rv |= (uint64_t)(uint16_t)_mm_movemask_epi8( a ) << (16 * i);
+        }
+        return ~rv;
+    }
+#endif
+    if( n > 64 ) n = 64;
+    for( tsch_size_t i = 0; i < n; i++ )
+    {
+        rv |= (uint64_t)(buf[start + i] < 0x80) << i;
+    }
+    return rv;
+}
+
+/**
+ * Decode vluint at the position with help of the terminator bitmap
+ *
+ * @param index : tausch_index_t* - the index
+ * @param pos : tsch_size_t* - the position, advanced over the vluint
+ * @return tsch_size_t - the value or TSCH_NOTHING on failure
+ */
+static tsch_size_t tausch_index_vluint( tausch_index_t *index, tsch_size_t *pos )
+{
+    tsch_size_t p = *pos;
+    if( p >= index->ebuf ) return TSCH_NOTHING;
+    tsch_size_t blk = p >> 6;
+    if( blk != index->blk )
+    {
+        index->stops = tausch_index_stops( index->buf, blk << 6, index->ebuf );
+        index->blk = blk;
+    }
+    uint64_t s = index->stops >> (p & 63);
+    unsigned len = s ? __builtin_ctzll( s ) + 1 : 0;
+    if( (len == 0) || (len > 9) )
+    {
+        // the vluint continues to the next block or is very long
+        tausch_iter_t iter = TAUSCH_ITER_INIT( index->buf, index->ebuf );
+        iter.idx = iter.next = iter.val = p;
+        tsch_size_t rv = tausch_iter_decode_vluint( &iter );
+        if( !tausch_iter_is_ok( &iter ) ) return TSCH_NOTHING;
+        *pos = iter.next;
+        return rv;
+    }
+    uint64_t rv = 0;
+    const uint8_t *b = &index->buf[p];
+    for( unsigned i = 0; i < len; i++ )
+    {
+        rv |= (uint64_t)(b[i] & 0x7f) << (7 * i);
+    }
+    if( rv >= (uint64_t)TSCH_NOTHING ) return TSCH_NOTHING;   // does not fit into tsch_size_t
+    *pos = p + len;
+    return (tsch_size_t)rv;
+}
+
+/**
+ * Build the structural index of the message.
+ *
+ * @param index : tausch_index_t* - the index with entries
+ * @param buf : uint8_t* - the message
+ * @param size : tsch_size_t - size of the message buffer
+ * @return true when the EOF was reached, false when message is broken or entries did not suffice
+ */
+bool tausch_index_build( tausch_index_t *index, uint8_t *buf, tsch_size_t size )
+{
+    tsch_size_t open[TAUSCH_INDEX_DEPTH];   // the scope opener entries
+    tsch_size_t close[TAUSCH_INDEX_DEPTH];   // where the sized scopes end, TSCH_NOTHING for others
+    uint16_t depth = 0;
+    tsch_size_t pos = 0;
+
+    index->buf = buf;
+    index->ebuf = size;
+    index->count = 0;
+    index->blk = TSCH_NOTHING;
+    if( (buf == NULL) || (size == 0) ) return false;
+
+    while( index->count < index->size )
+    {
+        tsch_size_t n = index->count;
+        tausch_index_entry_t *e = &index->entry[n];
+        e->idx = pos;
+        tsch_size_t tag = tausch_index_vluint( index, &pos );
+        if( tag == TSCH_NOTHING ) break;
+        e->lc = tag & 3;
+        e->tag = tag >> 2;
+        e->scope = depth;
+        e->skip = n + 1;
+        e->val = TSCH_NOTHING;
+        index->count = n + 1;
+
+        if( (e->lc == 3) && (e->tag > 1) )
+        {
+            // sized scope opener, the content must end where its length tells
+            tsch_size_t len = tausch_index_vluint( index, &pos );
+            if( (len == TSCH_NOTHING) || (len == 0) ) break;
+            if( ((pos + len) <= pos) || ((pos + len) > size) ) break;   // the buffer overflow
+            if( depth >= TAUSCH_INDEX_DEPTH ) break;
+            e->lc = 1;
+            e->next = pos;
+            close[depth] = pos + len;
+            open[depth++] = n;
+            continue;
+        }
+        if( e->lc == 3 )
+        {
+            // END or EOF stays onto itself
+            e->next = pos;
+            e->skip = n;
+            e->tag = e->tag != 0 ? 1 : 0;
+            if( e->tag != 0 )
+            {
+                // EOF closes also all the scopes open
+                while( depth > 0 ) index->entry[open[--depth]].skip = n;
+                return true;
+            }
+            if( depth == 0 ) break;   // END at root scope is not allowed
+            depth -= 1;
+            if( (close[depth] != TSCH_NOTHING) && (close[depth] != pos) ) break;   // length of scope is wrong
+            index->entry[open[depth]].skip = n + 1;
+            continue;
+        }
+        if( e->lc == 1 )
+        {
+            // scope opener
+            if( depth >= TAUSCH_INDEX_DEPTH ) break;
+            close[depth] = TSCH_NOTHING;
+            open[depth++] = n;
+        }
+        else if( e->lc == 2 )
+        {
+            tsch_size_t len = tausch_index_vluint( index, &pos );
+            if( len == TSCH_NOTHING ) break;
+            if( len > 0 )
+            {
+                if( ((pos + len) <= pos) || ((pos + len) > size) ) break;   // the buffer overflow
+                e->val = pos;
+                pos += len;
+            }
+        }
+        e->next = pos;
+    }
+    return false;
+}
+
+/**
+ * Produce iterator that stays onto the TLV of the entry, as if tausch_iter_next() had stopped there.
+ * The iterator is broken when the entry does not exist.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry
+ * @param iter : tausch_iter_t* - the iterator to fill in
+ * @return tausch_iter_t* - the iter
+ */
+tausch_iter_t* tausch_index_iter( tausch_index_t *index, tsch_size_t n, tausch_iter_t *iter )
+{
+    tausch_iter_t tm = TAUSCH_ITER_INIT( index->buf, index->ebuf );
+    if( n >= index->count )
+    {
+        tm.ebuf = 0;   // the iterator is broken
+    }
+    else
+    {
+        tausch_index_entry_t *e = &index->entry[n];
+        tm.idx = e->idx;
+        tm.next = e->next;
+        tm.val = e->val;
+        tm.tag = e->tag;
+        tm.vlen = e->val == TSCH_NOTHING ? 0 : e->next - e->val;
+        if( (e->lc == 1) && ((index->buf[e->idx] & 3) == 3) && (e->skip > n) )
+        {
+            // sized scope, the content ends with the END entry
+            tm.vlen = index->entry[e->skip - 1].next - e->next;
+        }
+        tm.scope = e->scope;
+        tm.lc = e->lc;
+    }
+    *iter = tm;
+    return iter;
+}
+
+/**
+ * Next entry at the same scope, the subscopes are skipped.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry
+ * @return tsch_size_t - the next entry or TSCH_NOTHING at END, EOF or when entry does not exist
+ */
+tsch_size_t tausch_index_next( tausch_index_t *index, tsch_size_t n )
+{
+    if( n >= index->count ) return TSCH_NOTHING;
+    if( index->entry[n].lc == 3 ) return TSCH_NOTHING;
+    n = index->entry[n].skip;
+    return n < index->count ? n : TSCH_NOTHING;
+}
+
+/**
+ * Find the tag from the scope starting from the entry n.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry to start from, it is also verified
+ * @param tag : tsch_size_t - the tag to look for
+ * @return tsch_size_t - the entry found or TSCH_NOTHING
+ */
+tsch_size_t tausch_index_go_to_tag( tausch_index_t *index, tsch_size_t n, tsch_size_t tag )
+{
+    while( (n < index->count) && (index->entry[n].lc != 3) )
+    {
+        if( index->entry[n].tag == tag ) return n;
+        n = index->entry[n].skip;
+    }
+    return TSCH_NOTHING;
+}
+
+/**
+ * First entry inside the scope.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry of the scope opener
+ * @return tsch_size_t - the first entry in scope or TSCH_NOTHING when n is not scope
+ */
+tsch_size_t tausch_index_enter_scope( tausch_index_t *index, tsch_size_t n )
+{
+    if( n >= index->count ) return TSCH_NOTHING;
+    if( index->entry[n].lc != 1 ) return TSCH_NOTHING;
+    return (n + 1) < index->count ? n + 1 : TSCH_NOTHING;
+}
+
+/**
+ * Exit the scope the entry n is in.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry inside the scope
+ * @return tsch_size_t - entry following the END of scope, the EOF entry when at root
+ *          or TSCH_NOTHING on failure
+ */
+tsch_size_t tausch_index_exit_scope( tausch_index_t *index, tsch_size_t n )
+{
+    while( (n < index->count) && (index->entry[n].lc != 3) )
+    {
+        n = index->entry[n].skip;
+    }
+    if( n >= index->count ) return TSCH_NOTHING;
+    if( index->entry[n].tag != 0 ) return n;   // stay at EOF
+    return (n + 1) < index->count ? n + 1 : TSCH_NOTHING;
+}
+
+/**
+ * Return amount of free space in buffer
+ *
+ * @param index : tausch_index_t* - the index
+ * @return tsch_size_t - number of bytes after EOF
+ */
+tsch_size_t tausch_index_buff_free( tausch_index_t *index )
+{
+    if( index->count == 0 ) return 0;
+    tausch_index_entry_t *e = &index->entry[index->count - 1];
+    if( (e->lc != 3) || (e->tag == 0) ) return 0;   // the EOF was not reached
+    return index->ebuf - e->idx - 1;
+}
@@ -0,0 +1,192 @@
+/*
+ * tauschema_index.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_INDEX_H_
+#define SRC_TAUSCHEMA_INDEX_H_
+
+#include "tauschema_codec.h"
+
+/**
+ * Maximal depth of scopes the index can hold.
+ */
+#ifndef TAUSCH_INDEX_DEPTH
+#define TAUSCH_INDEX_DEPTH 32
+#endif
+
+/**
+ * Structural index entry, one per TLV of the message including stuffing,
+ * END of scope and the EOF. The fields hold the same values the iterator
+ * holds after tausch_iter_next() has stopped onto the TLV.
+ */
+typedef struct
+{
+    /// Start of the TLV
+    tsch_size_t idx;
+
+    /// The value field or TSCH_NOTHING when value is null
+    tsch_size_t val;
+
+    /// Start of the next TLV
+    tsch_size_t next;
+
+    /// Tag value of the item
+    tsch_size_t tag;
+
+    /// Entry of the next TLV at the same scope, for scope openers it is entry after
+    /// the END of the scope. END and EOF do point to themselves.
+    tsch_size_t skip;
+
+    /// The scope depth of the TLV
+    uint16_t scope;
+
+    /// The l and c bits of the tag, 1 also for the sized scope
+    uint8_t lc;
+
+} tausch_index_entry_t;
+
+/**
+ * The structural index of the message. The memory of entries is provided by the caller.
+ *
+ * The index is valid as long as the message is not modified.
+ */
+typedef struct
+{
+    /// Caller provided entries
+    tausch_index_entry_t *entry;
+
+    /// Number of entries available
+    tsch_size_t size;
+
+    /// Number of entries used
+    tsch_size_t count;
+
+    /// The indexed message
+    uint8_t *buf;
+
+    /// Size of the message buffer
+    tsch_size_t ebuf;
+
+    /// Terminator bitmap of the message block being scanned
+    uint64_t stops;
+
+    /// The block of the message the bitmap belongs to
+    tsch_size_t blk;
+
+} tausch_index_t;
+
+/**
+ * Compile time creation of the index. It does reserve memory in stack or globals.
+ *
+ * @arg name - the name of the index variable
+ * @arg entries - maximal number of TLV the index can hold
+ */
+#define TAUSCH_INDEX_NEW( name, entries )\
+    tausch_index_entry_t name ## _entries[ entries ];\
+    tausch_index_t name = { .entry = name ## _entries, .size = (entries), .count = 0 }
+
+/**
+ * Build the structural index of the message.
+ *
+ * The message is scanned once, the bytes terminating the vluints are found with SIMD
+ * for 64 bytes at a time and the TLV are decoded with the bitmap.
+ *
+ * @param index : tausch_index_t* - the index with entries
+ * @param buf : uint8_t* - the message
+ * @param size : tsch_size_t - size of the message buffer
+ * @return true when the EOF was reached, false when message is broken or entries did not suffice
+ */
+bool tausch_index_build( tausch_index_t *index, uint8_t *buf, tsch_size_t size )
+;
+
+/**
+ * Produce iterator that stays onto the TLV of the entry, as if tausch_iter_next() had stopped there.
+ * The iterator is broken when the entry does not exist.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry
+ * @param iter : tausch_iter_t* - the iterator to fill in
+ * @return tausch_iter_t* - the iter
+ */
+tausch_iter_t* tausch_index_iter( tausch_index_t *index, tsch_size_t n, tausch_iter_t *iter )
+;
+
+/**
+ * Next entry at the same scope, the subscopes are skipped.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry
+ * @return tsch_size_t - the next entry or TSCH_NOTHING at END, EOF or when entry does not exist
+ */
+tsch_size_t tausch_index_next( tausch_index_t *index, tsch_size_t n )
+;
+
+/**
+ * Find the tag from the scope starting from the entry n.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry to start from, it is also verified
+ * @param tag : tsch_size_t - the tag to look for
+ * @return tsch_size_t - the entry found or TSCH_NOTHING
+ */
+tsch_size_t tausch_index_go_to_tag( tausch_index_t *index, tsch_size_t n, tsch_size_t tag )
+;
+
+/**
+ * First entry inside the scope.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry of the scope opener
+ * @return tsch_size_t - the first entry in scope or TSCH_NOTHING when n is not scope
+ */
+tsch_size_t tausch_index_enter_scope( tausch_index_t *index, tsch_size_t n )
+;
+
+/**
+ * Exit the scope the entry n is in.
+ *
+ * @param index : tausch_index_t* - the index
+ * @param n : tsch_size_t - the entry inside the scope
+ * @return tsch_size_t - entry following the END of scope, the EOF entry when at root
+ *          or TSCH_NOTHING on failure
+ */
+tsch_size_t tausch_index_exit_scope( tausch_index_t *index, tsch_size_t n )
+;
+
+/**
+ * Return amount of free space in buffer
+ *
+ * @param index : tausch_index_t* - the index
+ * @return tsch_size_t - number of bytes after EOF
+ */
+tsch_size_t tausch_index_buff_free( tausch_index_t *index )
+;
+
+#endif /* SRC_TAUSCHEMA_INDEX_H_ */
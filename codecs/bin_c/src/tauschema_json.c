@@ -0,0 +1,1049 @@
+/*
+ * tauschema_json.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Append the bytes to the output, drain the buffer into the sink when it is full.
+ */
+static void put( tausch_json_t *js, const char *data, size_t len )
+{
+    if( !js->ok ) return;
+    js->total += len;
+    if( js->len + len <= js->size )
+    {
+        memcpy( &js->buf[js->len], data, len );
+        js->len += len;
+        return;
+    }
+    if( js->sink == NULL )
+    {
+        js->ok = false;
+        return;
+    }
+    if( (js->len > 0) && !js->sink( js->ctx, js->buf, js->len ) )
+    {
+        js->ok = false;
+        return;
+    }
+    js->len = 0;
+    if( len > js->size )
+    {
+        js->ok = js->sink( js->ctx, data, len );
+        return;
+    }
+    memcpy( js->buf, data, len );
+    js->len = len;
+}
+
+static void put_char( tausch_json_t *js, char c )
+{
+    if( js->ok && (js->len < js->size) )
+    {
+        js->buf[js->len++] = c;
+        js->total += 1;
+        return;
+    }
+    put( js, &c, 1 );
+}
+
+/**
+ * Number of bytes at the start of str that do not need escaping.
+ */
+static size_t plain( const uint8_t *str, size_t len )
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8( '"' );
+    const __m128i bslash = _mm_set1_epi8( '\\' );
+    const __m128i ctrl = _mm_set1_epi8( 0x1f );
+    for( ; i + 16 <= len; i += 16 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i*)&str[i] );
+        __m128i m = _mm_cmpeq_epi8( _mm_max_epu8( a, ctrl ), ctrl );   // a <= 0x1f
+        m = _mm_or_si128( m, _mm_cmpeq_epi8( a, quote ) );
+        m = _mm_or_si128( m, _mm_cmpeq_epi8( a, bslash ) );
+        unsigned mask = (unsigned)_mm_movemask_epi8( m );
+        if( mask != 0 ) return i + __builtin_ctz( mask );
+    }
+#endif
+    for( ; i < len; i++ )
+    {
+        uint8_t c = str[i];
+        if( (c < 0x20) || (c == '"') || (c == '\\') ) break;
+    }
+    return i;
+}
+
+/**
+ * Append the string in quotes with the JSON escapes.
+ */
+static void put_string( tausch_json_t *js, const uint8_t *str, size_t len )
+{
+    static const char hex[] = "0123456789abcdef";
+    put_char( js, '"' );
+    while( len > 0 )
+    {
+        size_t n = plain( str, len );
+        put( js, (const char*)str, n );
+        if( n == len ) break;
+        uint8_t c = str[n];
+        char esc[6] = { '\\', 0 };
+        size_t elen = 2;
+        switch( c )
+        {
+            case '"': esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                memcpy( &esc[1], "u00", 3 );
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 15];
+                elen = 6;
+                break;
+        }
+        put( js, esc, elen );
+        str += n + 1;
+        len -= n + 1;
+    }
+    put_char( js, '"' );
+}
+
+/**
+ * Append the blob as base64 string.
+ */
+static void put_base64( tausch_json_t *js, const uint8_t *data, size_t len )
+{
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char out[64];
+    size_t o = 0;
+    put_char( js, '"' );
+    for( size_t i = 0; i < len; i += 3 )
+    {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if( i + 1 < len ) v |= (uint32_t)data[i + 1] << 8;
+        if( i + 2 < len ) v |= data[i + 2];
+        out[o++] = b64[(v >> 18) & 63];
+        out[o++] = b64[(v >> 12) & 63];
+        out[o++] = (i + 1 < len) ? b64[(v >> 6) & 63] : '=';
+        out[o++] = (i + 2 < len) ? b64[v & 63] : '=';
+        if( o == sizeof(out) )
+        {
+            put( js, out, o );
+            o = 0;
+        }
+    }
+    put( js, out, o );
+    put_char( js, '"' );
+}
+
+static void put_uint( tausch_json_t *js, uint64_t v )
+{
+    char tmp[20];
+    size_t i = sizeof(tmp);
+    do
+    {
+        tmp[--i] = (char)('0' + (v % 10));
+        v /= 10;
+    }
+    while( v > 0 );
+    put( js, &tmp[i], sizeof(tmp) - i );
+}
+
+static void put_double( tausch_json_t *js, double v, bool single )
+{
+    char tmp[32];
+    if( (v != v) || (v - v != 0) )
+    {
+        put( js, "null", 4 );   // NaN and infinity are not in JSON
+        return;
+    }
+    // the shorter precision when it does read back the same
+    int n = snprintf( tmp, sizeof(tmp), "%.*g", single ? 7 : 15, v );
+    double back = strtod( tmp, NULL );
+    if( single ? ((float)back != (float)v) : (back != v) )
+    {
+        n = snprintf( tmp, sizeof(tmp), "%.*g", single ? 9 : 17, v );
+    }
+    put( js, tmp, (size_t)n );
+}
+
+/**
+ * Append the value of the current item according to its type in schema.
+ */
+static void put_value( tausch_json_t *js, tausch_cflater_t *cfl )
+{
+    const tausch_iter_t *iter = tausch_cflater_iter( cfl );
+    tausch_ntype_t ntype = tausch_cflater_get( cfl )->ntype;
+    tausch_view_t v;
+    uint64_t u = 0;
+
+    if( !tausch_iter_view( iter, &v ) )
+    {
+        js->ok = false;
+        return;
+    }
+    if( (ntype == TSCH_UTF8) || (ntype == TSCH_BLOB) )
+    {
+        if( v.len == 0 ) v.buf = NULL;
+        if( ntype == TSCH_UTF8 ) put_string( js, v.buf, v.len );
+        else put_base64( js, v.buf, v.len );
+        return;
+    }
+    if( ntype == TSCH_BOOL )
+    {
+        bool b = false;
+        (void)tausch_iter_read_bool( iter, &b );
+        if( b ) put( js, "true", 4 );
+        else put( js, "false", 5 );
+        return;
+    }
+    if( (v.len == 0) || (v.len > 8) || (ntype < TSCH_UINT) || (ntype > TSCH_FLOAT_64) )
+    {
+        put( js, "null", 4 );
+        return;
+    }
+    for( tsch_size_t i = v.len; i > 0; i-- )
+    {
+        u = (u << 8) | v.buf[i - 1];   // little endian
+    }
+    if( ntype <= TSCH_UINT_64 )
+    {
+        put_uint( js, u );
+    }
+    else if( ntype <= TSCH_SINT_64 )
+    {
+        unsigned bits = 8 * v.len;
+        if( (bits < 64) && (u >> (bits - 1)) ) u |= ~(uint64_t)0 << bits;   // sign extension
+        if( (int64_t)u < 0 )
+        {
+            put_char( js, '-' );
+            u = 0 - u;
+        }
+        put_uint( js, u );
+    }
+    else if( v.len == 4 )
+    {
+        float f;
+        uint32_t u32 = (uint32_t)u;
+        memcpy( &f, &u32, 4 );
+        put_double( js, f, true );
+    }
+    else if( v.len == 8 )
+    {
+        double d;
+        memcpy( &d, &u, 8 );
+        put_double( js, d, false );
+    }
+    else
+    {
+        put( js, "null", 4 );
+    }
+}
+
+/**
+ * Append the name of the current item as the key of object.
+ */
+static void put_key( tausch_json_t *js, tausch_cflater_t *cfl )
+{
+    const char *name = tausch_flater_tag_x( &cfl->flat );
+    if( name != NULL )
+    {
+        put_string( js, (const uint8_t*)name, strlen( name ) );
+    }
+    else
+    {
+        put_char( js, '"' );
+        put_uint( js, tausch_cflater_iter( cfl )->tag );
+        put_char( js, '"' );
+    }
+    put_char( js, ':' );
+}
+
+/**
+ * Append the items of the scope the flaterator is in.
+ */
+static void put_scope( tausch_json_t *js, tausch_cflater_t *cfl, bool variadic, unsigned depth )
+{
+    bool first = true;
+    if( depth >= TAUSCH_JSON_DEPTH )
+    {
+        js->ok = false;
+        return;
+    }
+    put_char( js, variadic ? '[' : '{' );
+    while( js->ok )
+    {
+        const tausch_iter_t *iter = tausch_cflater_iter( tausch_cflater_next( cfl ) );
+        if( !tausch_iter_is_ok( iter ) )
+        {
+            js->ok = false;   // the message is broken
+            break;
+        }
+        if( tausch_iter_is_end( iter ) ) break;
+        if( cfl->flat.idx == 0 ) continue;   // stuffing or item not in schema
+
+        if( !first ) put_char( js, ',' );
+        first = false;
+        if( variadic ) put_char( js, '{' );
+        put_key( js, cfl );
+
+        tausch_ntype_t ntype = tausch_cflater_get( cfl )->ntype;
+        if( (ntype == TSCH_COLLECTION) || (ntype == TSCH_VARIADIC) )
+        {
+            tausch_cflater_t sub = tausch_cflater_clone( cfl );
+            put_scope( js, &sub, ntype == TSCH_VARIADIC, depth + 1 );
+        }
+        else
+        {
+            put_value( js, cfl );
+        }
+        if( variadic ) put_char( js, '}' );
+    }
+    put_char( js, variadic ? ']' : '}' );
+}
+
+/**
+ * Initiate the JSON output.
+ *
+ * @param js : tausch_json_t* - the output
+ * @param buf : char* - the buffer
+ * @param size : size_t - size of the buffer
+ * @param sink : tausch_json_sink_f - where the full buffer is drained, NULL when the text must fit into the buffer
+ * @param ctx : void* - context for the sink
+ * @return tausch_json_t* - the output
+ */
+tausch_json_t* tausch_json_init( tausch_json_t *js, char *buf, size_t size, tausch_json_sink_f sink, void *ctx )
+{
+    js->buf = buf;
+    js->size = buf != NULL ? size : 0;
+    js->len = 0;
+    js->total = 0;
+    js->sink = sink;
+    js->ctx = ctx;
+    js->ok = (js->size > 0);
+    return js;
+}
+
+/**
+ * Convert the message into JSON text.
+ *
+ * @param js : tausch_json_t* - the output
+ * @param schema : tausch_schema_t* - schema of the message
+ * @param msg : const uint8_t* - the message
+ * @param len : tsch_size_t - the message buffer size
+ * @return size_t - number of bytes of JSON produced, 0 on failure
+ */
+size_t tausch_json_encode( tausch_json_t *js, tausch_schema_t *schema, const uint8_t *msg, tsch_size_t len )
+{
+    tausch_cflater_t cfl;
+
+    js->len = 0;
+    js->total = 0;
+    js->ok = (js->size > 0);
+    if( !tausch_cflater_init( &cfl, schema, msg, len ) ) return 0;
+
+    // the type of root scope is in the first row
+    tausch_flatrow_t root;
+    (void)tausch_flatrow_init( &root, schema );
+    (void)tausch_flatrow_decode( &root, 0 );
+    put_scope( js, &cfl, root.ntype == TSCH_VARIADIC, 0 );
+
+    if( js->ok && !tausch_iter_is_eof( tausch_cflater_iter( &cfl ) ) ) js->ok = false;
+    if( js->ok && (js->sink != NULL) && (js->len > 0) )
+    {
+        js->ok = js->sink( js->ctx, js->buf, js->len );
+        js->len = 0;
+    }
+    if( js->ok && (js->sink == NULL) )
+    {
+        // the terminating 0 is not counted
+        js->ok = js->len < js->size;
+        if( js->ok ) js->buf[js->len] = 0;
+    }
+    return js->ok ? js->total : 0;
+}
+
+/**
+ * State of the JSON parser.
+ */
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    tausch_json_keys_t *keys;
+    tausch_writer_t *wr;
+    bool ok;
+} parser_t;
+
+/**
+ * Length of the value field of the types, the types without width are written with 8 bytes.
+ */
+static const uint8_t widths[TSCH_UTF8] = {
+    0, 1,
+    8, 1, 2, 4, 8,
+    8, 1, 2, 4, 8,
+    8, 4, 8
+};
+
+static void skip_ws( parser_t *ps )
+{
+    while( (ps->p < ps->end) && ((*ps->p == ' ') || (*ps->p == '\n') || (*ps->p == '\r') || (*ps->p == '\t')) )
+    {
+        ps->p++;
+    }
+}
+
+/**
+ * Consume the character after the white space, false when it is not there.
+ */
+static bool take( parser_t *ps, char c )
+{
+    skip_ws( ps );
+    if( (ps->p < ps->end) && (*ps->p == (uint8_t)c) )
+    {
+        ps->p++;
+        return true;
+    }
+    return false;
+}
+
+static bool take_word( parser_t *ps, const char *word, size_t n )
+{
+    if( ((size_t)(ps->end - ps->p) >= n) && (memcmp( ps->p, word, n ) == 0) )
+    {
+        ps->p += n;
+        return true;
+    }
+    return false;
+}
+
+static long hex4( const uint8_t *s )
+{
+    long v = 0;
+    for( int i = 0; i < 4; i++ )
+    {
+        uint8_t c = s[i];
+        if( (c >= '0') && (c <= '9') ) v = (v << 4) | (c - '0');
+        else if( ((c | 0x20) >= 'a') && ((c | 0x20) <= 'f') ) v = (v << 4) | ((c | 0x20) - 'a' + 10);
+        else return -1;
+    }
+    return v;
+}
+
+static size_t utf8( uint8_t *u, long cp )
+{
+    if( cp < 0x80 )
+    {
+        u[0] = (uint8_t)cp;
+        return 1;
+    }
+    if( cp < 0x800 )
+    {
+        u[0] = (uint8_t)(0xc0 | (cp >> 6));
+        u[1] = (uint8_t)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if( cp < 0x10000 )
+    {
+        u[0] = (uint8_t)(0xe0 | (cp >> 12));
+        u[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        u[2] = (uint8_t)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    u[0] = (uint8_t)(0xf0 | (cp >> 18));
+    u[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3f));
+    u[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+    u[3] = (uint8_t)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+/**
+ * Unescape the string from str up to the closing quote into out, only count the bytes
+ * when out is NULL. The stop is set to the closing quote.
+ *
+ * @return number of bytes in string, TSCH_NOTHING when the string is broken
+ */
+static tsch_size_t unescape( const uint8_t *str, const uint8_t *end, uint8_t *out, const uint8_t **stop )
+{
+    tsch_size_t n = 0;
+    while( str < end )
+    {
+        size_t k = plain( str, (size_t)(end - str) );
+        if( out != NULL ) memcpy( &out[n], str, k );
+        n += k;
+        str += k;
+        if( str >= end ) break;
+        if( *str == '"' )
+        {
+            *stop = str;
+            return n;
+        }
+        if( (*str != '\\') || (str + 1 >= end) ) break;   // control character or cut escape
+
+        uint8_t u[4];
+        size_t ulen = 1;
+        uint8_t c = str[1];
+        str += 2;
+        switch( c )
+        {
+            case '"':
+            case '\\':
+            case '/': u[0] = c; break;
+            case 'b': u[0] = '\b'; break;
+            case 'f': u[0] = '\f'; break;
+            case 'n': u[0] = '\n'; break;
+            case 'r': u[0] = '\r'; break;
+            case 't': u[0] = '\t'; break;
+            case 'u':
+            {
+                long cp = (end - str >= 4) ? hex4( str ) : -1;
+                if( cp < 0 ) return TSCH_NOTHING;
+                str += 4;
+                if( (cp >= 0xd800) && (cp < 0xdc00) )
+                {
+                    // the surrogate pair
+                    long lo = ((end - str >= 6) && (str[0] == '\\') && (str[1] == 'u')) ? hex4( &str[2] ) : -1;
+                    if( (lo < 0xdc00) || (lo >= 0xe000) ) return TSCH_NOTHING;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                    str += 6;
+                }
+                else if( (cp >= 0xdc00) && (cp < 0xe000) )
+                {
+                    return TSCH_NOTHING;
+                }
+                ulen = utf8( u, cp );
+                break;
+            }
+            default:
+                return TSCH_NOTHING;
+        }
+        if( out != NULL ) memcpy( &out[n], u, ulen );
+        n += ulen;
+    }
+    return TSCH_NOTHING;
+}
+
+/**
+ * Compare the 0 terminated name at index off of the names with the key of len bytes.
+ */
+static int namecmp( const tausch_view_t *names, tsch_size_t off, const uint8_t *key, size_t len )
+{
+    size_t avail = off < names->len ? names->len - off : 0;
+    const uint8_t *s = &names->buf[off];
+    int cmp = memcmp( s, key, len < avail ? len : avail );
+    if( cmp != 0 ) return cmp;
+    if( len < avail ) return s[len] == 0 ? 0 : 1;
+    return -1;
+}
+
+/**
+ * Find the key of len bytes from the sub scope, the binary search over the sorted keys.
+ */
+static const tausch_json_key_t* find_key( const tausch_json_keys_t *keys, const tausch_json_key_t *scope,
+    const uint8_t *name, size_t len )
+{
+    const tausch_view_t *names = &keys->schema->names;
+    const tausch_json_key_t *key = &keys->key[scope->first];
+    bool named = (names->buf != NULL) && (names->len > 0);
+    tsch_size_t lo = 0;
+    tsch_size_t hi = scope->count;
+    uint64_t tag = 0;
+
+    if( !named )
+    {
+        // the tag number is the key
+        if( (len == 0) || (len > 19) ) return NULL;
+        for( size_t i = 0; i < len; i++ )
+        {
+            if( (name[i] < '0') || (name[i] > '9') ) return NULL;
+            tag = tag * 10 + (name[i] - '0');
+        }
+    }
+    while( lo < hi )
+    {
+        tsch_size_t mid = lo + (hi - lo) / 2;
+        int cmp;
+        if( named ) cmp = namecmp( names, key[mid].name, name, len );
+        else cmp = (key[mid].item < tag) ? -1 : (key[mid].item > tag);
+        if( cmp == 0 ) return &key[mid];
+        if( cmp < 0 ) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+/**
+ * Parse the quoted key of object member and resolve it in the scope.
+ */
+static const tausch_json_key_t* get_key( parser_t *ps, const tausch_json_key_t *scope )
+{
+    uint8_t tmp[64];   // the escaped names are unescaped here
+    if( !take( ps, '"' ) ) return NULL;
+
+    const uint8_t *name = ps->p;
+    size_t len = plain( ps->p, (size_t)(ps->end - ps->p) );
+    const uint8_t *stop = ps->p + len;
+    if( (stop >= ps->end) || (*stop != '"') )
+    {
+        tsch_size_t n = unescape( ps->p, ps->end, NULL, &stop );
+        if( (n == TSCH_NOTHING) || (n > sizeof(tmp)) ) return NULL;
+        (void)unescape( ps->p, ps->end, tmp, &stop );
+        name = tmp;
+        len = n;
+    }
+    ps->p = stop + 1;
+    return find_key( ps->keys, scope, name, len );
+}
+
+/**
+ * Reserve the value field of len bytes, the caller fills it in.
+ */
+static uint8_t* reserve( parser_t *ps, tsch_size_t tag, tsch_size_t len )
+{
+    if( tausch_writer_typX( ps->wr, tag, NULL, len ) != len )
+    {
+        ps->ok = false;
+        return NULL;
+    }
+    return &ps->wr->buf[ps->wr->next - len];
+}
+
+static void get_null( parser_t *ps, tsch_size_t tag )
+{
+    if( tausch_writer_typX( ps->wr, tag, NULL, 0 ) == 0 ) ps->ok = false;
+}
+
+/**
+ * Parse the string into UTF8 item, without escapes it is copied straight from the text.
+ */
+static void get_utf8( parser_t *ps, tsch_size_t tag )
+{
+    const uint8_t *stop = NULL;
+    tsch_size_t len = plain( ps->p, (size_t)(ps->end - ps->p) );
+
+    if( (ps->p + len < ps->end) && (ps->p[len] == '"') )
+    {
+        stop = ps->p + len;
+        if( len == 0 ) get_null( ps, tag );
+        else if( tausch_writer_typX( ps->wr, tag, (uint8_t*)ps->p, len ) != len ) ps->ok = false;
+    }
+    else
+    {
+        len = unescape( ps->p, ps->end, NULL, &stop );
+        if( len == TSCH_NOTHING )
+        {
+            ps->ok = false;
+            return;
+        }
+        uint8_t *out = (len > 0) ? reserve( ps, tag, len ) : NULL;
+        if( out != NULL ) (void)unescape( ps->p, ps->end, out, &stop );
+        else if( len == 0 ) get_null( ps, tag );
+    }
+    ps->p = stop + 1;
+}
+
+static int b64val( uint8_t c )
+{
+    if( (c >= 'A') && (c <= 'Z') ) return c - 'A';
+    if( (c >= 'a') && (c <= 'z') ) return c - 'a' + 26;
+    if( (c >= '0') && (c <= '9') ) return c - '0' + 52;
+    if( c == '+' ) return 62;
+    if( c == '/' ) return 63;
+    return -1;
+}
+
+/**
+ * Parse the base64 string into BLOB item, it is decoded straight into the message.
+ */
+static void get_base64( parser_t *ps, tsch_size_t tag )
+{
+    const uint8_t *str = ps->p;
+    size_t n = plain( str, (size_t)(ps->end - str) );
+    if( (str + n >= ps->end) || (str[n] != '"') )
+    {
+        ps->ok = false;
+        return;
+    }
+    ps->p = str + n + 1;
+    for( int pad = 0; (pad < 2) && (n > 0) && (str[n - 1] == '='); pad++ ) n--;
+    if( (n % 4) == 1 )
+    {
+        ps->ok = false;
+        return;
+    }
+    tsch_size_t len = (n / 4) * 3 + ((n % 4) ? (n % 4) - 1 : 0);
+    if( len == 0 )
+    {
+        get_null( ps, tag );
+        return;
+    }
+    uint8_t *out = reserve( ps, tag, len );
+    if( out == NULL ) return;
+
+    uint32_t v = 0;
+    tsch_size_t o = 0;
+    for( size_t i = 0; i < n; i++ )
+    {
+        int b = b64val( str[i] );
+        if( b < 0 )
+        {
+            ps->ok = false;
+            return;
+        }
+        v = (v << 6) | (uint32_t)b;
+        if( (i % 4) == 3 )
+        {
+            out[o++] = (uint8_t)(v >> 16);
+            out[o++] = (uint8_t)(v >> 8);
+            out[o++] = (uint8_t)v;
+        }
+    }
+    if( (n % 4) == 2 )
+    {
+        out[o++] = (uint8_t)(v >> 4);
+    }
+    else if( (n % 4) == 3 )
+    {
+        out[o++] = (uint8_t)(v >> 10);
+        out[o++] = (uint8_t)(v >> 2);
+    }
+}
+
+static bool numchar( uint8_t c )
+{
+    return ((c >= '0') && (c <= '9')) || (c == '-') || (c == '+') || (c == '.') || (c == 'e') || (c == 'E');
+}
+
+/**
+ * Parse the number, for the integer types into the sign and magnitude, otherwise into the double.
+ */
+static bool get_number( parser_t *ps, bool integer, bool *neg, uint64_t *mag, double *dbl )
+{
+    const uint8_t *s = ps->p;
+    size_t n = 0;
+    char tmp[40];
+
+    while( (s + n < ps->end) && numchar( s[n] ) ) n++;
+    if( (n == 0) || (n >= sizeof(tmp)) ) return false;
+    ps->p += n;
+    *neg = (s[0] == '-');
+
+    if( integer )
+    {
+        // the plain integer without the strtod
+        uint64_t v = 0;
+        size_t i = *neg ? 1 : 0;
+        size_t first = i;
+        for( ; (i < n) && (s[i] >= '0') && (s[i] <= '9'); i++ )
+        {
+            uint64_t d = s[i] - '0';
+            if( v > (UINT64_MAX - d) / 10 ) return false;
+            v = v * 10 + d;
+        }
+        if( (i == n) && (i > first) )
+        {
+            *mag = v;
+            return true;
+        }
+    }
+    memcpy( tmp, s, n );
+    tmp[n] = 0;
+    char *e;
+    double d = strtod( tmp, &e );
+    if( e != &tmp[n] ) return false;
+    *dbl = d;
+    if( integer )
+    {
+        // only the integral values that fit
+        double m = *neg ? -d : d;
+        if( !(m < 18446744073709551616.0) ) return false;
+        *mag = (uint64_t)m;
+        if( (double)*mag != m ) return false;
+    }
+    return true;
+}
+
+/**
+ * Write the number into UINT, SINT or FLOAT item, little endian.
+ */
+static void get_numeric( parser_t *ps, tsch_size_t tag, tausch_ntype_t ntype )
+{
+    tsch_size_t w = widths[ntype];
+    bool neg = false;
+    uint64_t mag = 0;
+    uint64_t v;
+    double d = 0;
+    uint8_t val[8];
+
+    if( !get_number( ps, ntype < TSCH_FLOAT, &neg, &mag, &d ) )
+    {
+        ps->ok = false;
+        return;
+    }
+    if( ntype >= TSCH_FLOAT )
+    {
+        if( w == 4 )
+        {
+            float f = (float)d;
+            uint32_t u32;
+            if( (f - f != 0) && (d - d == 0) ) ps->ok = false;   // out of range of float
+            memcpy( &u32, &f, 4 );
+            v = u32;
+        }
+        else
+        {
+            memcpy( &v, &d, 8 );
+        }
+    }
+    else if( ntype >= TSCH_SINT )
+    {
+        uint64_t lim = (uint64_t)1 << (8 * w - 1);
+        if( neg ? (mag > lim) : (mag >= lim) ) ps->ok = false;
+        v = neg ? 0 - mag : mag;
+    }
+    else
+    {
+        if( (neg && (mag > 0)) || ((w < 8) && (mag >> (8 * w))) ) ps->ok = false;
+        v = mag;
+    }
+    if( !ps->ok ) return;
+    for( tsch_size_t i = 0; i < w; i++ )
+    {
+        val[i] = (uint8_t)(v >> (8 * i));
+    }
+    if( tausch_writer_typX( ps->wr, tag, val, w ) != w ) ps->ok = false;
+}
+
+static void get_scope( parser_t *ps, const tausch_json_key_t *scope, bool variadic, unsigned depth );
+
+/**
+ * Parse the value of the key, according to the type of the key.
+ */
+static void get_value( parser_t *ps, const tausch_json_key_t *key, unsigned depth )
+{
+    tausch_ntype_t ntype = key->ntype;
+
+    skip_ws( ps );
+    if( ps->p >= ps->end )
+    {
+        ps->ok = false;
+        return;
+    }
+    if( (ntype == TSCH_COLLECTION) || (ntype == TSCH_VARIADIC) )
+    {
+        bool variadic = (ntype == TSCH_VARIADIC);
+        if( (*ps->p != (variadic ? '[' : '{')) || !tausch_writer_scope( ps->wr, key->item ) )
+        {
+            ps->ok = false;
+            return;
+        }
+        ps->p++;
+        get_scope( ps, key, variadic, depth + 1 );
+        if( ps->ok && !tausch_writer_end( ps->wr ) ) ps->ok = false;
+        return;
+    }
+    if( take_word( ps, "null", 4 ) )
+    {
+        get_null( ps, key->item );
+    }
+    else if( ntype == TSCH_BOOL )
+    {
+        bool b = take_word( ps, "true", 4 );
+        if( !b && !take_word( ps, "false", 5 ) ) ps->ok = false;
+        else if( !tausch_writer_bool( ps->wr, key->item, &b ) ) ps->ok = false;
+    }
+    else if( (ntype == TSCH_UTF8) || (ntype == TSCH_BLOB) )
+    {
+        if( *ps->p != '"' )
+        {
+            ps->ok = false;
+            return;
+        }
+        ps->p++;
+        if( ntype == TSCH_UTF8 ) get_utf8( ps, key->item );
+        else get_base64( ps, key->item );
+    }
+    else if( (ntype >= TSCH_UINT) && (ntype <= TSCH_FLOAT_64) )
+    {
+        get_numeric( ps, key->item, ntype );
+    }
+    else
+    {
+        ps->ok = false;
+    }
+}
+
+/**
+ * Parse the members of the object up to the closing brace.
+ */
+static void get_members( parser_t *ps, const tausch_json_key_t *scope, unsigned depth )
+{
+    if( take( ps, '}' ) ) return;
+    do
+    {
+        const tausch_json_key_t *key = get_key( ps, scope );
+        if( (key == NULL) || !take( ps, ':' ) )
+        {
+            ps->ok = false;
+            return;
+        }
+        get_value( ps, key, depth );
+    }
+    while( ps->ok && take( ps, ',' ) );
+    if( ps->ok && !take( ps, '}' ) ) ps->ok = false;
+}
+
+/**
+ * Parse the content of the object or of the array of objects for the VARIADIC.
+ */
+static void get_scope( parser_t *ps, const tausch_json_key_t *scope, bool variadic, unsigned depth )
+{
+    if( depth >= TAUSCH_JSON_DEPTH )
+    {
+        ps->ok = false;
+        return;
+    }
+    if( !variadic )
+    {
+        get_members( ps, scope, depth );
+        return;
+    }
+    if( take( ps, ']' ) ) return;
+    do
+    {
+        if( !take( ps, '{' ) )
+        {
+            ps->ok = false;
+            return;
+        }
+        get_members( ps, scope, depth );
+    }
+    while( ps->ok && take( ps, ',' ) );
+    if( ps->ok && !take( ps, ']' ) ) ps->ok = false;
+}
+
+/**
+ * Build the table of keys from the schema into the caller memory.
+ *
+ * @param keys : tausch_json_keys_t* - the table
+ * @param schema : tausch_schema_t* - the schema, it must stay valid as long the table is used
+ * @param key : tausch_json_key_t* - memory of the keys
+ * @param size : tsch_size_t - number of keys in memory
+ * @return bool - false when the schema is broken or the memory is too small
+ */
+bool tausch_json_keys_init( tausch_json_keys_t *keys, tausch_schema_t *schema, tausch_json_key_t *key, tsch_size_t size )
+{
+    tausch_flatrow_t row;
+    bool named = (schema->names.buf != NULL) && (schema->names.len > 0);
+
+    keys->schema = schema;
+    keys->key = key;
+    keys->size = size;
+    keys->len = 0;
+    if( (key == NULL) || (size == 0) ) return false;
+    if( !tausch_flatrow_init( &row, schema ) || !tausch_flatrow_decode( &row, 0 ) ) return false;
+    key[0] = (tausch_json_key_t){ .item = row.item, .name = row.name, .ntype = row.ntype, .sub = row.sub };
+    keys->len = 1;
+
+    // breadth first, the keys of each scope are appended as a group
+    for( tsch_size_t k = 0; k < keys->len; k++ )
+    {
+        tsch_size_t j;
+        key[k].first = keys->len;
+        key[k].count = 0;
+        if( key[k].sub == 0 ) continue;
+
+        // the scopes of the same type share the group
+        for( j = 0; (j < k) && (key[j].sub != key[k].sub); j++ )
+            ;
+        if( j < k )
+        {
+            key[k].first = key[j].first;
+            key[k].count = key[j].count;
+            continue;
+        }
+        for( tsch_size_t idx = key[k].sub; idx > 0; idx = row.next )
+        {
+            if( (keys->len >= size) || !tausch_flatrow_decode( &row, idx ) ) return false;
+
+            // insertion into the sorted group
+            tsch_size_t at = keys->len;
+            while( (at > key[k].first) && (named ? (key[at - 1].name > row.name) : (key[at - 1].item > row.item)) )
+            {
+                key[at] = key[at - 1];
+                at--;
+            }
+            key[at] = (tausch_json_key_t){ .item = row.item, .name = row.name, .ntype = row.ntype, .sub = row.sub };
+            keys->len += 1;
+            key[k].count += 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * Convert the JSON text into the message.
+ *
+ * @param keys : tausch_json_keys_t* - the table of keys of the schema
+ * @param text : const char* - the JSON text
+ * @param len : size_t - length of the text
+ * @param wr : tausch_writer_t* - the writer of message
+ * @return tsch_size_t - length of the message, 0 on failure
+ */
+tsch_size_t tausch_json_decode( tausch_json_keys_t *keys, const char *text, size_t len, tausch_writer_t *wr )
+{
+    parser_t ps = { .p = (const uint8_t*)text, .end = (const uint8_t*)text + len, .keys = keys, .wr = wr, .ok = true };
+
+    if( (keys->len == 0) || (text == NULL) || !tausch_writer_is_ok( wr ) ) return 0;
+
+    const tausch_json_key_t *root = &keys->key[0];
+    bool variadic = (root->ntype == TSCH_VARIADIC);
+    if( !take( &ps, variadic ? '[' : '{' ) ) return 0;
+    get_scope( &ps, root, variadic, 0 );
+
+    // only white space or 0 termination may follow
+    skip_ws( &ps );
+    if( ps.ok && (ps.p < ps.end) && (*ps.p != 0) ) ps.ok = false;
+    if( !ps.ok || !tausch_writer_is_ok( wr ) ) return 0;
+    return tausch_writer_len( wr );
+}
@@ -0,0 +1,214 @@
+/*
+ * tauschema_json.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_JSON_H_
+#define SRC_TAUSCHEMA_JSON_H_
+
+#include "tauschema_check.h"
+#include "tauschema_writer.h"
+
+/**
+ * Maximal depth of the scopes converted, the deeper messages fail.
+ */
+#ifndef TAUSCH_JSON_DEPTH
+#define TAUSCH_JSON_DEPTH 32
+#endif
+
+/**
+ * Sink of the produced JSON text. It is called when the buffer is full and at the end.
+ *
+ * @param ctx : void* - the context given to tausch_json_init()
+ * @param data : const char* - the text
+ * @param len : size_t - number of bytes in text
+ * @return bool - false to abort the conversion
+ */
+typedef bool (*tausch_json_sink_f)( void *ctx, const char *data, size_t len );
+
+/**
+ * Output of the JSON text into the caller buffer, which is optionally drained into the sink.
+ */
+typedef struct
+{
+    /// The buffer of text
+    char *buf;
+
+    /// Size of the buffer
+    size_t size;
+
+    /// Number of bytes in buffer not yet given to sink
+    size_t len;
+
+    /// Number of bytes produced in total
+    size_t total;
+
+    /// The sink, NULL when the text shall fit into the buffer
+    tausch_json_sink_f sink;
+
+    /// Context for the sink
+    void *ctx;
+
+    /// False when the buffer did overflow or the sink did abort
+    bool ok;
+
+} tausch_json_t;
+
+/**
+ * Initiate the JSON output.
+ *
+ * @param js : tausch_json_t* - the output
+ * @param buf : char* - the buffer
+ * @param size : size_t - size of the buffer
+ * @param sink : tausch_json_sink_f - where the full buffer is drained, NULL when the text must fit into the buffer
+ * @param ctx : void* - context for the sink
+ * @return tausch_json_t* - the output
+ */
+tausch_json_t* tausch_json_init( tausch_json_t *js, char *buf, size_t size, tausch_json_sink_f sink, void *ctx )
+;
+
+/**
+ * Convert the message into JSON text. The root scope and the COLLECTIONs are objects and
+ * the VARIADICs are arrays of single member objects. The names are taken from the schema,
+ * when the schema has no names then the tag numbers are used. BLOBs are base64 strings,
+ * null values and numbers that do not fit are null. Stuffing and the items unknown to
+ * the schema are skipped.
+ *
+ * Without sink the text is 0 terminated in the buffer.
+ *
+ * @param js : tausch_json_t* - the output
+ * @param schema : tausch_schema_t* - schema of the message
+ * @param msg : const uint8_t* - the message
+ * @param len : tsch_size_t - the message buffer size
+ * @return size_t - number of bytes of JSON produced, 0 on failure
+ *
+ * @example
+ * char text[1000];
+ * tausch_json_t js;
+ * tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+ * if( tausch_json_encode( &js, &schema, msg, len ) > 0 ) puts( text );
+ */
+size_t tausch_json_encode( tausch_json_t *js, tausch_schema_t *schema, const uint8_t *msg, tsch_size_t len )
+;
+
+/**
+ * Key of the JSON object, the schema row of the item with the sub scope resolved.
+ */
+typedef struct
+{
+    /// Tag value in TLV
+    tsch_size_t item;
+
+    /// Index of the name in tausch_schema_t::names, the enumerator when schema has no names
+    tsch_size_t name;
+
+    /// Primitive type
+    tausch_ntype_t ntype;
+
+    /// Table index to the first subitem in schema rows, 0 when none
+    tsch_size_t sub;
+
+    /// Index of the first key of the sub scope in the table
+    tsch_size_t first;
+
+    /// Number of keys in the sub scope, they are sorted by name
+    tsch_size_t count;
+
+} tausch_json_key_t;
+
+/**
+ * Table of the keys of all the scopes in schema, for resolving the JSON names to the schema rows.
+ */
+typedef struct
+{
+    /// The schema
+    tausch_schema_t *schema;
+
+    /// The keys, the first one is the root scope
+    tausch_json_key_t *key;
+
+    /// Number of keys in use
+    tsch_size_t len;
+
+    /// Number of keys available
+    tsch_size_t size;
+
+} tausch_json_keys_t;
+
+/**
+ * Build the table of keys from the schema into the caller memory. The keys of each scope
+ * are sorted by the name, so that the name is found with binary search. The names in the
+ * schema are already sorted by the schema compiler, so the order of name index is the order
+ * of the strings. When the schema has no names, the keys are sorted by the tag value.
+ *
+ * The scopes of the same type share the keys, one key per schema row is always enough.
+ *
+ * @param keys : tausch_json_keys_t* - the table
+ * @param schema : tausch_schema_t* - the schema, it must stay valid as long the table is used
+ * @param key : tausch_json_key_t* - memory of the keys
+ * @param size : tsch_size_t - number of keys in memory
+ * @return bool - false when the schema is broken or the memory is too small
+ */
+bool tausch_json_keys_init( tausch_json_keys_t *keys, tausch_schema_t *schema, tausch_json_key_t *key, tsch_size_t size )
+;
+
+/**
+ * Convert the JSON text into the message, in single pass without intermediate tree. The
+ * text is the same as produced by tausch_json_encode(): the root scope and the COLLECTIONs
+ * are objects, the VARIADICs arrays of objects. The keys are the names of the schema or
+ * the tag numbers when schema has no names. The values are converted according to the type
+ * of the schema row:
+ *
+ *  - BOOL from true and false
+ *  - UINT, SINT and FLOAT from numbers that fit into the type, UINT, SINT and FLOAT without
+ *    width are written with 8 bytes as the flaterator does
+ *  - UTF8 from strings, BLOB from base64 strings
+ *  - null to all the primitives, the tag only item is written
+ *
+ * The unknown keys, wrong types and numbers out of range fail the conversion. The
+ * message is written with the writer, on failure the writer holds the items written
+ * so far.
+ *
+ * @param keys : tausch_json_keys_t* - the table of keys of the schema
+ * @param text : const char* - the JSON text
+ * @param len : size_t - length of the text
+ * @param wr : tausch_writer_t* - the writer of message
+ * @return tsch_size_t - length of the message, 0 on failure
+ *
+ * @example
+ * tausch_json_key_t key[20];
+ * tausch_json_keys_t keys;
+ * tausch_json_keys_init( &keys, &schema, key, 20 );
+ * tausch_writer_init( &wr, msg, sizeof(msg) );
+ * tsch_size_t len = tausch_json_decode( &keys, text, strlen( text ), &wr );
+ */
+tsch_size_t tausch_json_decode( tausch_json_keys_t *keys, const char *text, size_t len, tausch_writer_t *wr )
+;
+
+#endif /* SRC_TAUSCHEMA_JSON_H_ */
@@ -0,0 +1,98 @@
+/*
+ * tauschema_stats.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_stats.h"
+
+#ifdef TAUSCH_STATS
+
+#include <stdatomic.h>
+#include <string.h>
+
+#define NSTATS (sizeof(tausch_stats_t) / sizeof(uint64_t))
+
+_Thread_local tausch_stats_t tausch_stats;
+
+static _Atomic uint64_t total[NSTATS];
+
+/**
+ * Copy the counters of the calling thread.
+ *
+ * @param out : tausch_stats_t* - where to copy
+ * @return tausch_stats_t* - the out
+ */
+tausch_stats_t* tausch_stats_get( tausch_stats_t *out )
+{
+    *out = tausch_stats;
+    return out;
+}
+
+/**
+ * Add the counters of the calling thread to the total and clear them.
+ */
+void tausch_stats_merge( void )
+{
+    const uint64_t *c = (const uint64_t*)&tausch_stats;
+    for( size_t i = 0; i < NSTATS; i++ )
+    {
+        if( c[i] != 0 ) atomic_fetch_add_explicit( &total[i], c[i], memory_order_relaxed );
+    }
+    memset( &tausch_stats, 0, sizeof(tausch_stats) );
+}
+
+/**
+ * Copy the total of the counters merged by all the threads.
+ *
+ * @param out : tausch_stats_t* - where to copy
+ * @return tausch_stats_t* - the out
+ */
+tausch_stats_t* tausch_stats_total( tausch_stats_t *out )
+{
+    uint64_t *c = (uint64_t*)out;
+    for( size_t i = 0; i < NSTATS; i++ )
+    {
+        c[i] = atomic_load_explicit( &total[i], memory_order_relaxed );
+    }
+    return out;
+}
+
+/**
+ * Clear the counters of the calling thread and the total.
+ */
+void tausch_stats_clear( void )
+{
+    memset( &tausch_stats, 0, sizeof(tausch_stats) );
+    for( size_t i = 0; i < NSTATS; i++ )
+    {
+        atomic_store_explicit( &total[i], 0, memory_order_relaxed );
+    }
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * tauschema_stats.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_STATS_H_
+#define SRC_TAUSCHEMA_STATS_H_
+
+#include "tauschema_codec.h"
+
+/**
+ * Counters of the codec hot paths, compiled in with -DTAUSCH_STATS. Without it the
+ * counting compiles to nothing and the functions below do not exist.
+ *
+ * Each thread counts into its own counters, without any locking. The counters of the
+ * thread are folded into the process wide total with tausch_stats_merge(), the workers
+ * of the batch pool do it after every run.
+ */
+typedef struct
+{
+    /// Bytes stepped over by tausch_iter_next()
+    uint64_t scanned;
+
+    /// TLV headers decoded by tausch_iter_next()
+    uint64_t tlvs;
+
+    /// Writes rolled back by tausch_iter_overwrite()
+    uint64_t rollbacks;
+
+    /// Failures of tausch_iter_next(), tausch_iter_overwrite() and tausch_iter_erase()
+    uint64_t failures;
+
+    /// Stuffings merged into the stuffing left behind by tausch_iter_overwrite()
+    uint64_t merges;
+
+    /// Flat rows decoded by tausch_flatrow_decode()
+    uint64_t rows;
+
+    /// Siblings compared with the tag in tausch_flater_next()
+    uint64_t compares;
+
+} tausch_stats_t;
+
+#ifdef TAUSCH_STATS
+
+/**
+ * Counters of the calling thread.
+ */
+extern _Thread_local tausch_stats_t tausch_stats;
+
+/**
+ * Increment the counter of the calling thread.
+ */
+#define TAUSCH_STAT( counter, n ) (tausch_stats.counter += (n))
+
+/**
+ * Copy the counters of the calling thread.
+ *
+ * @param out : tausch_stats_t* - where to copy
+ * @return tausch_stats_t* - the out
+ */
+tausch_stats_t* tausch_stats_get( tausch_stats_t *out )
+;
+
+/**
+ * Add the counters of the calling thread to the total and clear them.
+ */
+void tausch_stats_merge( void )
+;
+
+/**
+ * Copy the total of the counters merged by all the threads.
+ *
+ * @param out : tausch_stats_t* - where to copy
+ * @return tausch_stats_t* - the out
+ */
+tausch_stats_t* tausch_stats_total( tausch_stats_t *out )
+;
+
+/**
+ * Clear the counters of the calling thread and the total.
+ */
+void tausch_stats_clear( void )
+;
+
+#else
+
+#define TAUSCH_STAT( counter, n ) ((void)sizeof( (n) ))
+
+#endif
+
+#endif /* SRC_TAUSCHEMA_STATS_H_ */
@@ -0,0 +1,422 @@
+/*
+ * tauschema_stream.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_stream.h"
+#include <string.h>
+
+/**
+ * Start decoding of new message.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param buf : uint8_t* - the buffer for the received bytes
+ * @param size : tsch_size_t - size of the buffer
+ * @return tausch_stream_t* - the decoder
+ */
+tausch_stream_t* tausch_stream_init( tausch_stream_t *st, uint8_t *buf, tsch_size_t size )
+{
+    tausch_iter_init( &st->iter, buf, 0 );
+    st->buf = buf;
+    st->size = buf ? size : 0;
+    st->have = 0;
+    st->pos = 0;
+    st->skip = 0;
+    st->need = 1;
+    st->base = 0;
+    st->scope = 0;
+    st->eof = false;
+    return st;
+}
+
+/**
+ * Return true when the decoder is not broken. Decoder is broken when the message
+ * is not valid or there is TLV that does not fit into buffer.
+ */
+bool tausch_stream_is_ok( tausch_stream_t *st )
+{
+    return st->size > 0;
+}
+
+/**
+ * Break the decoder.
+ *
+ * @return false
+ */
+static bool tausch_stream_fail( tausch_stream_t *st )
+{
+    st->size = 0;
+    st->need = 0;
+    st->iter.ebuf = 0;
+    return false;
+}
+
+/**
+ * Return the free space of buffer where the bytes are received into.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param room : tsch_size_t* - number of bytes that can be received
+ * @return uint8_t* - where to receive, NULL when decoder is broken
+ */
+uint8_t* tausch_stream_space( tausch_stream_t *st, tsch_size_t *room )
+{
+    *room = 0;
+    if( !tausch_stream_is_ok( st ) ) return NULL;
+    *room = st->size - st->have;
+    return &st->buf[st->have];
+}
+
+/**
+ * Tell the decoder that bytes have been received into the space.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param len : tsch_size_t - number of bytes received
+ * @return bool - false when it is more than the space or the decoder is broken
+ */
+bool tausch_stream_fill( tausch_stream_t *st, tsch_size_t len )
+{
+    if( !tausch_stream_is_ok( st ) ) return false;
+    if( len > (st->size - st->have) ) return false;
+    st->have += len;
+    st->need = (st->need > len) ? st->need - len : 0;
+    return true;
+}
+
+/**
+ * Decode the vluint from the received bytes.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param p : tsch_size_t* - the offset to decode from, moved behind the vluint
+ * @param val : tsch_size_t* - the decoded value
+ * @return bool - false when the bytes have not arrived yet or the decoder was broken
+ */
+static bool tausch_stream_vluint( tausch_stream_t *st, tsch_size_t *p, tsch_size_t *val )
+{
+    uint64_t rv = 0;
+    bool lost = false;   // some bits did not fit into 64 bits
+    unsigned s = 0;
+    uint8_t x = 0;
+    tsch_size_t n = *p;
+    do
+    {
+        if( n >= st->have ) return false;   // wait for more
+        x = st->buf[n++];
+        if( s < 64 )
+        {
+            rv |= ((uint64_t)x & 0x7f) << s;
+            lost |= (s > 57) && ((x & 0x7f) >> (64 - s));
+            s += 7;
+        }
+        else
+        {
+            lost |= (x & 0x7f) != 0;
+        }
+    }
+    while( (x & 0x80) == 0x80 );
+    if( lost || (rv >= (uint64_t)TSCH_NOTHING) ) return tausch_stream_fail( st );
+    *p = n;
+    *val = (tsch_size_t)rv;
+    return true;
+}
+
+/**
+ * Put the iterator onto the TLV that starts from st->pos and ends at next.
+ */
+static bool tausch_stream_deliver( tausch_stream_t *st, tsch_size_t tag, uint8_t lc, tsch_size_t val,
+    tsch_size_t vlen, tsch_size_t next )
+{
+    tausch_iter_t *it = &st->iter;
+    it->buf = st->buf;
+    it->ebuf = st->have;
+    it->idx = st->pos;
+    it->val = val;
+    it->vlen = vlen;
+    it->next = next;
+    it->tag = tag;
+    it->lc = lc;
+    it->scope = st->scope;
+    st->pos = next;
+    return true;
+}
+
+/**
+ * Decode the next TLV of the message. When it returns false, then tausch_stream_need()
+ * tells how many more bytes are needed, or it is 0 at EOF or when the decoder is broken.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @return bool - true when the iterator of decoder is on the TLV
+ */
+bool tausch_stream_next( tausch_stream_t *st )
+{
+    if( !tausch_stream_is_ok( st ) || st->eof ) return false;
+
+    for( ;; )
+    {
+        if( st->skip > 0 )
+        {
+            // drop the stuffing that did arrive
+            tsch_size_t n = st->have - st->pos;
+            n = n > st->skip ? st->skip : n;
+            st->pos += n;
+            st->skip -= n;
+            st->need = st->skip;
+            if( st->skip > 0 ) return false;
+        }
+
+        tsch_size_t p = st->pos;
+        tsch_size_t txlc = 0;
+        tsch_size_t len = 0;
+        st->need = 1;   // at least one byte more is needed to complete the vluint
+        bool got = tausch_stream_vluint( st, &p, &txlc );
+        tsch_size_t tag = txlc >> 2;
+        uint8_t lc = txlc & 3;
+
+        if( got && ( (lc == 2) || ( (lc == 3) && (tag > 1))) )
+        {
+            got = tausch_stream_vluint( st, &p, &len );
+        }
+        if( !got )
+        {
+            // the header that fills whole buffer is broken
+            if( tausch_stream_is_ok( st ) && (st->pos == 0) && (st->have == st->size) ) tausch_stream_fail( st );
+            return false;
+        }
+        st->need = 0;
+
+        if( (lc == 3) && (tag == 0) )
+        {
+            // END of scope, the sized scope must end where its length did tell
+            if( st->scope == 0 ) return tausch_stream_fail( st );
+            tausch_stream_deliver( st, 0, 3, p, 0, p );
+            if( (st->end[st->scope - 1] != TSCH_NOTHING) && (st->end[st->scope - 1] != (st->base + p)) )
+            {
+                return tausch_stream_fail( st );
+            }
+            st->scope -= 1;
+            return true;
+        }
+        else if( (lc == 3) && (tag == 1) )
+        {
+            // EOF, only at root scope
+            if( st->scope != 0 ) return tausch_stream_fail( st );
+            tausch_stream_deliver( st, 1, 3, p, 0, p );
+            st->eof = true;
+            return false;
+        }
+        else if( (lc & 1) == 1 )
+        {
+            // scope, it is entered
+            if( st->scope >= TAUSCH_STREAM_DEPTH ) return tausch_stream_fail( st );
+            tsch_size_t end = TSCH_NOTHING;
+            if( lc == 3 )
+            {
+                end = st->base + p + len;
+                if( (len == 0) || (end <= st->base + p) ) return tausch_stream_fail( st );
+            }
+            tausch_stream_deliver( st, tag, 1, TSCH_NOTHING, len, p );
+            st->end[st->scope] = end;
+            st->scope += 1;
+            return true;
+        }
+        else if( tag == 0 )
+        {
+            // stuffing is dropped, also when it has not fully arrived
+            if( (p + len) < p ) return tausch_stream_fail( st );
+            st->pos = p;
+            st->skip = len;
+            continue;
+        }
+        else if( lc == 0 )
+        {
+            // null or boolean true
+            tausch_stream_deliver( st, tag, 0, TSCH_NOTHING, 0, p );
+            return true;
+        }
+        else if( ( (p + len) < p) || ( (p + len - st->pos) > st->size) )
+        {
+            return tausch_stream_fail( st );   // the TLV does not fit into buffer
+        }
+        else if( (p + len) > st->have )
+        {
+            st->need = p + len - st->have;
+            return false;
+        }
+        tausch_stream_deliver( st, tag, 2, p, len, p + len );
+        return true;
+    }
+}
+
+/**
+ * Return number of bytes that are needed at least, before the next TLV can be decoded.
+ */
+tsch_size_t tausch_stream_need( tausch_stream_t *st )
+{
+    return st->need;
+}
+
+/**
+ * Drop the decoded bytes from the buffer and move the rest to its beginning.
+ * The iterator and the views of the delivered TLVs are not valid anymore.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @return tsch_size_t - number of bytes dropped
+ */
+tsch_size_t tausch_stream_consume( tausch_stream_t *st )
+{
+    if( !tausch_stream_is_ok( st ) ) return 0;
+    tsch_size_t n = st->pos;
+    if( n == 0 ) return 0;
+    memmove( st->buf, &st->buf[n], st->have - n );
+    st->have -= n;
+    st->pos = 0;
+    st->base += n;
+    st->iter.ebuf = 0;
+    return n;
+}
+
+/**
+ * Start framing of messages.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param buf : uint8_t* - the buffer, it must be bigger than the biggest message
+ * @param size : tsch_size_t - size of the buffer
+ * @return tausch_framer_t* - the framer
+ */
+tausch_framer_t* tausch_framer_init( tausch_framer_t *fr, uint8_t *buf, tsch_size_t size )
+{
+    tausch_stream_init( &fr->st, buf, size );
+    fr->start = 0;
+    fr->dropped = 0;
+    fr->resync = false;
+    return fr;
+}
+
+/**
+ * Start decoding of next message from fr->start.
+ */
+static void tausch_framer_restart( tausch_framer_t *fr, tsch_size_t size )
+{
+    tausch_stream_t *st = &fr->st;
+    st->size = size;
+    st->pos = fr->start;
+    st->skip = 0;
+    st->need = 1;
+    st->scope = 0;
+    st->eof = false;
+    st->iter.ebuf = 0;
+}
+
+/**
+ * Return the free space of buffer where the bytes are received into. The slices of
+ * messages given out earlier are not valid anymore.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param room : tsch_size_t* - number of bytes that can be received
+ * @return uint8_t* - where to receive
+ */
+uint8_t* tausch_framer_space( tausch_framer_t *fr, tsch_size_t *room )
+{
+    tausch_stream_t *st = &fr->st;
+    if( fr->start > 0 )
+    {
+        // move the message not completed to the beginning
+        memmove( st->buf, &st->buf[fr->start], st->have - fr->start );
+        st->have -= fr->start;
+        st->pos -= fr->start;
+        st->base += fr->start;
+        st->iter.ebuf = 0;
+        fr->start = 0;
+    }
+    return tausch_stream_space( st, room );
+}
+
+/**
+ * Tell the framer that bytes have been received into the space.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param len : tsch_size_t - number of bytes received
+ * @return bool - false when it is more than the space
+ */
+bool tausch_framer_fill( tausch_framer_t *fr, tsch_size_t len )
+{
+    return tausch_stream_fill( &fr->st, len );
+}
+
+/**
+ * Find the next complete message.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param msg : tausch_view_t* - the slice of message including its EOF
+ * @return bool - true when message was found, false when more bytes are needed
+ */
+bool tausch_framer_next( tausch_framer_t *fr, tausch_view_t *msg )
+{
+    tausch_stream_t *st = &fr->st;
+    tsch_size_t size = st->size;
+    msg->buf = NULL;
+    msg->len = 0;
+    if( size == 0 ) return false;   // there is no buffer
+
+    for( ;; )
+    {
+        if( fr->resync )
+        {
+            // drop the bytes up to and including the next 0x07
+            tsch_size_t k = fr->start;
+            while( (k < st->have) && (st->buf[k] != 0x07) ) k++;
+            fr->resync = k >= st->have;
+            k = fr->resync ? k : k + 1;
+            fr->dropped += k - fr->start;
+            fr->start = k;
+            tausch_framer_restart( fr, size );
+            if( fr->resync ) return false;
+        }
+        while( tausch_stream_next( st ) )
+        {
+            // walk over the TLVs of message
+        }
+        if( st->eof )
+        {
+            msg->buf = &st->buf[fr->start];
+            msg->len = st->pos - fr->start;
+            fr->start = st->pos;
+            tausch_framer_restart( fr, size );
+            return true;
+        }
+        if( tausch_stream_is_ok( st ) && ( (fr->start > 0) || (st->have < size)) )
+        {
+            return false;   // wait for more
+        }
+
+        // corrupted or too big message, it is dropped starting from its first byte
+        fr->start += 1;
+        fr->dropped += 1;
+        fr->resync = true;
+    }
+}
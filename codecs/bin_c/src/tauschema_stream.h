@@ -0,0 +1,221 @@
+/*
+ * tauschema_stream.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_STREAM_H_
+#define SRC_TAUSCHEMA_STREAM_H_
+
+#include "tauschema_codec.h"
+
+/**
+ * Maximal depth of scopes the stream decoder does accept.
+ */
+#ifndef TAUSCH_STREAM_DEPTH
+#define TAUSCH_STREAM_DEPTH 16
+#endif
+
+/**
+ * Decoder of the message that arrives in pieces. The received bytes are appended to
+ * the buffer, the decoder delivers the TLVs in order of the message as soon as they have
+ * fully arrived, and tells how many bytes it needs at least before it can continue.
+ *
+ * The subscopes are entered, END of every scope is delivered. The stuffing is dropped
+ * without buffering it. The decoded bytes can be dropped from the buffer with
+ * tausch_stream_consume(), then the buffer needs to hold only the biggest TLV.
+ */
+typedef struct
+{
+    /// The iterator on the delivered TLV, it is valid until the buffer is consumed
+    tausch_iter_t iter;
+
+    /// Pointer to the buffer start
+    uint8_t *buf;
+
+    /// Size of the buffer, 0 when the decoder is broken
+    tsch_size_t size;
+
+    /// Number of bytes received into the buffer
+    tsch_size_t have;
+
+    /// Offset of the first byte not decoded yet
+    tsch_size_t pos;
+
+    /// Number of stuffing bytes still to drop from the bytes to come
+    tsch_size_t skip;
+
+    /// Number of bytes needed at least before the next TLV can be decoded
+    tsch_size_t need;
+
+    /// Offset in the message of the buffer start
+    tsch_size_t base;
+
+    /// Depth of the scope the decoder is in
+    uint16_t scope;
+
+    /// True when the EOF has been decoded
+    bool eof;
+
+    /// Offsets in the message where the sized scopes end, TSCH_NOTHING for other scopes
+    tsch_size_t end[TAUSCH_STREAM_DEPTH];
+
+} tausch_stream_t;
+
+/**
+ * Start decoding of new message.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param buf : uint8_t* - the buffer for the received bytes
+ * @param size : tsch_size_t - size of the buffer
+ * @return tausch_stream_t* - the decoder
+ */
+tausch_stream_t* tausch_stream_init( tausch_stream_t *st, uint8_t *buf, tsch_size_t size )
+;
+
+/**
+ * Return true when the decoder is not broken. Decoder is broken when the message
+ * is not valid or there is TLV that does not fit into buffer.
+ */
+bool tausch_stream_is_ok( tausch_stream_t *st )
+;
+
+/**
+ * Return the free space of buffer where the bytes are received into.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param room : tsch_size_t* - number of bytes that can be received
+ * @return uint8_t* - where to receive, NULL when decoder is broken
+ */
+uint8_t* tausch_stream_space( tausch_stream_t *st, tsch_size_t *room )
+;
+
+/**
+ * Tell the decoder that bytes have been received into the space.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @param len : tsch_size_t - number of bytes received
+ * @return bool - false when it is more than the space or the decoder is broken
+ */
+bool tausch_stream_fill( tausch_stream_t *st, tsch_size_t len )
+;
+
+/**
+ * Decode the next TLV of the message. When it returns false, then tausch_stream_need()
+ * tells how many more bytes are needed, or it is 0 at EOF or when the decoder is broken.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @return bool - true when the iterator of decoder is on the TLV
+ */
+bool tausch_stream_next( tausch_stream_t *st )
+;
+
+/**
+ * Return number of bytes that are needed at least, before the next TLV can be decoded.
+ */
+tsch_size_t tausch_stream_need( tausch_stream_t *st )
+;
+
+/**
+ * Drop the decoded bytes from the buffer and move the rest to its beginning.
+ * The iterator and the views of the delivered TLVs are not valid anymore.
+ *
+ * @param st : tausch_stream_t* - the decoder
+ * @return tsch_size_t - number of bytes dropped
+ */
+tsch_size_t tausch_stream_consume( tausch_stream_t *st )
+;
+
+/**
+ * Framer of the byte stream of messages that follow each other, every one terminated
+ * with EOF. The messages are found with the stream decoder, so each byte is decoded only
+ * once, and they are given out as slices of the buffer without copying.
+ *
+ * The buffer is used as ring, the bytes of the message not completed are moved to the
+ * beginning of buffer when the space is asked for. The corrupted bytes are dropped until
+ * the next byte 0x07 and the framing is started again from there.
+ */
+typedef struct
+{
+    /// The stream decoder over the buffer
+    tausch_stream_t st;
+
+    /// Offset of the start of the message being framed
+    tsch_size_t start;
+
+    /// Number of bytes dropped because of corruption
+    tsch_size_t dropped;
+
+    /// True while the bytes are dropped until 0x07
+    bool resync;
+
+} tausch_framer_t;
+
+/**
+ * Start framing of messages.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param buf : uint8_t* - the buffer, it must be bigger than the biggest message
+ * @param size : tsch_size_t - size of the buffer
+ * @return tausch_framer_t* - the framer
+ */
+tausch_framer_t* tausch_framer_init( tausch_framer_t *fr, uint8_t *buf, tsch_size_t size )
+;
+
+/**
+ * Return the free space of buffer where the bytes are received into. The slices of
+ * messages given out earlier are not valid anymore.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param room : tsch_size_t* - number of bytes that can be received
+ * @return uint8_t* - where to receive
+ */
+uint8_t* tausch_framer_space( tausch_framer_t *fr, tsch_size_t *room )
+;
+
+/**
+ * Tell the framer that bytes have been received into the space.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param len : tsch_size_t - number of bytes received
+ * @return bool - false when it is more than the space
+ */
+bool tausch_framer_fill( tausch_framer_t *fr, tsch_size_t len )
+;
+
+/**
+ * Find the next complete message.
+ *
+ * @param fr : tausch_framer_t* - the framer
+ * @param msg : tausch_view_t* - the slice of message including its EOF
+ * @return bool - true when message was found, false when more bytes are needed
+ */
+bool tausch_framer_next( tausch_framer_t *fr, tausch_view_t *msg )
+;
+
+#endif /* SRC_TAUSCHEMA_STREAM_H_ */
@@ -0,0 +1,247 @@
+/*
+ * tauschema_trace.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef TAUSCH_TRACE_SDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+// raised by the tracer that attaches to the probe, as generated by dtrace -G
+volatile unsigned short tauschema_done_semaphore __attribute__((section(".probes")));
+#define TRACE_PROBE( op, name, ns ) DTRACE_PROBE3( tauschema, done, op, name, ns )
+#endif
+
+#ifndef TRACE_PROBE
+#define TRACE_PROBE( op, name, ns )
+#endif
+
+static unsigned bucket( uint64_t v )
+{
+    if( v < 2 * TAUSCH_HIST_SUB ) return (unsigned)v;
+    unsigned shift = 63 - __builtin_clzll( v ) - 3;
+    return shift * TAUSCH_HIST_SUB + (unsigned)(v >> shift);
+}
+
+/**
+ * The biggest value of the bucket.
+ */
+static uint64_t bucket_high( unsigned k )
+{
+    if( k + 1 >= TAUSCH_HIST_N ) return UINT64_MAX;
+    k += 1;
+    if( k < 2 * TAUSCH_HIST_SUB ) return k - 1;
+    unsigned shift = k / TAUSCH_HIST_SUB - 1;
+    return (((uint64_t)(k % TAUSCH_HIST_SUB + TAUSCH_HIST_SUB)) << shift) - 1;
+}
+
+/**
+ * Clear the histogram.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @return tausch_hist_t* - the histogram
+ */
+tausch_hist_t* tausch_hist_clear( tausch_hist_t *h )
+{
+    for( unsigned k = 0; k < TAUSCH_HIST_N; k++ )
+    {
+        atomic_store_explicit( &h->count[k], 0, memory_order_relaxed );
+    }
+    atomic_store_explicit( &h->n, 0, memory_order_relaxed );
+    atomic_store_explicit( &h->sum, 0, memory_order_relaxed );
+    atomic_store_explicit( &h->max, 0, memory_order_relaxed );
+    return h;
+}
+
+/**
+ * Add the sample into histogram.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @param v : uint64_t - the sample, nanoseconds for the latencies
+ */
+void tausch_hist_add( tausch_hist_t *h, uint64_t v )
+{
+    atomic_fetch_add_explicit( &h->count[bucket( v )], 1, memory_order_relaxed );
+    atomic_fetch_add_explicit( &h->n, 1, memory_order_relaxed );
+    atomic_fetch_add_explicit( &h->sum, v, memory_order_relaxed );
+    uint64_t max = atomic_load_explicit( &h->max, memory_order_relaxed );
+    while( (v > max) && !atomic_compare_exchange_weak_explicit( &h->max, &max, v, memory_order_relaxed,
+        memory_order_relaxed ) )
+        ;
+}
+
+/**
+ * The value below which the p percent of samples are.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @param p : double - the percentile, 0 ... 100
+ * @return uint64_t - the value, 0 when histogram is empty
+ */
+uint64_t tausch_hist_percentile( tausch_hist_t *h, double p )
+{
+    uint64_t n = atomic_load_explicit( &h->n, memory_order_relaxed );
+    uint64_t max = atomic_load_explicit( &h->max, memory_order_relaxed );
+    if( n == 0 ) return 0;
+    if( p > 100 ) p = 100;
+    uint64_t want = (uint64_t)(p / 100 * (double)n + 0.5);
+    if( want == 0 ) want = 1;
+    uint64_t seen = 0;
+    for( unsigned k = 0; k < TAUSCH_HIST_N; k++ )
+    {
+        seen += atomic_load_explicit( &h->count[k], memory_order_relaxed );
+        if( seen >= want )
+        {
+            uint64_t high = bucket_high( k );
+            return high < max ? high : max;
+        }
+    }
+    return max;
+}
+
+/**
+ * Print the histogram as text.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @param title : const char* - the title of the histogram
+ * @param buf : char* - the buffer of text, it is 0 terminated
+ * @param size : size_t - size of the buffer
+ * @return size_t - length of the text, as with snprintf() it can be more than fits
+ */
+size_t tausch_hist_dump( tausch_hist_t *h, const char *title, char *buf, size_t size )
+{
+    size_t len = 0;
+    uint64_t n = atomic_load_explicit( &h->n, memory_order_relaxed );
+    uint64_t sum = atomic_load_explicit( &h->sum, memory_order_relaxed );
+
+#define DUMP( ... ) do { \
+        int rv = snprintf( len < size ? &buf[len] : NULL, len < size ? size - len : 0, __VA_ARGS__ ); \
+        if( rv > 0 ) len += (size_t)rv; \
+    } while( 0 )
+
+    DUMP( "%s: n %llu mean %llu p50 %llu p90 %llu p99 %llu p99.9 %llu max %llu\n", title,
+        (unsigned long long)n, (unsigned long long)(n ? sum / n : 0),
+        (unsigned long long)tausch_hist_percentile( h, 50 ), (unsigned long long)tausch_hist_percentile( h, 90 ),
+        (unsigned long long)tausch_hist_percentile( h, 99 ), (unsigned long long)tausch_hist_percentile( h, 99.9 ),
+        (unsigned long long)atomic_load_explicit( &h->max, memory_order_relaxed ) );
+    uint64_t seen = 0;
+    for( unsigned k = 0; (k < TAUSCH_HIST_N) && (n > 0); k++ )
+    {
+        uint64_t c = atomic_load_explicit( &h->count[k], memory_order_relaxed );
+        if( c == 0 ) continue;
+        seen += c;
+        DUMP( "  %20llu %12llu %7.3f%%\n", (unsigned long long)bucket_high( k ), (unsigned long long)c,
+            100.0 * (double)seen / (double)n );
+    }
+#undef DUMP
+    if( (size > 0) && (len >= size) ) buf[size - 1] = 0;
+    return len;
+}
+
+tausch_trace_f tausch_trace_hooked;
+static void *trace_ctx;
+
+/**
+ * Set the hook, NULL removes it.
+ *
+ * @param hook : tausch_trace_f - the hook
+ * @param ctx : void* - context for the hook
+ */
+void tausch_trace_hook( tausch_trace_f hook, void *ctx )
+{
+    trace_ctx = ctx;
+    tausch_trace_hooked = hook;
+}
+
+/**
+ * Monotonic time in nanoseconds.
+ */
+uint64_t tausch_trace_now( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef TAUSCH_TRACE
+
+static tausch_hist_t hist[TAUSCH_TRACE_N];
+
+static const char *op_names[TAUSCH_TRACE_N] = { "message", "write_scope", "read", "erase" };
+
+/**
+ * The latency histogram of the operation.
+ *
+ * @param op : tausch_trace_op_t - the operation
+ * @return tausch_hist_t* - the histogram
+ */
+tausch_hist_t* tausch_trace_hist( tausch_trace_op_t op )
+{
+    return (op < TAUSCH_TRACE_N) ? &hist[op] : NULL;
+}
+
+/**
+ * Print the histograms of all the operations as text.
+ *
+ * @param buf : char* - the buffer of text
+ * @param size : size_t - size of the buffer
+ * @return size_t - length of the text, it can be more than fits
+ */
+size_t tausch_trace_dump( char *buf, size_t size )
+{
+    size_t len = 0;
+    for( unsigned op = 0; op < TAUSCH_TRACE_N; op++ )
+    {
+        len += tausch_hist_dump( &hist[op], op_names[op], len < size ? &buf[len] : NULL, len < size ? size - len : 0 );
+    }
+    return len;
+}
+
+#endif
+
+/**
+ * Record the operation started at t0.
+ *
+ * @param op : tausch_trace_op_t - the operation
+ * @param name : tsch_size_t - the name index or tag
+ * @param t0 : uint64_t - the start time from tausch_trace_now()
+ */
+void tausch_trace_done( tausch_trace_op_t op, tsch_size_t name, uint64_t t0 )
+{
+    uint64_t ns = tausch_trace_now() - t0;
+    tausch_trace_f hook = tausch_trace_hooked;
+#ifdef TAUSCH_TRACE
+    tausch_hist_add( &hist[op], ns );
+#endif
+    TRACE_PROBE( op, name, ns );
+    if( hook != NULL ) hook( trace_ctx, op, name, ns );
+}
@@ -0,0 +1,223 @@
+/*
+ * tauschema_trace.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_TRACE_H_
+#define SRC_TAUSCHEMA_TRACE_H_
+
+#include "tauschema_codec.h"
+#include <stdatomic.h>
+
+/**
+ * Linear sub buckets in every power of two of the histogram, the resolution is 12.5 %.
+ */
+#define TAUSCH_HIST_SUB 8
+
+/**
+ * Number of buckets, they cover all the 64 bit values.
+ */
+#define TAUSCH_HIST_N (61 * TAUSCH_HIST_SUB + TAUSCH_HIST_SUB)
+
+/**
+ * Histogram of latencies with logarithmic buckets, as in HDR histogram. The values below
+ * 16 have the bucket each, above that every power of two is split into 8 buckets. The
+ * samples can be added from many threads at the same time.
+ */
+typedef struct
+{
+    /// Number of samples in bucket
+    _Atomic uint64_t count[TAUSCH_HIST_N];
+
+    /// Number of samples
+    _Atomic uint64_t n;
+
+    /// Sum of the samples
+    _Atomic uint64_t sum;
+
+    /// The biggest sample
+    _Atomic uint64_t max;
+
+} tausch_hist_t;
+
+/**
+ * Clear the histogram.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @return tausch_hist_t* - the histogram
+ */
+tausch_hist_t* tausch_hist_clear( tausch_hist_t *h )
+;
+
+/**
+ * Add the sample into histogram.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @param v : uint64_t - the sample, nanoseconds for the latencies
+ */
+void tausch_hist_add( tausch_hist_t *h, uint64_t v )
+;
+
+/**
+ * The value below which the p percent of samples are. It is the biggest value of
+ * the bucket, not bigger than the biggest sample.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @param p : double - the percentile, 0 ... 100
+ * @return uint64_t - the value, 0 when histogram is empty
+ */
+uint64_t tausch_hist_percentile( tausch_hist_t *h, double p )
+;
+
+/**
+ * Print the histogram as text: the line of title with count, mean, percentiles and max,
+ * followed by the line of every non empty bucket with its biggest value, count and the
+ * cumulative percent.
+ *
+ * @param h : tausch_hist_t* - the histogram
+ * @param title : const char* - the title of the histogram
+ * @param buf : char* - the buffer of text, it is 0 terminated
+ * @param size : size_t - size of the buffer
+ * @return size_t - length of the text, as with snprintf() it can be more than fits
+ */
+size_t tausch_hist_dump( tausch_hist_t *h, const char *title, char *buf, size_t size )
+;
+
+/**
+ * Operations that are traced.
+ */
+typedef enum
+{
+    /// From tausch_flater_init() until tausch_flater_next() reaches EOF, name is 0
+    TAUSCH_TRACE_MESSAGE = 0,
+
+    /// tausch_flater_write_scope(), name of the scope
+    TAUSCH_TRACE_WRITE_SCOPE,
+
+    /// tausch_flater_read(), name of the item read, 0 when not found
+    TAUSCH_TRACE_READ,
+
+    /// tausch_iter_erase(), tag of the item
+    TAUSCH_TRACE_ERASE,
+
+    TAUSCH_TRACE_N
+} tausch_trace_op_t;
+
+/**
+ * Hook called when the traced operation is done.
+ *
+ * @param ctx : void* - the context given to tausch_trace_hook()
+ * @param op : tausch_trace_op_t - the operation
+ * @param name : tsch_size_t - the name index in schema, the tag for erase
+ * @param ns : uint64_t - the latency in nanoseconds
+ */
+typedef void (*tausch_trace_f)( void *ctx, tausch_trace_op_t op, tsch_size_t name, uint64_t ns );
+
+/**
+ * The USDT probe tauschema:done(op, name, ns) is compiled in when <sys/sdt.h> is available,
+ * with or without TAUSCH_TRACE. It is a NOP until a tracer attaches and raises its semaphore.
+ */
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define TAUSCH_TRACE_SDT 1
+#endif
+#endif
+
+#ifdef TAUSCH_TRACE_SDT
+/// Semaphore of the probe tauschema:done, not 0 while a tracer is attached
+extern volatile unsigned short tauschema_done_semaphore;
+#define TAUSCH_TRACE_PROBED() (tauschema_done_semaphore != 0)
+#else
+#define TAUSCH_TRACE_PROBED() 0
+#endif
+
+/// The hook set with tausch_trace_hook(), NULL when not set
+extern tausch_trace_f tausch_trace_hooked;
+
+/**
+ * Set the hook, NULL removes it. Set it before the codec is used by the other threads.
+ *
+ * @param hook : tausch_trace_f - the hook
+ * @param ctx : void* - context for the hook
+ */
+void tausch_trace_hook( tausch_trace_f hook, void *ctx )
+;
+
+/**
+ * Monotonic time in nanoseconds.
+ */
+uint64_t tausch_trace_now( void )
+;
+
+/**
+ * Record the operation started at t0. With TAUSCH_TRACE it is added into histogram, it fires
+ * the USDT probe tauschema:done(op, name, ns) when <sys/sdt.h> is available and calls the hook.
+ *
+ * @param op : tausch_trace_op_t - the operation
+ * @param name : tsch_size_t - the name index or tag
+ * @param t0 : uint64_t - the start time from tausch_trace_now()
+ */
+void tausch_trace_done( tausch_trace_op_t op, tsch_size_t name, uint64_t t0 )
+;
+
+#ifdef TAUSCH_TRACE
+
+/**
+ * The latency histogram of the operation, the traced operations are always added.
+ *
+ * @param op : tausch_trace_op_t - the operation
+ * @return tausch_hist_t* - the histogram
+ */
+tausch_hist_t* tausch_trace_hist( tausch_trace_op_t op )
+;
+
+/**
+ * Print the histograms of all the operations as text.
+ *
+ * @param buf : char* - the buffer of text
+ * @param size : size_t - size of the buffer
+ * @return size_t - length of the text, it can be more than fits
+ */
+size_t tausch_trace_dump( char *buf, size_t size )
+;
+
+/// The operations are always timed for the histograms
+#define TAUSCH_TRACE_ON() 1
+
+#else
+
+/// The operations are timed only while the probe is attached or the hook is set
+#define TAUSCH_TRACE_ON() (TAUSCH_TRACE_PROBED() || (tausch_trace_hooked != NULL))
+
+#endif
+
+#define TAUSCH_TRACE_BEGIN( t0 ) uint64_t t0 = TAUSCH_TRACE_ON() ? tausch_trace_now() : 0
+#define TAUSCH_TRACE_END( op, name, t0 ) do { if( (t0) != 0 ) tausch_trace_done( (op), (name), (t0) ); } while( 0 )
+
+#endif /* SRC_TAUSCHEMA_TRACE_H_ */
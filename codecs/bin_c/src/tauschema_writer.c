@@ -0,0 +1,423 @@
+/*
+ * tauschema_writer.c
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tauschema_writer.h"
+#include <string.h>
+
+/**
+ * Start writing new message into the buffer.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param buf : uint8_t* - the buffer of the message
+ * @param size : tsch_size_t - size of the buffer
+ * @return tausch_writer_t* - the writer, it is broken when not even EOF fits
+ */
+tausch_writer_t* tausch_writer_init( tausch_writer_t *wr, uint8_t *buf, tsch_size_t size )
+{
+    wr->buf = buf;
+    wr->ebuf = size;
+    wr->next = 0;
+    wr->scope = 0;
+    wr->nsized = 0;
+    wr->ref = NULL;
+    wr->sref = 0;
+    wr->nref = 0;
+    wr->refd = 0;
+    if( size > 0 ) tausch_format_buf( buf );
+    return wr;
+}
+
+/**
+ * Return true when the writer is not broken.
+ */
+bool tausch_writer_is_ok( tausch_writer_t *wr )
+{
+    return (wr->ebuf > 0) && (wr->next < wr->ebuf);
+}
+
+/**
+ * Return the length of the message written, including the EOF and the referenced payloads.
+ */
+tsch_size_t tausch_writer_len( tausch_writer_t *wr )
+{
+    if( !tausch_writer_is_ok( wr ) ) return 0;
+    return wr->next + wr->refd + 1;
+}
+
+/**
+ * Return amount of free space in buffer, same as tausch_iter_buff_free() of the message.
+ */
+tsch_size_t tausch_writer_buff_free( tausch_writer_t *wr )
+{
+    if( !tausch_writer_is_ok( wr ) ) return 0;
+    return wr->ebuf - wr->next - 1;
+}
+
+/**
+ * Produce iterator over the written message, for reading or modifying it further.
+ * The iterator is broken when there are payloads referenced.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param iter : tausch_iter_t* - the iterator to initialize
+ * @return tausch_iter_t* - the iter, at the beginning of the message
+ */
+tausch_iter_t* tausch_writer_iter( tausch_writer_t *wr, tausch_iter_t *iter )
+{
+    tausch_iter_init( iter, wr->buf, wr->ebuf );
+    if( (!tausch_writer_is_ok( wr )) || (wr->nref > 0) ) iter->ebuf = 0;
+    return iter;
+}
+
+/**
+ * Find the value length that fits in front of EOF, the same way as the iterator
+ * does when it is appending at EOF.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag id
+ * @param len : tsch_size_t - the value length wanted
+ * @param exact : bool - when false, less than len may fit
+ * @return tsch_size_t - the value length to write, TSCH_NOTHING when nothing fits
+ */
+static inline tsch_size_t tausch_writer_fit( tausch_writer_t *wr, tsch_size_t tag, tsch_size_t len, bool exact )
+{
+    tsch_size_t memlen = wr->ebuf - wr->next - 1;   // the space left in front of EOF
+    tsch_size_t tlvlen = tausch_tlv_size( tag, len );
+    if( (len <= memlen) && (tlvlen >= len) && (tlvlen <= memlen) ) return len;
+    if( exact || (len == 0) ) return TSCH_NOTHING;
+    len = tausch_tlv_vlen( tag, memlen );
+    if( (len >= memlen) || (len == 0) ) return TSCH_NOTHING;
+    return len;
+}
+
+/**
+ * Encode the vluint without any checks, the space must be verified by the caller.
+ *
+ * @return number of bytes written
+ */
+static inline tsch_size_t tausch_writer_vluint( uint8_t *p, tsch_size_t val )
+{
+    tsch_size_t n = 0;
+    while( val > 0x7f )
+    {
+        p[n++] = (uint8_t)(val | 0x80);
+        val >>= 7;
+    }
+    p[n++] = (uint8_t)val;
+    return n;
+}
+
+/**
+ * Append the TLV and move the EOF behind it. The space must be verified by the caller.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param txlc : tsch_size_t - the tag with l and c bits
+ * @param value : uint8_t* - the value, NULL for value of 0x00 bytes
+ * @param len : tsch_size_t - length of the value, 0 when there is no value field
+ */
+static inline void tausch_writer_tlv( tausch_writer_t *wr, tsch_size_t txlc, uint8_t *value, tsch_size_t len )
+{
+    uint8_t *p = &wr->buf[wr->next];
+    tsch_size_t n = tausch_writer_vluint( p, txlc );
+    if( len > 0 )
+    {
+        n += tausch_writer_vluint( &p[n], len );
+        if( value == NULL )
+        {
+            memset( &p[n], 0x00, len );
+        }
+        else
+        {
+            memcpy( &p[n], value, len );
+        }
+        n += len;
+    }
+    wr->next += n;
+    tausch_format_buf( &wr->buf[wr->next] );
+}
+
+/**
+ * Open the collection or array scope.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value
+ *
+ * @return false on failure
+ */
+bool tausch_writer_scope( tausch_writer_t *wr, tsch_size_t tag )
+{
+    if( !tausch_writer_is_ok( wr ) ) return false;
+    if( tausch_writer_fit( wr, tag, 0, true ) == TSCH_NOTHING ) return false;
+    tausch_writer_tlv( wr, (tag << 2) | 1, NULL, 0 );
+    wr->scope += 1;
+    return true;
+}
+
+/**
+ * Open the sized collection or array scope, the scope that carries the length of
+ * its content. The readers can jump over it without decoding the content. The length
+ * field is reserved with the size of vluint that can hold the buffer size, and it is
+ * written when the scope is closed with tausch_writer_end().
+ *
+ * Use it only when the receiver has told with the device info that it does accept
+ * the sized scopes.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value, it must be bigger than 1
+ *
+ * @return false on failure
+ */
+bool tausch_writer_sized_scope( tausch_writer_t *wr, tsch_size_t tag )
+{
+    if( !tausch_writer_is_ok( wr ) ) return false;
+    if( tag < 2 ) return false;   // T011 and T7 are the END and EOF
+    if( wr->nsized >= TAUSCH_WRITER_SIZED ) return false;
+    tsch_size_t width = tausch_vluint_len( wr->ebuf );
+    // the tag and the length field of width bytes must fit in front of EOF
+    if( (tausch_vluint_len( tag << 2 ) + width) > (wr->ebuf - wr->next - 1) ) return false;
+
+    uint8_t *p = &wr->buf[wr->next];
+    tsch_size_t n = tausch_writer_vluint( p, (tag << 2) | 3 );
+    tausch_vluint_write( &p[n], 0, width );
+    wr->scope += 1;
+    wr->sized[wr->nsized] = wr->next + n;
+    wr->sized_scope[wr->nsized] = wr->scope;
+    wr->nsized += 1;
+    wr->next += n + width;
+    tausch_format_buf( &wr->buf[wr->next] );
+    return true;
+}
+
+/**
+ * Close lastly open scope, for sized scope the length is written.
+ *
+ * @arg wr - the writer
+ *
+ * @return false on failure, or when there is no scope open
+ */
+bool tausch_writer_end( tausch_writer_t *wr )
+{
+    if( !tausch_writer_is_ok( wr ) ) return false;
+    if( wr->scope == 0 ) return false;   // nothing to close
+    if( tausch_writer_fit( wr, 0, 0, true ) == TSCH_NOTHING ) return false;
+    tausch_writer_tlv( wr, 3, NULL, 0 );
+    if( (wr->nsized > 0) && (wr->sized_scope[wr->nsized - 1] == wr->scope) )
+    {
+        // patch the length of the content including the END
+        tsch_size_t width = tausch_vluint_len( wr->ebuf );
+        tsch_size_t lpos = wr->sized[--wr->nsized];
+        tsch_size_t len = wr->next - lpos - width;
+        for( tsch_size_t k = wr->nref; (k > 0) && (wr->ref[k - 1].at > lpos); k-- )
+        {
+            len += wr->ref[k - 1].len;   // the payloads referenced from the scope
+        }
+        tausch_vluint_write( &wr->buf[lpos], len, width );
+    }
+    wr->scope -= 1;
+    return true;
+}
+
+/**
+ * Write the boolean. When value is NULL the tag only boolean true is written.
+ *
+ * @return false on failure
+ */
+bool tausch_writer_bool( tausch_writer_t *wr, tsch_size_t tag, bool *value )
+{
+    return tausch_writer_typX( wr, tag, (uint8_t*)value, value ? sizeof(bool) : 0 ) > 0;
+}
+
+/**
+ * Write the finite value of len bytes. When value is NULL and len is 0 the null item
+ * is written, when value is NULL and len >0 the value field is filled with 0x00.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value
+ * @arg value - pointer to the value to copy the value from
+ * @arg len - length of the finite value memory field
+ *
+ * @return 0 on failure
+ * @return number of value bytes written, for null return 1
+ */
+tsch_size_t tausch_writer_typX( tausch_writer_t *wr, tsch_size_t tag, uint8_t *value, tsch_size_t len )
+{
+    if( !tausch_writer_is_ok( wr ) ) return 0;
+    if( value == NULL )
+    {
+        // tag only null, or the value field of 0x00 that may be shorter
+        len = tausch_writer_fit( wr, tag, len, false );
+        if( len == TSCH_NOTHING ) return 0;
+        tausch_writer_tlv( wr, (tag << 2) | (len > 0 ? 2 : 0), NULL, len );
+        return len > 0 ? len : 1;
+    }
+    if( len == 0 )
+    {
+        if( tausch_writer_fit( wr, tag, 0, true ) == TSCH_NOTHING ) return 0;
+        tausch_writer_tlv( wr, tag << 2, NULL, 0 );
+        return 1;
+    }
+    if( tausch_writer_fit( wr, tag, len, true ) == TSCH_NOTHING ) return 0;
+    tausch_writer_tlv( wr, (tag << 2) | 2, value, len );
+    return len;
+}
+
+/**
+ * Write the blob into the value field. As with the iterator, less data is written when
+ * the blob does not fit into buffer.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value
+ * @arg value - the pointer to blob
+ *
+ * @return 0 on failure
+ * @return size written from blob data on success
+ */
+tsch_size_t tausch_writer_blob( tausch_writer_t *wr, tsch_size_t tag, tausch_blob_t *value )
+{
+    if( !tausch_writer_is_ok( wr ) ) return 0;
+    if( value == NULL ) return 0;   // the value must be given
+    if( value->len == 0 ) return 0;   // the length shall be more than 0
+    tsch_size_t len = tausch_writer_fit( wr, tag, value->len, false );
+    if( len == TSCH_NOTHING ) return 0;
+    tausch_writer_tlv( wr, (tag << 2) | 2, value->buf, len );
+    return len;
+}
+
+/**
+ * Write the string without the 0 ending as blob.
+ *
+ * @return 0 on failure
+ * @return size written on success
+ */
+tsch_size_t tausch_writer_utf8( tausch_writer_t *wr, tsch_size_t tag, char *value )
+{
+    if( value == NULL ) return 0;
+
+    tausch_blob_t tmp = { .buf = (uint8_t*)value };
+    tmp.len = strlen( value );
+
+    return tausch_writer_blob( wr, tag, &tmp );
+}
+
+/**
+ * Attach the table of referenced payloads to the writer, it enables the tausch_writer_blob_ref().
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param ref : tausch_writer_ref_t* - the table
+ * @param size : tsch_size_t - number of entries in the table
+ * @return tausch_writer_t* - the writer
+ */
+tausch_writer_t* tausch_writer_refs( tausch_writer_t *wr, tausch_writer_ref_t *ref, tsch_size_t size )
+{
+    wr->ref = ref;
+    wr->sref = ref ? size : 0;
+    wr->nref = 0;
+    wr->refd = 0;
+    return wr;
+}
+
+/**
+ * Write the blob as reference to the caller memory. Only the tag and length are written
+ * into the buffer, the payload stays where it is until the message is sent out with
+ * tausch_writer_iovecs(). The payload is never shortened to fit.
+ *
+ * @arg wr - the writer with the table of references attached
+ * @arg tag - the tag value
+ * @arg value - the pointer to blob, its memory must be valid until the message is sent
+ *
+ * @return 0 on failure
+ * @return size of the payload on success
+ */
+tsch_size_t tausch_writer_blob_ref( tausch_writer_t *wr, tsch_size_t tag, tausch_blob_t *value )
+{
+    if( !tausch_writer_is_ok( wr ) ) return 0;
+    if( (value == NULL) || (value->len == 0) ) return 0;
+    if( wr->nref >= wr->sref ) return 0;   // no room in the table
+    tsch_size_t len = value->len;
+    tsch_size_t total = wr->next + wr->refd + 1;
+    if( (total + len) < total ) return 0;   // the message length must stay representable
+    if( (total + len) == TSCH_NOTHING ) return 0;
+    if( wr->nsized > 0 )
+    {
+        // the lengths of the open sized scopes must fit into their fields
+        tsch_size_t width = tausch_vluint_len( wr->ebuf );
+        if( (width * 7 < sizeof(tsch_size_t) * 8) && ((total + len) >> (width * 7)) ) return 0;
+    }
+    tsch_size_t hdr = tausch_vluint_len( (tag << 2) | 2 ) + tausch_vluint_len( len );
+    if( hdr > (wr->ebuf - wr->next - 1) ) return 0;
+
+    uint8_t *p = &wr->buf[wr->next];
+    tsch_size_t n = tausch_writer_vluint( p, (tag << 2) | 2 );
+    n += tausch_writer_vluint( &p[n], len );
+    wr->next += n;
+    tausch_format_buf( &wr->buf[wr->next] );
+
+    tausch_writer_ref_t *r = &wr->ref[wr->nref++];
+    r->at = wr->next;
+    r->buf = value->buf;
+    r->len = len;
+    wr->refd += len;
+    return len;
+}
+
+/**
+ * Produce the vectors of the message for writev() and sendmsg(). The buffer and the
+ * referenced payloads are taken in turns, the EOF is in the last vector.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param iov : tausch_iovec_t* - the array of vectors to fill in
+ * @param n : tsch_size_t - number of vectors in the array, 2 * nref + 1 is always enough
+ * @return tsch_size_t - number of vectors filled in, 0 on failure
+ */
+tsch_size_t tausch_writer_iovecs( tausch_writer_t *wr, tausch_iovec_t *iov, tsch_size_t n )
+{
+    if( !tausch_writer_is_ok( wr ) ) return 0;
+    tsch_size_t cnt = 0;
+    tsch_size_t from = 0;
+    for( tsch_size_t k = 0; k <= wr->nref; k++ )
+    {
+        // the buffer up to the payload, or up to and including the EOF
+        tsch_size_t to = (k < wr->nref) ? wr->ref[k].at : wr->next + 1;
+        if( to > from )
+        {
+            if( cnt >= n ) return 0;
+            iov[cnt].iov_base = &wr->buf[from];
+            iov[cnt].iov_len = to - from;
+            cnt += 1;
+        }
+        from = to;
+        if( k == wr->nref ) break;
+        if( cnt >= n ) return 0;
+        iov[cnt].iov_base = (void*)wr->ref[k].buf;
+        iov[cnt].iov_len = wr->ref[k].len;
+        cnt += 1;
+    }
+    return cnt;
+}
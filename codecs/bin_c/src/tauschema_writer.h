@@ -0,0 +1,297 @@
+/*
+ * tauschema_writer.h
+ *
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of author nor the names of
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SRC_TAUSCHEMA_WRITER_H_
+#define SRC_TAUSCHEMA_WRITER_H_
+
+#include "tauschema_codec.h"
+
+/**
+ * Maximal number of sized scopes the writer can have open at the same time.
+ */
+#ifndef TAUSCH_WRITER_SIZED
+#define TAUSCH_WRITER_SIZED 8
+#endif
+
+/**
+ * Vector of the message bytes for writev() and sendmsg(), the struct iovec where it exists.
+ */
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+typedef struct iovec tausch_iovec_t;
+#else
+typedef struct
+{
+    void *iov_base;
+    size_t iov_len;
+} tausch_iovec_t;
+#endif
+
+/**
+ * Payload of blob that is referenced from the caller memory instead of copied into message.
+ */
+typedef struct
+{
+    /// Offset in the message buffer where the payload belongs to
+    tsch_size_t at;
+
+    /// Pointer to the payload
+    const uint8_t *buf;
+
+    /// Length of the payload
+    tsch_size_t len;
+} tausch_writer_ref_t;
+
+/**
+ * Append only writer of the message. The message is serialized from the front to
+ * the back, there is no editing of the already written items. The bytes produced
+ * are the same as when the items are appended at EOF with the iterator.
+ *
+ * The message is terminated with EOF after every write, so it is valid at any time.
+ */
+typedef struct
+{
+    /// Pointer to the buffer start
+    uint8_t *buf;
+
+    /// Size of the buffer, 0 when the writer is broken
+    tsch_size_t ebuf;
+
+    /// Offset of the EOF, the next TLV is written there
+    tsch_size_t next;
+
+    /// Number of open scopes
+    uint16_t scope;
+
+    /// Number of open sized scopes
+    uint16_t nsized;
+
+    /// Offsets of the length fields of the open sized scopes, patched when the scope is closed
+    tsch_size_t sized[TAUSCH_WRITER_SIZED];
+
+    /// The scope depth of the open sized scopes
+    uint16_t sized_scope[TAUSCH_WRITER_SIZED];
+
+    /// Table of referenced payloads, NULL when not attached
+    tausch_writer_ref_t *ref;
+
+    /// Size of the ref table
+    tsch_size_t sref;
+
+    /// Number of referenced payloads
+    tsch_size_t nref;
+
+    /// Number of bytes referenced, they are not in buffer
+    tsch_size_t refd;
+
+} tausch_writer_t;
+
+/**
+ * Start writing new message into the buffer.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param buf : uint8_t* - the buffer of the message
+ * @param size : tsch_size_t - size of the buffer
+ * @return tausch_writer_t* - the writer, it is broken when not even EOF fits
+ */
+tausch_writer_t* tausch_writer_init( tausch_writer_t *wr, uint8_t *buf, tsch_size_t size )
+;
+
+/**
+ * Return true when the writer is not broken.
+ */
+bool tausch_writer_is_ok( tausch_writer_t *wr )
+;
+
+/**
+ * Return the length of the message written, including the EOF and the referenced payloads.
+ */
+tsch_size_t tausch_writer_len( tausch_writer_t *wr )
+;
+
+/**
+ * Return amount of free space in buffer, same as tausch_iter_buff_free() of the message.
+ */
+tsch_size_t tausch_writer_buff_free( tausch_writer_t *wr )
+;
+
+/**
+ * Produce iterator over the written message, for reading or modifying it further.
+ * The iterator is broken when there are payloads referenced.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param iter : tausch_iter_t* - the iterator to initialize
+ * @return tausch_iter_t* - the iter, at the beginning of the message
+ */
+tausch_iter_t* tausch_writer_iter( tausch_writer_t *wr, tausch_iter_t *iter )
+;
+
+/**
+ * Open the collection or array scope.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value
+ *
+ * @return false on failure
+ */
+bool tausch_writer_scope( tausch_writer_t *wr, tsch_size_t tag )
+;
+
+/**
+ * Open the sized collection or array scope, the scope that carries the length of
+ * its content. The readers can jump over it without decoding the content. The length
+ * field is reserved with the size of vluint that can hold the buffer size, and it is
+ * written when the scope is closed with tausch_writer_end().
+ *
+ * @attention Use it only after the peer has advertised the device info "sized". The
+ * decoders without the sized scopes, bin_php included, read the TX11 as EOF and silently
+ * drop the rest of the message.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value, it must be bigger than 1
+ *
+ * @return false on failure
+ */
+bool tausch_writer_sized_scope( tausch_writer_t *wr, tsch_size_t tag )
+;
+
+/**
+ * Close lastly open scope, for sized scope the length is written.
+ *
+ * @arg wr - the writer
+ *
+ * @return false on failure, or when there is no scope open
+ */
+bool tausch_writer_end( tausch_writer_t *wr )
+;
+
+/**
+ * Write the boolean. When value is NULL the tag only boolean true is written.
+ *
+ * @return false on failure
+ */
+bool tausch_writer_bool( tausch_writer_t *wr, tsch_size_t tag, bool *value )
+;
+
+/**
+ * Write the finite value of len bytes. When value is NULL and len is 0 the null item
+ * is written, when value is NULL and len >0 the value field is filled with 0x00.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value
+ * @arg value - pointer to the value to copy the value from
+ * @arg len - length of the finite value memory field
+ *
+ * @return 0 on failure
+ * @return number of value bytes written, for null return 1
+ */
+tsch_size_t tausch_writer_typX( tausch_writer_t *wr, tsch_size_t tag, uint8_t *value, tsch_size_t len )
+;
+
+/**
+ * Write the blob into the value field. As with the iterator, less data is written when
+ * the blob does not fit into buffer.
+ *
+ * @arg wr - the writer
+ * @arg tag - the tag value
+ * @arg value - the pointer to blob
+ *
+ * @return 0 on failure
+ * @return size written from blob data on success
+ */
+tsch_size_t tausch_writer_blob( tausch_writer_t *wr, tsch_size_t tag, tausch_blob_t *value )
+;
+
+/**
+ * Write the string without the 0 ending as blob.
+ *
+ * @return 0 on failure
+ * @return size written on success
+ */
+tsch_size_t tausch_writer_utf8( tausch_writer_t *wr, tsch_size_t tag, char *value )
+;
+
+/**
+ * Attach the table of referenced payloads to the writer, it enables the tausch_writer_blob_ref().
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param ref : tausch_writer_ref_t* - the table
+ * @param size : tsch_size_t - number of entries in the table
+ * @return tausch_writer_t* - the writer
+ */
+tausch_writer_t* tausch_writer_refs( tausch_writer_t *wr, tausch_writer_ref_t *ref, tsch_size_t size )
+;
+
+/**
+ * Write the blob as reference to the caller memory. Only the tag and length are written
+ * into the buffer, the payload stays where it is until the message is sent out with
+ * tausch_writer_iovecs(). The payload is never shortened to fit.
+ *
+ * @arg wr - the writer with the table of references attached
+ * @arg tag - the tag value
+ * @arg value - the pointer to blob, its memory must be valid until the message is sent
+ *
+ * @return 0 on failure
+ * @return size of the payload on success
+ */
+tsch_size_t tausch_writer_blob_ref( tausch_writer_t *wr, tsch_size_t tag, tausch_blob_t *value )
+;
+
+/**
+ * Produce the vectors of the message for writev() and sendmsg(). The buffer and the
+ * referenced payloads are taken in turns, the EOF is in the last vector.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param iov : tausch_iovec_t* - the array of vectors to fill in
+ * @param n : tsch_size_t - number of vectors in the array, 2 * nref + 1 is always enough
+ * @return tsch_size_t - number of vectors filled in, 0 on failure
+ */
+tsch_size_t tausch_writer_iovecs( tausch_writer_t *wr, tausch_iovec_t *iov, tsch_size_t n )
+;
+
+/**
+ * Methods for copying data from memory to the message, same as tausch_iter_write()
+ *
+ * @arg wr - pointer to writer object
+ * @arg tag - value of the tag
+ * @arg var - pointer to variable field
+ *
+ * @return 0 on failure
+ * @return number of value bytes written
+ */
+#define tausch_writer_write( wr, tag, value ) _Generic((value), \
+    bool*:          tausch_writer_bool( (wr), (size_t)(tag), (bool*)(value) ), \
+    char*:          tausch_writer_utf8( (wr), (size_t)(tag), (char*)(value) ), \
+    tausch_blob_t*: tausch_writer_blob( (wr), (size_t)(tag), (tausch_blob_t*)(value) ), \
+    default:        tausch_writer_typX( (wr), (size_t)(tag), (uint8_t*)(value), sizeof((value)[0]) ) \
+)
+
+#endif /* SRC_TAUSCHEMA_WRITER_H_ */
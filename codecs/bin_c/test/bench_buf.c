@@ -0,0 +1,446 @@
+#include "benchmain.h"
+#include "../src/tauschema_codec.h"
+#include "../src/tauschema_index.h"
+#include "../src/tauschema_writer.h"
+#include "../src/tauschema_stream.h"
+
+static uint8_t msg[4096];   // the reference message
+static size_t msg_len = 0;   // bytes used by the message including EOF
+static uint32_t msg_items = 0;   // collections in the message
+static uint8_t work[4096];   // the message that benchmarks modify
+
+/**
+ * Compose the reference message: root scope of small collections holding
+ * numbers, a blob and a boolean. When items is 0 the buffer is filled up.
+ */
+static size_t compose( uint8_t *buf, size_t size, uint32_t *items, uint64_t *tlvs )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( buf, size );
+    uint8_t blob_buf[16];
+    tausch_blob_t blob = { .buf = blob_buf, .len = sizeof(blob_buf) };
+    memset( blob_buf, 0x5a, sizeof(blob_buf) );
+    uint64_t n = 0;
+
+    tausch_format_buf( buf );
+    uint32_t i = 0;
+    for( ; *items ? (i < *items) : (tausch_iter_buff_free( &iter ) > 40); i++ )
+    {
+        uint32_t u32 = i;
+        uint16_t u16 = (uint16_t)i;
+        (void)tausch_iter_next( &iter );
+        (void)tausch_iter_write_scope( &iter, 5 + (i & 7) );
+        (void)tausch_iter_enter_scope( &iter );
+        (void)tausch_iter_next( &iter );
+        (void)tausch_iter_write( &iter, 1, &u32 );
+        (void)tausch_iter_next( &iter );
+        (void)tausch_iter_write( &iter, 2, &u16 );
+        (void)tausch_iter_next( &iter );
+        (void)tausch_iter_write( &iter, 3, &blob );
+        (void)tausch_iter_next( &iter );
+        (void)tausch_iter_write( &iter, 4, (bool*)NULL );
+        (void)tausch_iter_next( &iter );
+        (void)tausch_iter_write_end( &iter );
+        (void)tausch_iter_exit_scope( &iter );
+        n += 6;
+    }
+    (void)tausch_iter_next( &iter );
+    *items = i;
+    if( tlvs ) *tlvs = n;
+    return iter.idx + 1;
+}
+
+/**
+ * Compose the same message as compose() with the append only writer. With sized
+ * the collections are written as sized scopes.
+ */
+static size_t compose_writer( uint8_t *buf, size_t size, uint32_t items, uint64_t *tlvs, bool sized )
+{
+    tausch_writer_t wr;
+    uint8_t blob_buf[16];
+    tausch_blob_t blob = { .buf = blob_buf, .len = sizeof(blob_buf) };
+    memset( blob_buf, 0x5a, sizeof(blob_buf) );
+    uint64_t n = 0;
+
+    tausch_writer_init( &wr, buf, size );
+    for( uint32_t i = 0; i < items; i++ )
+    {
+        uint32_t u32 = i;
+        uint16_t u16 = (uint16_t)i;
+        (void)(sized ? tausch_writer_sized_scope( &wr, 5 + (i & 7) ) : tausch_writer_scope( &wr, 5 + (i & 7) ));
+        (void)tausch_writer_write( &wr, 1, &u32 );
+        (void)tausch_writer_write( &wr, 2, &u16 );
+        (void)tausch_writer_write( &wr, 3, &blob );
+        (void)tausch_writer_write( &wr, 4, (bool*)NULL );
+        (void)tausch_writer_end( &wr );
+        n += 6;
+    }
+    if( tlvs ) *tlvs = n;
+    return tausch_writer_len( &wr );
+}
+
+static void b_iter_decode( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg, msg_len );
+    uint64_t n = 0;
+    for( ;; )
+    {
+        if( tausch_iter_next( &iter ) )
+        {
+            n += iter.tag;
+            if( tausch_iter_is_scope( &iter ) ) (void)tausch_iter_enter_scope( &iter );
+        }
+        else if( tausch_iter_is_ok( &iter ) && tausch_iter_is_end( &iter ) && !tausch_iter_is_eof( &iter ) )
+        {
+            (void)tausch_iter_exit_scope( &iter );
+        }
+        else
+        {
+            break;
+        }
+        cnt->ops += 1;
+    }
+    bench_sink += n;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_stream_decode( void *ctx, bench_count_t *cnt )
+{
+    uint8_t buf[128];
+    tausch_stream_t st;
+    size_t sent = 0;
+    uint64_t n = 0;
+    // the same message as iter_decode, received in chunks of 64 bytes
+    tausch_stream_init( &st, buf, sizeof(buf) );
+    for( ;; )
+    {
+        if( tausch_stream_next( &st ) )
+        {
+            n += st.iter.tag;
+            cnt->ops += 1;
+            continue;
+        }
+        if( st.eof || (!tausch_stream_is_ok( &st )) || (sent >= msg_len) ) break;
+        tsch_size_t room;
+        (void)tausch_stream_consume( &st );
+        uint8_t *p = tausch_stream_space( &st, &room );
+        tsch_size_t c = (msg_len - sent) < 64 ? (tsch_size_t)(msg_len - sent) : 64;
+        c = c < room ? c : room;
+        memcpy( p, &msg[sent], c );
+        sent += c;
+        (void)tausch_stream_fill( &st, c );
+    }
+    bench_sink += n;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static uint8_t flow[4096];   // small messages back to back
+static size_t flow_len = 0;
+
+static void b_framer( void *ctx, bench_count_t *cnt )
+{
+    uint8_t buf[512];
+    tausch_framer_t fr;
+    tausch_view_t view;
+    size_t sent = 0;
+    // received in chunks of 256 bytes
+    tausch_framer_init( &fr, buf, bench_msg_max( sizeof(buf) ) );
+    while( sent < flow_len )
+    {
+        tsch_size_t room;
+        uint8_t *p = tausch_framer_space( &fr, &room );
+        tsch_size_t c = (flow_len - sent) < 256 ? (tsch_size_t)(flow_len - sent) : 256;
+        c = c < room ? c : room;
+        if( c == 0 ) break;   // the framer is stuck
+        memcpy( p, &flow[sent], c );
+        sent += c;
+        (void)tausch_framer_fill( &fr, c );
+        while( tausch_framer_next( &fr, &view ) )
+        {
+            bench_sink += view.len;
+            cnt->msgs += 1;
+            cnt->ops += 1;
+        }
+    }
+    cnt->bytes += flow_len;
+}
+
+static void b_iter_encode( void *ctx, bench_count_t *cnt )
+{
+    uint64_t n = 0;
+    uint32_t items = msg_items;
+    bench_sink += compose( work, msg_len, &items, &n );
+    cnt->ops += n;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_writer_encode( void *ctx, bench_count_t *cnt )
+{
+    uint64_t n = 0;
+    bench_sink += compose_writer( work, msg_len, msg_items, &n, false );
+    cnt->ops += n;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_iter_erase( void *ctx, bench_count_t *cnt )
+{
+    memcpy( work, msg, msg_len );
+    tausch_iter_t iter = TAUSCH_ITER_INIT( work, msg_len );
+    while( tausch_iter_next( &iter ) )
+    {
+        if( tausch_iter_is_stuffing( &iter ) ) continue;
+        // erase the first member of the collection
+        tausch_iter_t sub = iter;
+        (void)tausch_iter_enter_scope( &sub );
+        if( tausch_iter_next( &sub ) && tausch_iter_erase( &sub ) ) cnt->ops += 1;
+    }
+    bench_sink += work[0];
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static uint8_t msg_holes[4096];   // the reference message with first members of collections erased
+
+static void b_iter_compact( void *ctx, bench_count_t *cnt )
+{
+    memcpy( work, msg_holes, msg_len );
+    tausch_iter_t iter = TAUSCH_ITER_INIT( work, msg_len );
+    bench_sink += tausch_iter_compact( &iter );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static tausch_hole_t msg_hole_entries[1024];
+static tausch_holes_t msg_hole_index = { .hole = msg_hole_entries };
+static tausch_iter_t msg_holes_iter;   // iterator of msg_holes with the hole index attached
+
+static void b_iter_go_to_stuffing( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg_holes, msg_len );
+    // first fit, the holes are inside the collections so the root is walked up to EOF
+    bench_sink += tausch_iter_go_to_stuffing( &iter );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_iter_go_to_hole( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = msg_holes_iter;
+    // the same search driven by the hole index, no hole at root fits
+    bench_sink += tausch_iter_go_to_hole( &iter, 6 );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_iter_go_to( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg, msg_len );
+    // tag 4 is never at root, so the full root scope is scanned
+    bench_sink += tausch_iter_go_to_tag( &iter, 4 );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static uint8_t msg_sized[8192];   // the reference message with sized scopes, the lengths take space
+static size_t msg_sized_len = 0;
+
+static void b_iter_go_to_sized( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg_sized, msg_sized_len );
+    // the same search as iter_go_to_tag, the collections are jumped over
+    bench_sink += tausch_iter_go_to_tag( &iter, 4 );
+    cnt->ops += 1;
+    cnt->bytes += msg_sized_len;
+    cnt->msgs += 1;
+}
+
+static void b_iter_buff_free( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg, msg_len );
+    bench_sink += tausch_iter_buff_free( &iter );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static tsch_size_t msg_eof = TSCH_NOTHING;   // tracker of the msg EOF
+static tausch_iter_t msg_tracked;   // iterator sharing the msg_eof tracker
+
+static void b_iter_buff_free_tracked( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = msg_tracked;
+    bench_sink += tausch_iter_buff_free( &iter );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static uint8_t msg_big[4096];   // message of single big blob as forwarded by gateways
+static uint8_t big_copy[4096];
+static size_t msg_big_len = 0;
+
+static void b_iter_read_blob( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg_big, msg_big_len );
+    tausch_blob_t blob = { .buf = big_copy, .len = (tsch_size_t)bench_msg_max( sizeof(big_copy) ) };
+    (void)tausch_iter_next( &iter );
+    bench_sink += tausch_iter_read_blob( &iter, &blob );
+    cnt->ops += 1;
+    cnt->bytes += msg_big_len;
+    cnt->msgs += 1;
+}
+
+static void b_iter_view( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg_big, msg_big_len );
+    tausch_view_t view;
+    (void)tausch_iter_next( &iter );
+    bench_sink += tausch_iter_view( &iter, &view ) ? view.len : 0;
+    cnt->ops += 1;
+    cnt->bytes += msg_big_len;
+    cnt->msgs += 1;
+}
+
+static void b_writer_blob( void *ctx, bench_count_t *cnt )
+{
+    tausch_writer_t wr;
+    tausch_blob_t big = { .buf = big_copy, .len = msg_big_len - 8 };
+    tausch_writer_init( &wr, work, msg_big_len );
+    bench_sink += tausch_writer_write( &wr, 1, &big );
+    cnt->ops += 1;
+    cnt->bytes += msg_big_len;
+    cnt->msgs += 1;
+}
+
+static void b_writer_blob_ref( void *ctx, bench_count_t *cnt )
+{
+    tausch_writer_t wr;
+    tausch_writer_ref_t ref[1];
+    tausch_iovec_t iov[3];
+    tausch_blob_t big = { .buf = big_copy, .len = msg_big_len - 8 };
+    // the same message as writer_blob, handed out as vectors
+    tausch_writer_init( &wr, work, 16 );
+    tausch_writer_refs( &wr, ref, 1 );
+    bench_sink += tausch_writer_blob_ref( &wr, 1, &big );
+    bench_sink += tausch_writer_iovecs( &wr, iov, 3 );
+    cnt->ops += 1;
+    cnt->bytes += msg_big_len;
+    cnt->msgs += 1;
+}
+
+static tausch_index_entry_t index_entries[4096];
+static tausch_index_t index_msg = { .entry = index_entries };
+
+static void b_index_build( void *ctx, bench_count_t *cnt )
+{
+    bench_sink += tausch_index_build( &index_msg, msg, msg_len );
+    cnt->ops += index_msg.count;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_index_go_to( void *ctx, bench_count_t *cnt )
+{
+    // the same search as iter_go_to_tag, driven by the index
+    bench_sink += tausch_index_go_to_tag( &index_msg, 0, 4 );
+    cnt->ops += 1;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static uint8_t vlu_buf[4096];
+static size_t vlu_len = 0;
+static uint64_t vlu_count = 0;
+
+static void b_vluint_decode( void *ctx, bench_count_t *cnt )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( vlu_buf, vlu_len );
+    tsch_size_t sum = 0;
+    for( uint64_t i = 0; i < vlu_count; i++ )
+    {
+        iter.val = iter.next;
+        sum += tausch_iter_decode_vluint( &iter );
+    }
+    bench_sink += sum;
+    cnt->ops += vlu_count;
+    cnt->bytes += vlu_len;
+}
+
+void bench_buf( void )
+{
+    msg_len = compose( msg, bench_msg_max( sizeof(msg) ), &msg_items, NULL );
+
+    if( (compose_writer( work, msg_len, msg_items, NULL, false ) != msg_len) || (memcmp( work, msg, msg_len ) != 0) )
+    {
+        printf( "the writer did not produce the same message\n" );
+    }
+
+    bench_count_t none = { 0 };
+    b_iter_erase( NULL, &none );
+    memcpy( msg_holes, work, msg_len );
+
+    msg_holes_iter = (tausch_iter_t)TAUSCH_ITER_INIT( msg_holes, msg_len );
+    msg_hole_index.size = bench_msg_max( sizeof(msg_hole_entries) / sizeof(msg_hole_entries[0]) );
+    (void)tausch_iter_holes( &msg_holes_iter, &msg_hole_index );
+
+    msg_sized_len = compose_writer( msg_sized, bench_msg_max( sizeof(msg_sized) ), msg_items, NULL, true );
+
+    // mix of one to three byte tag and length values
+    tausch_iter_t iter = TAUSCH_ITER_INIT( vlu_buf, bench_msg_max( sizeof(vlu_buf) ) );
+    for( uint32_t i = 0; iter.next + 8 < iter.ebuf; i++ )
+    {
+        tsch_size_t v = (tsch_size_t)((i * 2654435761u) >> (i % 3 == 0 ? 25 : 18));
+        iter.val = iter.next;
+        (void)tausch_iter_encode_vluint( &iter, v );
+        vlu_count += 1;
+    }
+    vlu_len = iter.next;
+
+    tausch_writer_t wr;
+    tausch_blob_t big = { .buf = big_copy, .len = bench_msg_max( sizeof(msg_big) ) - 8 };
+    memset( big_copy, 0xa5, sizeof(big_copy) );
+    tausch_writer_init( &wr, msg_big, bench_msg_max( sizeof(msg_big) ) );
+    (void)tausch_writer_write( &wr, 1, &big );
+    msg_big_len = tausch_writer_len( &wr );
+
+    uint32_t few = 3;
+    size_t one = compose( work, bench_msg_max( sizeof(work) ), &few, NULL );
+    for( flow_len = 0; (flow_len + one) <= bench_msg_max( sizeof(flow) ); flow_len += one )
+    {
+        memcpy( &flow[flow_len], work, one );
+    }
+
+    msg_tracked = (tausch_iter_t)TAUSCH_ITER_INIT( msg, msg_len );
+    (void)tausch_iter_buff_free( tausch_iter_track( &msg_tracked, &msg_eof ) );
+
+    index_msg.size = bench_msg_max( sizeof(index_entries) / sizeof(index_entries[0]) );
+    if( !tausch_index_build( &index_msg, msg, msg_len ) ) printf( "indexing the message failed\n" );
+
+    bench( "iter_decode", b_iter_decode, NULL );
+    bench( "stream_decode", b_stream_decode, NULL );
+    bench( "framer", b_framer, NULL );
+    bench( "iter_encode", b_iter_encode, NULL );
+    bench( "writer_encode", b_writer_encode, NULL );
+    bench( "iter_erase", b_iter_erase, NULL );
+    bench( "iter_compact", b_iter_compact, NULL );
+    bench( "iter_go_to_stuffing", b_iter_go_to_stuffing, NULL );
+    bench( "iter_go_to_hole", b_iter_go_to_hole, NULL );
+    bench( "iter_go_to_tag", b_iter_go_to, NULL );
+    bench( "iter_go_to_tag_sized", b_iter_go_to_sized, NULL );
+    bench( "iter_buff_free", b_iter_buff_free, NULL );
+    bench( "iter_buff_free_tracked", b_iter_buff_free_tracked, NULL );
+    bench( "iter_read_blob", b_iter_read_blob, NULL );
+    bench( "iter_view", b_iter_view, NULL );
+    bench( "writer_blob", b_writer_blob, NULL );
+    bench( "writer_blob_ref", b_writer_blob_ref, NULL );
+    bench( "vluint_decode", b_vluint_decode, NULL );
+    bench( "index_build", b_index_build, NULL );
+    bench( "index_go_to_tag", b_index_go_to, NULL );
+}
@@ -0,0 +1,100 @@
+#include "benchmain.h"
+#include "../src/tauschema_codec.h"
+
+/**
+ * The corpus is produced by schemacheck.py --corpus, it contains messages back to back,
+ * each one terminated with T7.
+ */
+static uint8_t *corpus = NULL;
+static size_t corpus_len = 0;
+static size_t *corpus_msg = NULL;   // offsets of the messages, last one is corpus_len
+static size_t corpus_count = 0;
+
+/**
+ * Walk the full message tree, return number of TLV seen.
+ */
+static uint64_t walk( uint8_t *buf, size_t len )
+{
+    tausch_iter_t iter = TAUSCH_ITER_INIT( buf, len );
+    uint64_t n = 0;
+    for( ;; )
+    {
+        if( tausch_iter_next( &iter ) )
+        {
+            n += 1;
+            if( tausch_iter_is_scope( &iter ) ) (void)tausch_iter_enter_scope( &iter );
+        }
+        else if( tausch_iter_is_ok( &iter ) && tausch_iter_is_end( &iter ) && !tausch_iter_is_eof( &iter ) )
+        {
+            (void)tausch_iter_exit_scope( &iter );
+        }
+        else
+        {
+            break;
+        }
+    }
+    return tausch_iter_is_eof( &iter ) ? n : 0;
+}
+
+static void b_corpus_decode( void *ctx, bench_count_t *cnt )
+{
+    for( size_t i = 0; i < corpus_count; i++ )
+    {
+        cnt->ops += walk( &corpus[corpus_msg[i]], corpus_msg[i + 1] - corpus_msg[i] );
+    }
+    cnt->bytes += corpus_len;
+    cnt->msgs += corpus_count;
+}
+
+/**
+ * Load the corpus and find the message boundaries.
+ *
+ * @return false when the file can not be used
+ */
+static bool corpus_load( const char *path )
+{
+    FILE *f = fopen( path, "rb" );
+    if( f == NULL ) return false;
+    fseek( f, 0, SEEK_END );
+    long size = ftell( f );
+    fseek( f, 0, SEEK_SET );
+    if( size <= 0 )
+    {
+        fclose( f );
+        return false;
+    }
+    corpus = malloc( (size_t)size );
+    corpus_msg = malloc( ((size_t)size + 1) * sizeof(size_t) );
+    corpus_len = fread( corpus, 1, (size_t)size, f );
+    fclose( f );
+
+    size_t off = 0;
+    corpus_count = 0;
+    while( off < corpus_len )
+    {
+        // messages longer than tsch_size_t can address are not decodable
+        tausch_iter_t iter = TAUSCH_ITER_INIT( &corpus[off], bench_msg_max( corpus_len - off ) );
+        (void)tausch_iter_exit_scope( &iter );
+        if( !tausch_iter_is_ok( &iter ) || !tausch_iter_is_eof( &iter ) )
+        {
+            printf( "corpus message %ld at offset %ld is not decodable with this tsch_size_t\n", corpus_count, off );
+            break;
+        }
+        corpus_msg[corpus_count++] = off;
+        off += iter.idx + 1;
+    }
+    corpus_msg[corpus_count] = off;
+    corpus_len = off;
+    return corpus_count > 0;
+}
+
+void bench_corpus( const char *path )
+{
+    if( !corpus_load( path ) )
+    {
+        printf( "corpus %s was not loaded\n", path );
+        return;
+    }
+    printf( "corpus %s has %ld messages of %ld bytes\n", path, corpus_count, corpus_len );
+    bench( "corpus_decode", b_corpus_decode, NULL );
+}
@@ -0,0 +1,354 @@
+#include "benchmain.h"
+#include "../src/tauschema_check.h"
+#include "../src/tauschema_batch.h"
+#include "../src/tauschema_json.h"
+#include "tauschema_device_info_schema.h"
+#include "tauschema_json_sample_schema.h"
+#include "tauschema_device_info_structs.h"
+
+static uint8_t msg[4096];   // the reference message
+static size_t msg_len = 0;   // bytes used by the message including EOF
+static uint8_t work[4096];   // the message the benchmarks modify
+
+// the flaterator writes are given this much space, the single byte length of
+// the stuffing keeps the uint8_t build comparable with the others
+#define FLATER_SPACE 120
+static tausch_schema_t devinfo_schema;
+static tausch_schema_t indexed_schema;   // the same with the lookup tables of scopes
+static tsch_size_t lookup[400];
+static tausch_schema_t expanded_schema;   // the same with the rows decoded once
+static tausch_schema_row_t expanded[100];
+static tsch_size_t expanded_slot[400];
+
+#define BATCH_N 200
+static tausch_view_t batch[BATCH_N];   // the reference message repeated
+static uint8_t root[BATCH_N * 32];   // the info collection repeated in root scope
+static tsch_size_t root_len = 0;
+static tsch_size_t root_off[BATCH_N];   // offsets of the elements in root
+
+/**
+ * Write the info collection with the flaterator, return number of fields written.
+ */
+static tausch_schema_t sample_schema;   // the schema with names
+static tausch_schema_t hashed_schema;   // the same with the perfect hash of names
+static tsch_size_t hash[100];
+
+static void b_name_n( void *ctx, bench_count_t *cnt )
+{
+    static char *names[] = { "big", "count", "flag", "label", "level", "mark", "offset", "origin",
+        "path", "point", "ratio", "raw", "sample", "small", "x", "y" };
+    uint64_t n = 0;
+    for( size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++ )
+    {
+        n += tausch_schema_name_n( (tausch_schema_t*)ctx, names[i] );
+    }
+    bench_sink += n;
+    cnt->ops += sizeof(names) / sizeof(names[0]);
+    cnt->msgs += 1;
+}
+
+static uint64_t write_info( tausch_flater_t *fl )
+{
+    uint64_t n = 0;
+    bool ok = true;
+    ok = ok && TAUSCH_FLATER_WRITE_SCOPE( fl, TAUSCH_NAM_DEVICE_INFO_info )
+    {
+        uint32_t mslen = 1400;
+        ok = ok && (tausch_flater_write( sfl, TAUSCH_NAM_DEVICE_INFO_msglen, &mslen ) > 0);
+        ok = ok && TAUSCH_FLATER_WRITE_SCOPE( sfl, TAUSCH_NAM_DEVICE_INFO_serial )
+        {
+            uint8_t orig = 0;
+            ok = ok && (tausch_flater_write( sfl, TAUSCH_NAM_DEVICE_INFO_orig, &orig ) > 0);
+            ok = ok && (tausch_flater_write( sfl, TAUSCH_NAM_DEVICE_INFO_data, "SN-0123456789" ) > 0);
+            return ok;
+        }
+        TAUSCH_FLATER_CLOSE_SCOPE;
+        return ok;
+    }
+    TAUSCH_FLATER_CLOSE_SCOPE;
+    if( ok ) n += 5;
+    return n;
+}
+
+static void b_flater_next( void *ctx, bench_count_t *cnt )
+{
+    tausch_flater_t fl;
+    uint64_t n = 0;
+    tausch_flater_init( &fl, (tausch_schema_t*)ctx, msg, msg_len );
+    while( tausch_iter_is_ok( &tausch_flater_next( &fl )->iter ) && !tausch_iter_is_end( &fl.iter ) )
+    {
+        tausch_flater_t fc = tausch_flater_clone( &fl );
+        while( tausch_iter_is_ok( &tausch_flater_next( &fc )->iter ) && !tausch_iter_is_end( &fc.iter ) )
+        {
+            n += tausch_flater_tag_n( &fc );
+            cnt->ops += 1;
+        }
+        cnt->ops += 1;
+    }
+    bench_sink += n;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_flater_read( void *ctx, bench_count_t *cnt )
+{
+    tausch_flater_t fl;
+    uint32_t u32 = 0;
+    TAUSCH_BLOB_NEW( blob, 32 );
+    tausch_flater_init( &fl, (tausch_schema_t*)ctx, msg, msg_len );
+    bench_sink += tausch_flater_read( &fl, &u32, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen );
+    bench_sink += tausch_flater_read( &fl, &blob, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_serial,
+        TAUSCH_NAM_DEVICE_INFO_data );
+    bench_sink += u32;
+    cnt->ops += 2;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_flater_view( void *ctx, bench_count_t *cnt )
+{
+    tausch_flater_t fl;
+    uint32_t u32 = 0;
+    tausch_view_t view;
+    tausch_flater_init( &fl, &devinfo_schema, msg, msg_len );
+    // the same reads as flater_read, the blob is not copied
+    bench_sink += tausch_flater_read( &fl, &u32, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen );
+    bench_sink += tausch_flater_view( &fl, &view, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_serial,
+        TAUSCH_NAM_DEVICE_INFO_data );
+    bench_sink += u32 + view.len;
+    cnt->ops += 2;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_flater_write( void *ctx, bench_count_t *cnt )
+{
+    tausch_flater_t fl;
+    tausch_format_buf( work );
+    tausch_flater_init( &fl, &devinfo_schema, work, FLATER_SPACE );
+    cnt->ops += write_info( &fl );
+    bench_sink += work[0];
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_structs_decode( void *ctx, bench_count_t *cnt )
+{
+    tausch_device_info_t d;
+    // the same values as flater_read, all the message is decoded
+    if( tausch_device_info_decode( &d, msg, msg_len ) )
+    {
+        bench_sink += d.info.msglen + d.info.serial.data.len;
+    }
+    cnt->ops += 2;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static void b_structs_encode( void *ctx, bench_count_t *cnt )
+{
+    tausch_device_info_t d = {
+        .has_info = 1,
+        .info = {
+            .has_msglen = 1, .msglen = 1400,
+            .has_serial = 1, .serial = {
+                .has_orig = 1, .orig = 0,
+                .has_data = 1, .data = { .buf = (const uint8_t*)"SN-0123456789", .len = 13 }
+            }
+        }
+    };
+    // the same content as flater_write
+    bench_sink += tausch_device_info_encode( &d, work, FLATER_SPACE );
+    cnt->ops += 5;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static bool batch_read( tausch_cflater_t *cfl, size_t n, void *ctx )
+{
+    uint32_t u32 = 0;
+    tausch_view_t view;
+    bool ok = tausch_cflater_read( cfl, &u32, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) > 0;
+    ok = ok && tausch_cflater_view( cfl, &view, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_serial,
+        TAUSCH_NAM_DEVICE_INFO_data );
+    return ok && (u32 + view.len > 0);
+}
+
+static void b_batch_serial( void *ctx, bench_count_t *cnt )
+{
+    size_t ok = 0;
+    for( size_t i = 0; i < BATCH_N; i++ )
+    {
+        tausch_cflater_t cfl;
+        if( tausch_cflater_init( &cfl, &devinfo_schema, batch[i].buf, batch[i].len ) && batch_read( &cfl, i, NULL ) )
+        {
+            ok += 1;
+        }
+    }
+    bench_sink += ok;
+    cnt->ops += BATCH_N;
+    cnt->bytes += BATCH_N * msg_len;
+    cnt->msgs += BATCH_N;
+}
+
+static void b_batch_pool( void *ctx, bench_count_t *cnt )
+{
+    bench_sink += tausch_pool_run( ctx, &devinfo_schema, batch, BATCH_N, batch_read, NULL );
+    cnt->ops += BATCH_N;
+    cnt->bytes += BATCH_N * msg_len;
+    cnt->msgs += BATCH_N;
+}
+
+static bool root_read( tausch_cflater_t *cfl, size_t n, void *ctx )
+{
+    // the flaterator is on the info collection
+    uint32_t u32 = 0;
+    tausch_view_t view;
+    bool ok = tausch_cflater_read( cfl, &u32, TAUSCH_NAM_DEVICE_INFO_msglen ) > 0;
+    ok = ok && tausch_cflater_view( cfl, &view, TAUSCH_NAM_DEVICE_INFO_serial, TAUSCH_NAM_DEVICE_INFO_data );
+    return ok && (u32 + view.len > 0);
+}
+
+static void b_root_elements( void *ctx, bench_count_t *cnt )
+{
+    bench_sink += tausch_batch_elements( root, root_len, root_off, BATCH_N );
+    cnt->ops += BATCH_N;
+    cnt->bytes += root_len;
+    cnt->msgs += 1;
+}
+
+static void b_root_serial( void *ctx, bench_count_t *cnt )
+{
+    tausch_cflater_t cfl;
+    size_t ok = 0;
+    tausch_cflater_init( &cfl, &devinfo_schema, root, root_len );
+    for( size_t i = 0; i < BATCH_N; i++ )
+    {
+        tausch_cflater_seek( &cfl, root_off[i] );
+        if( root_read( &cfl, i, NULL ) ) ok++;
+    }
+    bench_sink += ok;
+    cnt->ops += BATCH_N;
+    cnt->bytes += root_len;
+    cnt->msgs += 1;
+}
+
+static void b_root_pool( void *ctx, bench_count_t *cnt )
+{
+    bench_sink += tausch_pool_run_elements( ctx, &devinfo_schema, root, root_len, root_off, BATCH_N, root_read, NULL );
+    cnt->ops += BATCH_N;
+    cnt->bytes += root_len;
+    cnt->msgs += 1;
+}
+
+static void b_json_encode( void *ctx, bench_count_t *cnt )
+{
+    char text[512];
+    tausch_json_t js;
+    tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+    bench_sink += tausch_json_encode( &js, &devinfo_schema, msg, msg_len );
+    cnt->ops += 5;
+    cnt->bytes += msg_len;
+    cnt->msgs += 1;
+}
+
+static char json_text[512];   // the reference message as JSON
+static size_t json_len;
+static tausch_json_keys_t json_keys;
+
+static void b_json_decode( void *ctx, bench_count_t *cnt )
+{
+    tausch_writer_t wr;
+    tausch_writer_init( &wr, work, bench_msg_max( sizeof(work) ) );
+    bench_sink += tausch_json_decode( &json_keys, json_text, json_len, &wr );
+    cnt->ops += 5;
+    cnt->bytes += json_len;
+    cnt->msgs += 1;
+}
+
+void bench_flater( void )
+{
+    tausch_flater_t fl;
+    tausch_schema_init( &devinfo_schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+
+    tausch_format_buf( msg );
+    tausch_flater_init( &fl, &devinfo_schema, msg, FLATER_SPACE );
+    if( write_info( &fl ) == 0 )
+    {
+        printf( "composing the flaterator message failed\n" );
+        return;
+    }
+    tausch_iter_t iter = TAUSCH_ITER_INIT( msg, bench_msg_max( sizeof(msg) ) );
+    (void)tausch_iter_exit_scope( &iter );
+    msg_len = iter.idx + 1;
+
+    bench( "flater_next", b_flater_next, &devinfo_schema );
+    bench( "flater_read", b_flater_read, &devinfo_schema );
+    indexed_schema = devinfo_schema;
+    tsch_size_t n = tausch_schema_index( &indexed_schema, lookup, bench_msg_max( sizeof(lookup) / sizeof(lookup[0]) ) );
+    if( (n > 0) && (indexed_schema.index != NULL) )
+    {
+        bench( "flater_next_indexed", b_flater_next, &indexed_schema );
+        bench( "flater_read_indexed", b_flater_read, &indexed_schema );
+    }
+    expanded_schema = devinfo_schema;
+    n = tausch_schema_expand( &expanded_schema, expanded, bench_msg_max( sizeof(expanded) / sizeof(expanded[0]) ),
+        expanded_slot );
+    if( (n > 0) && (expanded_schema.expanded != NULL) )
+    {
+        bench( "flater_next_expanded", b_flater_next, &expanded_schema );
+        bench( "flater_read_expanded", b_flater_read, &expanded_schema );
+        // both the rows and the lookup tables
+        if( tausch_schema_index( &expanded_schema, lookup, bench_msg_max( sizeof(lookup) / sizeof(lookup[0]) ) ) > 0 )
+        {
+            bench( "flater_next_expanded_indexed", b_flater_next, &expanded_schema );
+        }
+    }
+    bench( "flater_view", b_flater_view, NULL );
+    tausch_schema_init( &sample_schema, tauschema_json_sample_flatrows, tauschema_json_sample_flatsize );
+    bench( "name_n", b_name_n, &sample_schema );
+    hashed_schema = sample_schema;
+    if( tausch_schema_hash( &hashed_schema, hash, bench_msg_max( sizeof(hash) / sizeof(hash[0]) ) ) > 0 )
+    {
+        bench( "name_n_hash", b_name_n, &hashed_schema );
+    }
+    bench( "flater_write", b_flater_write, NULL );
+    bench( "structs_decode", b_structs_decode, NULL );
+    bench( "structs_encode", b_structs_encode, NULL );
+    bench( "json_encode", b_json_encode, NULL );
+
+    static tausch_json_key_t key[40];
+    tausch_json_t js;
+    tausch_json_init( &js, json_text, sizeof(json_text), NULL, NULL );
+    json_len = tausch_json_encode( &js, &devinfo_schema, msg, msg_len );
+    if( (json_len > 0) && tausch_json_keys_init( &json_keys, &devinfo_schema, key, 40 ) )
+    {
+        bench( "json_decode", b_json_decode, NULL );
+    }
+
+    for( size_t i = 0; i < BATCH_N; i++ )
+    {
+        batch[i].buf = msg;
+        batch[i].len = msg_len;
+    }
+    // the info collections back to back, in the bigger builds only
+    size_t info_len = msg_len - 1;
+    size_t nroot = bench_msg_max( sizeof(root) ) > BATCH_N * info_len ? BATCH_N : 0;
+    for( size_t i = 0; i < nroot; i++ )
+    {
+        memcpy( &root[i * info_len], msg, info_len );
+    }
+    root[nroot * info_len] = 7;
+    root_len = nroot * info_len + 1;
+
+    TAUSCH_POOL_NEW( pool, 4 );
+    bench( "batch_serial", b_batch_serial, NULL );
+    if( nroot > 0 ) bench( "root_elements", b_root_elements, NULL );
+    if( nroot > 0 ) bench( "root_serial", b_root_serial, NULL );
+    if( tausch_pool_init( &pool, pool_worker, 4 ) )
+    {
+        bench( "batch_pool_4", b_batch_pool, &pool );
+        if( nroot > 0 ) bench( "root_pool_4", b_root_pool, &pool );
+        tausch_pool_close( &pool );
+    }
+}
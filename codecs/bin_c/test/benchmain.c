@@ -0,0 +1,185 @@
+#include "benchmain.h"
+#include "tauschema_codec.h"
+#include <time.h>
+
+volatile uint64_t bench_sink = 0;
+
+static double bench_time_s = 0.2;   // minimal duration of one measurement
+static int bench_reps = 5;   // measurements per benchmark, best one is reported
+static const char *bench_filter = NULL;   // run only benchmarks containing this substring
+static FILE *bench_csv = NULL;   // machine readable output
+static const char *bench_baseline = NULL;   // csv file of earlier results
+static double bench_tolerance = 10.0;   // allowed slowdown in percents
+static const char *bench_corpus_file = NULL;   // messages produced by schemacheck.py --corpus
+static size_t bench_regressions = 0;
+static size_t bench_unbased = 0;   // benchmarks that are missing from the baseline
+static size_t bench_count = 0;
+
+static uint64_t bench_now_ns( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+size_t bench_msg_max( size_t limit )
+{
+    // keep one byte spare, TSCH_NOTHING is reserved
+    size_t mx = (size_t)(tsch_size_t)TSCH_NOTHING - 1;
+    return mx < limit ? mx : limit;
+}
+
+/**
+ * Look up the ns/op of the benchmark from the baseline file.
+ *
+ * @return the baseline value or negative when not found
+ */
+static double bench_baseline_ns( const char *name )
+{
+    if( bench_baseline == NULL ) return -1.0;
+    FILE *f = fopen( bench_baseline, "r" );
+    if( f == NULL ) return -1.0;
+
+    char line[256];
+    double rv = -1.0;
+    while( fgets( line, sizeof(line), f ) != NULL )
+    {
+        char bname[128];
+        unsigned bsize = 0;
+        double bns = 0;
+        if( sscanf( line, "%127[^,],%u,%lf", bname, &bsize, &bns ) != 3 ) continue;
+        if( (bsize == sizeof(tsch_size_t)) && (strcmp( bname, name ) == 0) )
+        {
+            rv = bns;
+        }
+    }
+    fclose( f );
+    return rv;
+}
+
+void bench( const char *name, bench_fn fn, void *ctx )
+{
+    if( (bench_filter != NULL) && (strstr( name, bench_filter ) == NULL) ) return;
+
+    double best_ns = 0;
+    bench_count_t best = { 0 };
+    double best_s = 1.0;
+
+    for( int r = 0; r < bench_reps; r++ )
+    {
+        bench_count_t cnt = { 0 };
+        uint64_t limit = (uint64_t)(bench_time_s * 1e9);
+        uint64_t start = bench_now_ns();
+        uint64_t elapsed = 0;
+        do
+        {
+            // call in small batches to keep the clock reading overhead out
+            for( int i = 0; i < 16; i++ ) fn( ctx, &cnt );
+            elapsed = bench_now_ns() - start;
+        }
+        while( elapsed < limit );
+
+        double ns = cnt.ops ? (double)elapsed / (double)cnt.ops : 0;
+        if( (r == 0) || (ns < best_ns) )
+        {
+            best_ns = ns;
+            best = cnt;
+            best_s = (double)elapsed / 1e9;
+        }
+    }
+
+    double mbs = (double)best.bytes / best_s / 1e6;
+    double mps = (double)best.msgs / best_s;
+    double base = bench_baseline_ns( name );
+
+    printf( "%-28s %10.2f ns/op %10.2f MB/s %12.0f msg/s", name, best_ns, mbs, mps );
+    if( base > 0 )
+    {
+        double diff = (best_ns - base) * 100.0 / base;
+        bool regressed = diff > bench_tolerance;
+        printf( " %+7.1f%%%s", diff, regressed ? " REGRESSION" : "" );
+        if( regressed ) bench_regressions += 1;
+    }
+    else if( bench_baseline != NULL )
+    {
+        printf( "  (no baseline)" );
+        bench_unbased += 1;
+    }
+    printf( "\n" );
+
+    if( bench_csv != NULL )
+    {
+        fprintf( bench_csv, "%s,%u,%.3f,%.3f,%.1f,%llu\n", name, (unsigned)sizeof(tsch_size_t), best_ns, mbs, mps,
+            (unsigned long long)best.ops );
+    }
+    bench_count += 1;
+}
+
+static void usage( const char *prog )
+{
+    printf( "usage: %s [--time seconds] [--reps n] [--filter text] [--csv file]\n"
+        "          [--baseline file] [--tolerance percent] [--corpus file]\n\n"
+        "The csv has columns: name,sizeof(tsch_size_t),ns_per_op,mb_per_s,msgs_per_s,ops\n"
+        "The baseline is an earlier csv, rows of other tsch_size_t are ignored.\n"
+        "The corpus is produced with schemacheck.py --corpus.\n", prog );
+}
+
+int main( int argc, char **argv )
+{
+    for( int i = 1; i < argc; i++ )
+    {
+        const char *arg = argv[i];
+        const char *val = (i + 1) < argc ? argv[i + 1] : NULL;
+        if( (strcmp( arg, "--time" ) == 0) && val ) bench_time_s = atof( argv[++i] );
+        else if( (strcmp( arg, "--reps" ) == 0) && val ) bench_reps = atoi( argv[++i] );
+        else if( (strcmp( arg, "--filter" ) == 0) && val ) bench_filter = argv[++i];
+        else if( (strcmp( arg, "--baseline" ) == 0) && val ) bench_baseline = argv[++i];
+        else if( (strcmp( arg, "--tolerance" ) == 0) && val ) bench_tolerance = atof( argv[++i] );
+        else if( (strcmp( arg, "--corpus" ) == 0) && val ) bench_corpus_file = argv[++i];
+        else if( (strcmp( arg, "--csv" ) == 0) && val )
+        {
+            bench_csv = fopen( argv[++i], "a" );
+            if( bench_csv == NULL )
+            {
+                printf( "can not open %s\n", argv[i] );
+                return 2;
+            }
+        }
+        else
+        {
+            usage( argv[0] );
+            return 2;
+        }
+    }
+    if( bench_reps < 1 ) bench_reps = 1;
+    if( bench_baseline != NULL )
+    {
+        FILE *f = fopen( bench_baseline, "r" );
+        if( f == NULL )
+        {
+            printf( "\n!!! WARNING: baseline %s is missing, the regressions are NOT checked !!!\n", bench_baseline );
+        }
+        else
+        {
+            fclose( f );
+        }
+    }
+
+    printf( "\n### Benchmarks with sizeof(tsch_size_t) = %u \n\n", (unsigned)sizeof(tsch_size_t) );
+
+    bench_buf();
+    bench_flater();
+    if( bench_corpus_file != NULL ) bench_corpus( bench_corpus_file );
+
+    if( bench_csv != NULL ) fclose( bench_csv );
+
+    printf( "\n\n" );
+    printf( "Number of benchmarks performed: %ld \n", bench_count );
+    printf( "    Number of regressions found: %ld \n", bench_regressions );
+    if( bench_unbased > 0 )
+    {
+        printf( "!!! WARNING: %ld benchmarks have no baseline, they are NOT checked !!!\n", bench_unbased );
+    }
+    printf( "\n\n" );
+    return bench_regressions > 0 ? 1 : 0;
+}
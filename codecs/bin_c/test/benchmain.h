@@ -0,0 +1,51 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Counters that the benchmark body fills in on every call.
+ */
+typedef struct
+{
+    /// number of operations performed (TLV decoded, value written, ...)
+    uint64_t ops;
+    /// number of message bytes processed
+    uint64_t bytes;
+    /// number of messages processed
+    uint64_t msgs;
+} bench_count_t;
+
+/**
+ * Benchmark body. It is called repeatedly until the measurement time is over.
+ *
+ * @param ctx : void* - the context given to bench()
+ * @param cnt : bench_count_t* - counters to increment with the amount of work done
+ */
+typedef void (*bench_fn)( void *ctx, bench_count_t *cnt );
+
+/**
+ * Measure the benchmark body and report the result.
+ *
+ * @param name : char* - name of the benchmark, used also for the baseline comparison
+ * @param fn : bench_fn - the benchmark body
+ * @param ctx : void* - context forwarded to the body
+ */
+void bench( const char *name, bench_fn fn, void *ctx );
+
+/**
+ * Sink for the results of benchmark bodies, so the compiler can not discard the work.
+ */
+extern volatile uint64_t bench_sink;
+
+/**
+ * Biggest message the current tsch_size_t can hold, limited to limit.
+ */
+size_t bench_msg_max( size_t limit );
+
+void bench_buf( void );
+void bench_flater( void );
+void bench_corpus( const char *path );
@@ -7,15 +7,16 @@
 
 
 const uint8_t tauschema_device_info_flatrows[] = {
- 14	,105	,0	,0	,0	,5	,0	,1	,5	,17	,10	,0	,1	,8	,17	,15	// .i..............
+ 14	,110	,0	,0	,0	,5	,0	,1	,5	,17	,10	,0	,1	,8	,17	,15	// .n..............
 ,25	,2	,10	,5	,0	,20	,1	,1	,16	,0	,0	,8	,7	,5	,0	,30	// ................
-,2	,19	,17	,15	,35	,3	,15	,17	,15	,40	,4	,18	,17	,15	,45	,5	// ....#....(....-.
+,2	,20	,17	,15	,35	,3	,15	,17	,15	,40	,4	,19	,17	,15	,45	,5	// ....#....(....-.
 ,13	,17	,15	,50	,6	,14	,17	,15	,55	,7	,11	,18	,60	,100	,1	,12	// ...2....7...<d..
 ,17	,65	,0	,1	,6	,4	,0	,70	,2	,8	,17	,15	,75	,3	,3	,17	// .A.....F....K...
-,15	,80	,4	,17	,3	,0	,85	,5	,16	,4	,0	,90	,6	,9	,4	,0	// .P....U....Z....
-,95	,7	,4	,4	,0	,0	,9	,2	,15	,0	,0	,7					// _...........
+,15	,80	,4	,18	,3	,0	,85	,5	,17	,4	,0	,90	,6	,9	,4	,0	// .P....U....Z....
+,95	,7	,4	,4	,0	,0	,9	,2	,15	,0	,105	,10	,16	,1	,0	,0	// _.........i.....
+,7																// .
 
 };
-const tsch_size_t tauschema_device_info_flatsize = sizeof( tauschema_device_info_flatrows ); // 108
-const tsch_size_t tauschema_device_info_maxtag = 36;
+const tsch_size_t tauschema_device_info_flatsize = sizeof( tauschema_device_info_flatrows ); // 113
+const tsch_size_t tauschema_device_info_maxtag = 40;
 
@@ -29,9 +29,10 @@
  #define TAUSCH_NAM_DEVICE_INFO_schtxt	(13)
  #define TAUSCH_NAM_DEVICE_INFO_schurl	(14)
  #define TAUSCH_NAM_DEVICE_INFO_serial	(15)
- #define TAUSCH_NAM_DEVICE_INFO_sub	(16)
- #define TAUSCH_NAM_DEVICE_INFO_type	(17)
- #define TAUSCH_NAM_DEVICE_INFO_vendor	(18)
- #define TAUSCH_NAM_DEVICE_INFO_version	(19)
+ #define TAUSCH_NAM_DEVICE_INFO_sized	(16)
+ #define TAUSCH_NAM_DEVICE_INFO_sub	(17)
+ #define TAUSCH_NAM_DEVICE_INFO_type	(18)
+ #define TAUSCH_NAM_DEVICE_INFO_vendor	(19)
+ #define TAUSCH_NAM_DEVICE_INFO_version	(20)
 
 #endif // _DEVICE_INFO_H_
@@ -0,0 +1,224 @@
+
+/* produced with command:
+ $ schemacheck.py --C=structs codecs/bin_c/test/device_info.schema --out-path=codecs/bin_c/test/
+*/
+
+#include "tauschema_device_info_structs.h"
+#include <string.h>
+
+bool tausch_device_info_decode_slice( tausch_citer_t *ci, tausch_device_info_slice_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 2:
+            msg->has_orig = tausch_iter_read( it, &msg->orig ) > 0;
+            break;
+        case 1:
+            msg->has_data = tausch_iter_view( it, &msg->data );
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_device_info_encode_slice( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_slice_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->has_orig && !tausch_writer_typX( wr, 2, (uint8_t*)&msg->orig, sizeof( msg->orig ) ) ) return false;
+    if( msg->has_data && !tausch_writer_typX( wr, 1, (uint8_t*)msg->data.buf, msg->data.len ) ) return false;
+    return tausch_writer_end( wr );
+}
+
+bool tausch_device_info_decode_schrow( tausch_citer_t *ci, tausch_device_info_schrow_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            msg->has_item = tausch_iter_read( it, &msg->item ) > 0;
+            break;
+        case 2:
+            if( !tausch_device_info_decode_slice( ci, &msg->name ) ) return false;
+            msg->has_name = 1;
+            break;
+        case 3:
+            if( !tausch_device_info_decode_slice( ci, &msg->desc ) ) return false;
+            msg->has_desc = 1;
+            break;
+        case 4:
+            msg->has_type = tausch_iter_read( it, &msg->type ) > 0;
+            break;
+        case 5:
+            msg->has_sub = tausch_iter_read( it, &msg->sub ) > 0;
+            break;
+        case 6:
+            msg->has_next = tausch_iter_read( it, &msg->next ) > 0;
+            break;
+        case 7:
+            msg->has_idx = tausch_iter_read( it, &msg->idx ) > 0;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_device_info_encode_schrow( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_schrow_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->has_item && !tausch_writer_typX( wr, 1, (uint8_t*)&msg->item, sizeof( msg->item ) ) ) return false;
+    if( msg->has_name && !tausch_device_info_encode_slice( wr, 2, &msg->name ) ) return false;
+    if( msg->has_desc && !tausch_device_info_encode_slice( wr, 3, &msg->desc ) ) return false;
+    if( msg->has_type && !tausch_writer_typX( wr, 4, (uint8_t*)&msg->type, sizeof( msg->type ) ) ) return false;
+    if( msg->has_sub && !tausch_writer_typX( wr, 5, (uint8_t*)&msg->sub, sizeof( msg->sub ) ) ) return false;
+    if( msg->has_next && !tausch_writer_typX( wr, 6, (uint8_t*)&msg->next, sizeof( msg->next ) ) ) return false;
+    if( msg->has_idx && !tausch_writer_typX( wr, 7, (uint8_t*)&msg->idx, sizeof( msg->idx ) ) ) return false;
+    return tausch_writer_end( wr );
+}
+
+bool tausch_device_info_decode_info_schbin( tausch_citer_t *ci, tausch_device_info_info_schbin_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    msg->n = 0;
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            if( msg->n >= TAUSCH_DEVICE_INFO_INFO_SCHBIN_MAX ) return false;   // the array is full
+            if( !tausch_device_info_decode_schrow( ci, &msg->item[msg->n] ) ) return false;
+            msg->n += 1;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_device_info_encode_info_schbin( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_info_schbin_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->n > TAUSCH_DEVICE_INFO_INFO_SCHBIN_MAX ) return false;
+    for( tsch_size_t i = 0; i < msg->n; i++ )
+    {
+        if( !tausch_device_info_encode_schrow( wr, 1, &msg->item[i] ) ) return false;
+    }
+    return tausch_writer_end( wr );
+}
+
+bool tausch_device_info_decode_info( tausch_citer_t *ci, tausch_device_info_info_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            if( !tausch_device_info_decode_slice( ci, &msg->name ) ) return false;
+            msg->has_name = 1;
+            break;
+        case 8:
+            msg->has_msglen = tausch_iter_read( it, &msg->msglen ) > 0;
+            break;
+        case 2:
+            if( !tausch_device_info_decode_slice( ci, &msg->version ) ) return false;
+            msg->has_version = 1;
+            break;
+        case 3:
+            if( !tausch_device_info_decode_slice( ci, &msg->serial ) ) return false;
+            msg->has_serial = 1;
+            break;
+        case 4:
+            if( !tausch_device_info_decode_slice( ci, &msg->vendor ) ) return false;
+            msg->has_vendor = 1;
+            break;
+        case 5:
+            if( !tausch_device_info_decode_slice( ci, &msg->schtxt ) ) return false;
+            msg->has_schtxt = 1;
+            break;
+        case 6:
+            if( !tausch_device_info_decode_slice( ci, &msg->schurl ) ) return false;
+            msg->has_schurl = 1;
+            break;
+        case 7:
+            if( !tausch_device_info_decode_info_schbin( ci, &msg->schbin ) ) return false;
+            msg->has_schbin = 1;
+            break;
+        case 9:
+            msg->has_demostring = tausch_iter_view( it, &msg->demostring );
+            break;
+        case 10:
+            msg->has_sized = tausch_iter_read_bool( it, &msg->sized );
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_device_info_encode_info( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_info_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->has_name && !tausch_device_info_encode_slice( wr, 1, &msg->name ) ) return false;
+    if( msg->has_msglen && !tausch_writer_typX( wr, 8, (uint8_t*)&msg->msglen, sizeof( msg->msglen ) ) ) return false;
+    if( msg->has_version && !tausch_device_info_encode_slice( wr, 2, &msg->version ) ) return false;
+    if( msg->has_serial && !tausch_device_info_encode_slice( wr, 3, &msg->serial ) ) return false;
+    if( msg->has_vendor && !tausch_device_info_encode_slice( wr, 4, &msg->vendor ) ) return false;
+    if( msg->has_schtxt && !tausch_device_info_encode_slice( wr, 5, &msg->schtxt ) ) return false;
+    if( msg->has_schurl && !tausch_device_info_encode_slice( wr, 6, &msg->schurl ) ) return false;
+    if( msg->has_schbin && !tausch_device_info_encode_info_schbin( wr, 7, &msg->schbin ) ) return false;
+    if( msg->has_demostring && !tausch_writer_typX( wr, 9, (uint8_t*)msg->demostring.buf, msg->demostring.len ) ) return false;
+    if( msg->has_sized && !tausch_writer_bool( wr, 10, (bool*)&msg->sized ) ) return false;
+    return tausch_writer_end( wr );
+}
+
+bool tausch_device_info_decode( tausch_device_info_t *msg, const uint8_t *buf, tsch_size_t len )
+{
+    tausch_citer_t root;
+    tausch_citer_t *ci = tausch_citer_init( &root, buf, len );
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            if( !tausch_device_info_decode_info( ci, &msg->info ) ) return false;
+            msg->has_info = 1;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    return tausch_iter_is_ok( it ) && tausch_iter_is_eof( it );
+}
+
+tsch_size_t tausch_device_info_encode( const tausch_device_info_t *msg, uint8_t *buf, tsch_size_t size )
+{
+    tausch_writer_t root;
+    tausch_writer_t *wr = tausch_writer_init( &root, buf, size );
+    if( msg->has_info && !tausch_device_info_encode_info( wr, 1, &msg->info ) ) return 0;
+    return tausch_writer_is_ok( wr ) ? tausch_writer_len( wr ) : 0;
+}
+
@@ -0,0 +1,240 @@
+
+/* produced with command:
+ $ schemacheck.py --C=structs codecs/bin_c/test/device_info.schema --out-path=codecs/bin_c/test/
+*/
+
+#ifndef _TAUSCHEMA_DEVICE_INFO_STRUCTS_H_
+#define _TAUSCHEMA_DEVICE_INFO_STRUCTS_H_
+
+#include "tauschema_codec.h"
+#include "tauschema_writer.h"
+
+/// Default number of elements in the arrays of variadics
+#ifndef TAUSCH_DEVICE_INFO_VARIADIC_MAX
+#define TAUSCH_DEVICE_INFO_VARIADIC_MAX 8
+#endif
+#ifndef TAUSCH_DEVICE_INFO_INFO_SCHBIN_MAX
+#define TAUSCH_DEVICE_INFO_INFO_SCHBIN_MAX TAUSCH_DEVICE_INFO_VARIADIC_MAX
+#endif
+
+/**
+ * Collection slice, Slice collection is used for transferring large data piece wize.
+ */
+typedef struct
+{
+    /// the orig is present
+    unsigned has_orig : 1;
+    /// the data is present
+    unsigned has_data : 1;
+    /// tag 2, The origin of the blob from the full data,
+    uint32_t orig;
+    /// tag 1, The data slice returned. On request the
+    tausch_view_t data;
+} tausch_device_info_slice_t;
+
+/**
+ * Collection schrow, The schema row in request and response.
+ */
+typedef struct
+{
+    /// the item is present
+    unsigned has_item : 1;
+    /// the name is present
+    unsigned has_name : 1;
+    /// the desc is present
+    unsigned has_desc : 1;
+    /// the type is present
+    unsigned has_type : 1;
+    /// the sub is present
+    unsigned has_sub : 1;
+    /// the next is present
+    unsigned has_next : 1;
+    /// the idx is present
+    unsigned has_idx : 1;
+    /// tag 1, {req} Item number in the binary.
+    uint16_t item;
+    /// tag 2, {req} UTF8, Item name in the code
+    tausch_device_info_slice_t name;
+    /// tag 3, UTF8, Description of the item for
+    tausch_device_info_slice_t desc;
+    /// tag 4, {req} Type number of the item.
+    uint8_t type;
+    /// tag 5, {req} Flat tree index to first subitem
+    uint16_t sub;
+    /// tag 6, {req} Flat tree index to next item at the
+    uint16_t next;
+    /// tag 7, Index of the row, on request and
+    uint16_t idx;
+} tausch_device_info_schrow_t;
+
+/**
+ * Variadic info_schbin, The array of schema flat tree.
+ */
+typedef struct
+{
+    /// number of elements in the array
+    tsch_size_t n;
+    /// the elements
+    tausch_device_info_schrow_t item[TAUSCH_DEVICE_INFO_INFO_SCHBIN_MAX];
+} tausch_device_info_info_schbin_t;
+
+/**
+ * Collection info, Client asks for the device information. Provide the value items
+ */
+typedef struct
+{
+    /// the name is present
+    unsigned has_name : 1;
+    /// the msglen is present
+    unsigned has_msglen : 1;
+    /// the version is present
+    unsigned has_version : 1;
+    /// the serial is present
+    unsigned has_serial : 1;
+    /// the vendor is present
+    unsigned has_vendor : 1;
+    /// the schtxt is present
+    unsigned has_schtxt : 1;
+    /// the schurl is present
+    unsigned has_schurl : 1;
+    /// the schbin is present
+    unsigned has_schbin : 1;
+    /// the demostring is present
+    unsigned has_demostring : 1;
+    /// the sized is present
+    unsigned has_sized : 1;
+    /// tag 1, UTF8, Device name.
+    tausch_device_info_slice_t name;
+    /// tag 8, {req} maximal supported length of message.
+    uint32_t msglen;
+    /// tag 2, UTF8, Device version.
+    tausch_device_info_slice_t version;
+    /// tag 3, UTF8, Device serial code.
+    tausch_device_info_slice_t serial;
+    /// tag 4, UTF8, Device vendor information.
+    tausch_device_info_slice_t vendor;
+    /// tag 5, UTF8, The schema as text file.
+    tausch_device_info_slice_t schtxt;
+    /// tag 6, UTF8, Link to the schema URL.
+    tausch_device_info_slice_t schurl;
+    /// tag 7, The array of schema flat tree.
+    tausch_device_info_info_schbin_t schbin;
+    /// tag 9
+    tausch_view_t demostring;
+    /// tag 10, The device does accept the sized scopes TX11,
+    bool sized;
+} tausch_device_info_info_t;
+
+/**
+ * Message of the schema device_info.
+ */
+typedef struct
+{
+    /// the info is present
+    unsigned has_info : 1;
+    /// tag 1, Client asks for the device information. Provide the value items
+    tausch_device_info_info_t info;
+} tausch_device_info_t;
+
+/**
+ * Decode the slice from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_device_info_slice_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_device_info_decode_slice( tausch_citer_t *ci, tausch_device_info_slice_t *msg );
+
+/**
+ * Encode the slice as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_device_info_slice_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_device_info_encode_slice( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_slice_t *msg );
+
+/**
+ * Decode the schrow from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_device_info_schrow_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_device_info_decode_schrow( tausch_citer_t *ci, tausch_device_info_schrow_t *msg );
+
+/**
+ * Encode the schrow as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_device_info_schrow_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_device_info_encode_schrow( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_schrow_t *msg );
+
+/**
+ * Decode the info_schbin from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_device_info_info_schbin_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_device_info_decode_info_schbin( tausch_citer_t *ci, tausch_device_info_info_schbin_t *msg );
+
+/**
+ * Encode the info_schbin as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_device_info_info_schbin_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_device_info_encode_info_schbin( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_info_schbin_t *msg );
+
+/**
+ * Decode the info from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_device_info_info_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_device_info_decode_info( tausch_citer_t *ci, tausch_device_info_info_t *msg );
+
+/**
+ * Encode the info as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_device_info_info_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_device_info_encode_info( tausch_writer_t *wr, tsch_size_t tag, const tausch_device_info_info_t *msg );
+
+/**
+ * Decode the message into the struct. The items unknown to schema and the stuffing
+ * are skipped, the UTF8 and BLOB values are views into the buffer.
+ *
+ * @param msg : tausch_device_info_t* - the struct to fill in
+ * @param buf : const uint8_t* - the message
+ * @param len : tsch_size_t - length of the message buffer
+ * @return bool - false when the message is broken or does not fit into the struct
+ */
+bool tausch_device_info_decode( tausch_device_info_t *msg, const uint8_t *buf, tsch_size_t len );
+
+/**
+ * Encode the present items of the struct into the message.
+ *
+ * @param msg : const tausch_device_info_t* - the struct
+ * @param buf : uint8_t* - the message buffer
+ * @param size : tsch_size_t - size of the message buffer
+ * @return tsch_size_t - length of the message including EOF, 0 on failure
+ */
+tsch_size_t tausch_device_info_encode( const tausch_device_info_t *msg, uint8_t *buf, tsch_size_t size );
+
+#endif // _TAUSCHEMA_DEVICE_INFO_STRUCTS_H_
@@ -0,0 +1,27 @@
+
+/* produced with command:
+ $ schemacheck.py --C=full codecs/bin_c/test/json_sample.schema --out-path=codecs/bin_c/test/
+*/
+
+#include "tauschema_check.h"
+
+
+const uint8_t tauschema_json_sample_flatrows[] = {
+ 14	,102	,0	,0	,0	,6	,0	,0	,1	,68	,17	,12	,0	,0	,1	,11	// .f.......D......
+,1	,0	,18	,0	,2	,5	,4	,0	,24	,0	,3	,33	,8	,0	,30	,0	// ...........!....
+,4	,58	,14	,0	,36	,0	,5	,22	,13	,0	,42	,0	,6	,16	,15	,0	// .:..$.....*.....
+,48	,0	,7	,64	,16	,0	,54	,0	,8	,40	,17	,60	,72	,0	,1	,81	// 0..@..6..(.<H..Q
+,10	,0	,66	,0	,2	,83	,10	,0	,0	,0	,9	,47	,18	,78	,90	,0	// ..B..S...../.NZ.
+,1	,52	,17	,60	,84	,0	,2	,28	,15	,0	,0	,0	,10	,1	,6	,0	// .4.<T...........
+,96	,0	,11	,75	,11	,0	,0	,0	,6	,85	,0	,98	,105	,103	,0	,99	// `..K.....U.big.c
+,111	,117	,110	,116	,0	,102	,108	,97	,103	,0	,108	,97	,98	,101	,108	,0	// ount.flag.label.
+,108	,101	,118	,101	,108	,0	,109	,97	,114	,107	,0	,111	,102	,102	,115	,101	// level.mark.offse
+,116	,0	,111	,114	,105	,103	,105	,110	,0	,112	,97	,116	,104	,0	,112	,111	// t.origin.path.po
+,105	,110	,116	,0	,114	,97	,116	,105	,111	,0	,114	,97	,119	,0	,115	,97	// int.ratio.raw.sa
+,109	,112	,108	,101	,0	,115	,109	,97	,108	,108	,0	,120	,0	,121	,0	,10	// mple.small.x.y..
+,1	,0	,7														// ...
+
+};
+const tsch_size_t tauschema_json_sample_flatsize = sizeof( tauschema_json_sample_flatrows ); // 195
+const tsch_size_t tauschema_json_sample_maxtag = 44;
+
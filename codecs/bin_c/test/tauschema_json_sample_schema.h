@@ -0,0 +1,34 @@
+
+/* produced with command:
+ $ schemacheck.py --C=full codecs/bin_c/test/json_sample.schema --out-path=codecs/bin_c/test/
+*/
+
+#ifndef _TAUSCHEMA_JSON_SAMPLE_H_
+#define _TAUSCHEMA_JSON_SAMPLE_H_
+
+#include "tauschema_codec.h"
+
+   extern const uint8_t tauschema_json_sample_flatrows[];
+   extern const tsch_size_t tauschema_json_sample_flatsize;
+
+   extern const tsch_size_t tauschema_json_sample_maxtag;
+
+ #define TAUSCH_NAM_JSON_SAMPLE_	(0)
+ #define TAUSCH_NAM_JSON_SAMPLE_big	(1)
+ #define TAUSCH_NAM_JSON_SAMPLE_count	(5)
+ #define TAUSCH_NAM_JSON_SAMPLE_flag	(11)
+ #define TAUSCH_NAM_JSON_SAMPLE_label	(16)
+ #define TAUSCH_NAM_JSON_SAMPLE_level	(22)
+ #define TAUSCH_NAM_JSON_SAMPLE_mark	(28)
+ #define TAUSCH_NAM_JSON_SAMPLE_offset	(33)
+ #define TAUSCH_NAM_JSON_SAMPLE_origin	(40)
+ #define TAUSCH_NAM_JSON_SAMPLE_path	(47)
+ #define TAUSCH_NAM_JSON_SAMPLE_point	(52)
+ #define TAUSCH_NAM_JSON_SAMPLE_ratio	(58)
+ #define TAUSCH_NAM_JSON_SAMPLE_raw	(64)
+ #define TAUSCH_NAM_JSON_SAMPLE_sample	(68)
+ #define TAUSCH_NAM_JSON_SAMPLE_small	(75)
+ #define TAUSCH_NAM_JSON_SAMPLE_x	(81)
+ #define TAUSCH_NAM_JSON_SAMPLE_y	(83)
+
+#endif // _JSON_SAMPLE_H_
@@ -0,0 +1,187 @@
+
+/* produced with command:
+ $ schemacheck.py --C=structs codecs/bin_c/test/json_sample.schema --out-path=codecs/bin_c/test/
+*/
+
+#include "tauschema_json_sample_structs.h"
+#include <string.h>
+
+bool tausch_json_sample_decode_point( tausch_citer_t *ci, tausch_json_sample_point_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            msg->has_x = tausch_iter_read( it, &msg->x ) > 0;
+            break;
+        case 2:
+            msg->has_y = tausch_iter_read( it, &msg->y ) > 0;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_json_sample_encode_point( tausch_writer_t *wr, tsch_size_t tag, const tausch_json_sample_point_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->has_x && !tausch_writer_typX( wr, 1, (uint8_t*)&msg->x, sizeof( msg->x ) ) ) return false;
+    if( msg->has_y && !tausch_writer_typX( wr, 2, (uint8_t*)&msg->y, sizeof( msg->y ) ) ) return false;
+    return tausch_writer_end( wr );
+}
+
+bool tausch_json_sample_decode_sample_path( tausch_citer_t *ci, tausch_json_sample_sample_path_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    msg->n = 0;
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            if( msg->n >= TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX ) return false;   // the array is full
+            msg->item[msg->n].tag = 1;
+            if( !tausch_json_sample_decode_point( ci, &msg->item[msg->n].point ) ) return false;
+            msg->n += 1;
+            break;
+        case 2:
+            if( msg->n >= TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX ) return false;   // the array is full
+            msg->item[msg->n].tag = 2;
+            if( !tausch_iter_view( it, &msg->item[msg->n].mark ) ) return false;
+            msg->n += 1;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_json_sample_encode_sample_path( tausch_writer_t *wr, tsch_size_t tag, const tausch_json_sample_sample_path_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->n > TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX ) return false;
+    for( tsch_size_t i = 0; i < msg->n; i++ )
+    {
+        switch( msg->item[i].tag )
+        {
+        case 1:
+            if( !tausch_json_sample_encode_point( wr, 1, &msg->item[i].point ) ) return false;
+            break;
+        case 2:
+            if( !tausch_writer_typX( wr, 2, (uint8_t*)msg->item[i].mark.buf, msg->item[i].mark.len ) ) return false;
+            break;
+        default:
+            return false;   // the tag is not in schema
+        }
+    }
+    return tausch_writer_end( wr );
+}
+
+bool tausch_json_sample_decode_sample( tausch_citer_t *ci, tausch_json_sample_sample_t *msg )
+{
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    if( !tausch_citer_enter_scope( ci ) ) return false;
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            msg->has_flag = tausch_iter_read_bool( it, &msg->flag );
+            break;
+        case 2:
+            msg->has_count = tausch_iter_read( it, &msg->count ) > 0;
+            break;
+        case 3:
+            msg->has_offset = tausch_iter_read( it, &msg->offset ) > 0;
+            break;
+        case 4:
+            msg->has_ratio = tausch_iter_read( it, &msg->ratio ) > 0;
+            break;
+        case 5:
+            msg->has_level = tausch_iter_read( it, &msg->level ) > 0;
+            break;
+        case 6:
+            msg->has_label = tausch_iter_view( it, &msg->label );
+            break;
+        case 7:
+            msg->has_raw = tausch_iter_view( it, &msg->raw );
+            break;
+        case 8:
+            if( !tausch_json_sample_decode_point( ci, &msg->origin ) ) return false;
+            msg->has_origin = 1;
+            break;
+        case 9:
+            if( !tausch_json_sample_decode_sample_path( ci, &msg->path ) ) return false;
+            msg->has_path = 1;
+            break;
+        case 10:
+            msg->has_big = tausch_iter_read( it, &msg->big ) > 0;
+            break;
+        case 11:
+            msg->has_small = tausch_iter_read( it, &msg->small ) > 0;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    // the scope must end with END, not with EOF
+    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );
+}
+
+bool tausch_json_sample_encode_sample( tausch_writer_t *wr, tsch_size_t tag, const tausch_json_sample_sample_t *msg )
+{
+    if( !tausch_writer_scope( wr, tag ) ) return false;
+    if( msg->has_flag && !tausch_writer_bool( wr, 1, (bool*)&msg->flag ) ) return false;
+    if( msg->has_count && !tausch_writer_typX( wr, 2, (uint8_t*)&msg->count, sizeof( msg->count ) ) ) return false;
+    if( msg->has_offset && !tausch_writer_typX( wr, 3, (uint8_t*)&msg->offset, sizeof( msg->offset ) ) ) return false;
+    if( msg->has_ratio && !tausch_writer_typX( wr, 4, (uint8_t*)&msg->ratio, sizeof( msg->ratio ) ) ) return false;
+    if( msg->has_level && !tausch_writer_typX( wr, 5, (uint8_t*)&msg->level, sizeof( msg->level ) ) ) return false;
+    if( msg->has_label && !tausch_writer_typX( wr, 6, (uint8_t*)msg->label.buf, msg->label.len ) ) return false;
+    if( msg->has_raw && !tausch_writer_typX( wr, 7, (uint8_t*)msg->raw.buf, msg->raw.len ) ) return false;
+    if( msg->has_origin && !tausch_json_sample_encode_point( wr, 8, &msg->origin ) ) return false;
+    if( msg->has_path && !tausch_json_sample_encode_sample_path( wr, 9, &msg->path ) ) return false;
+    if( msg->has_big && !tausch_writer_typX( wr, 10, (uint8_t*)&msg->big, sizeof( msg->big ) ) ) return false;
+    if( msg->has_small && !tausch_writer_typX( wr, 11, (uint8_t*)&msg->small, sizeof( msg->small ) ) ) return false;
+    return tausch_writer_end( wr );
+}
+
+bool tausch_json_sample_decode( tausch_json_sample_t *msg, const uint8_t *buf, tsch_size_t len )
+{
+    tausch_citer_t root;
+    tausch_citer_t *ci = tausch_citer_init( &root, buf, len );
+    const tausch_iter_t *it = tausch_citer_get( ci );
+    memset( msg, 0, sizeof( *msg ) );
+    while( tausch_citer_next( ci ) )
+    {
+        switch( it->tag )
+        {
+        case 1:
+            if( !tausch_json_sample_decode_sample( ci, &msg->sample ) ) return false;
+            msg->has_sample = 1;
+            break;
+        default:
+            break;   // stuffing and the items unknown to schema
+        }
+    }
+    return tausch_iter_is_ok( it ) && tausch_iter_is_eof( it );
+}
+
+tsch_size_t tausch_json_sample_encode( const tausch_json_sample_t *msg, uint8_t *buf, tsch_size_t size )
+{
+    tausch_writer_t root;
+    tausch_writer_t *wr = tausch_writer_init( &root, buf, size );
+    if( msg->has_sample && !tausch_json_sample_encode_sample( wr, 1, &msg->sample ) ) return 0;
+    return tausch_writer_is_ok( wr ) ? tausch_writer_len( wr ) : 0;
+}
+
@@ -0,0 +1,205 @@
+
+/* produced with command:
+ $ schemacheck.py --C=structs codecs/bin_c/test/json_sample.schema --out-path=codecs/bin_c/test/
+*/
+
+#ifndef _TAUSCHEMA_JSON_SAMPLE_STRUCTS_H_
+#define _TAUSCHEMA_JSON_SAMPLE_STRUCTS_H_
+
+#include "tauschema_codec.h"
+#include "tauschema_writer.h"
+
+/// Default number of elements in the arrays of variadics
+#ifndef TAUSCH_JSON_SAMPLE_VARIADIC_MAX
+#define TAUSCH_JSON_SAMPLE_VARIADIC_MAX 8
+#endif
+#ifndef TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX
+#define TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX TAUSCH_JSON_SAMPLE_VARIADIC_MAX
+#endif
+
+/**
+ * Collection point.
+ */
+typedef struct
+{
+    /// the x is present
+    unsigned has_x : 1;
+    /// the y is present
+    unsigned has_y : 1;
+    /// tag 1
+    int32_t x;
+    /// tag 2
+    int32_t y;
+} tausch_json_sample_point_t;
+
+/**
+ * Element of the variadic sample_path, the tag selects the member of union.
+ */
+typedef struct
+{
+    /// tag of the element
+    tsch_size_t tag;
+    union
+    {
+        /// tag 1
+        tausch_json_sample_point_t point;
+        /// tag 2
+        tausch_view_t mark;
+    };
+} tausch_json_sample_sample_path_item_t;
+
+/**
+ * Variadic sample_path.
+ */
+typedef struct
+{
+    /// number of elements in the array
+    tsch_size_t n;
+    /// the elements
+    tausch_json_sample_sample_path_item_t item[TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX];
+} tausch_json_sample_sample_path_t;
+
+/**
+ * Collection sample.
+ */
+typedef struct
+{
+    /// the flag is present
+    unsigned has_flag : 1;
+    /// the count is present
+    unsigned has_count : 1;
+    /// the offset is present
+    unsigned has_offset : 1;
+    /// the ratio is present
+    unsigned has_ratio : 1;
+    /// the level is present
+    unsigned has_level : 1;
+    /// the label is present
+    unsigned has_label : 1;
+    /// the raw is present
+    unsigned has_raw : 1;
+    /// the origin is present
+    unsigned has_origin : 1;
+    /// the path is present
+    unsigned has_path : 1;
+    /// the big is present
+    unsigned has_big : 1;
+    /// the small is present
+    unsigned has_small : 1;
+    /// tag 1
+    bool flag;
+    /// tag 2
+    uint16_t count;
+    /// tag 3
+    int8_t offset;
+    /// tag 4
+    double ratio;
+    /// tag 5
+    float level;
+    /// tag 6
+    tausch_view_t label;
+    /// tag 7
+    tausch_view_t raw;
+    /// tag 8
+    tausch_json_sample_point_t origin;
+    /// tag 9
+    tausch_json_sample_sample_path_t path;
+    /// tag 10
+    uint64_t big;
+    /// tag 11
+    int64_t small;
+} tausch_json_sample_sample_t;
+
+/**
+ * Message of the schema json_sample.
+ */
+typedef struct
+{
+    /// the sample is present
+    unsigned has_sample : 1;
+    /// tag 1
+    tausch_json_sample_sample_t sample;
+} tausch_json_sample_t;
+
+/**
+ * Decode the point from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_json_sample_point_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_json_sample_decode_point( tausch_citer_t *ci, tausch_json_sample_point_t *msg );
+
+/**
+ * Encode the point as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_json_sample_point_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_json_sample_encode_point( tausch_writer_t *wr, tsch_size_t tag, const tausch_json_sample_point_t *msg );
+
+/**
+ * Decode the sample_path from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_json_sample_sample_path_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_json_sample_decode_sample_path( tausch_citer_t *ci, tausch_json_sample_sample_path_t *msg );
+
+/**
+ * Encode the sample_path as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_json_sample_sample_path_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_json_sample_encode_sample_path( tausch_writer_t *wr, tsch_size_t tag, const tausch_json_sample_sample_path_t *msg );
+
+/**
+ * Decode the sample from the scope at the iterator. On success the iterator
+ * is left after the END of scope, continue with tausch_citer_next().
+ *
+ * @param ci : tausch_citer_t* - the iterator at the scope
+ * @param msg : tausch_json_sample_sample_t* - the struct to fill in
+ * @return bool - false on failure
+ */
+bool tausch_json_sample_decode_sample( tausch_citer_t *ci, tausch_json_sample_sample_t *msg );
+
+/**
+ * Encode the sample as the scope.
+ *
+ * @param wr : tausch_writer_t* - the writer
+ * @param tag : tsch_size_t - the tag of scope
+ * @param msg : const tausch_json_sample_sample_t* - the struct
+ * @return bool - false on failure
+ */
+bool tausch_json_sample_encode_sample( tausch_writer_t *wr, tsch_size_t tag, const tausch_json_sample_sample_t *msg );
+
+/**
+ * Decode the message into the struct. The items unknown to schema and the stuffing
+ * are skipped, the UTF8 and BLOB values are views into the buffer.
+ *
+ * @param msg : tausch_json_sample_t* - the struct to fill in
+ * @param buf : const uint8_t* - the message
+ * @param len : tsch_size_t - length of the message buffer
+ * @return bool - false when the message is broken or does not fit into the struct
+ */
+bool tausch_json_sample_decode( tausch_json_sample_t *msg, const uint8_t *buf, tsch_size_t len );
+
+/**
+ * Encode the present items of the struct into the message.
+ *
+ * @param msg : const tausch_json_sample_t* - the struct
+ * @param buf : uint8_t* - the message buffer
+ * @param size : tsch_size_t - size of the message buffer
+ * @return tsch_size_t - length of the message including EOF, 0 on failure
+ */
+tsch_size_t tausch_json_sample_encode( const tausch_json_sample_t *msg, uint8_t *buf, tsch_size_t size );
+
+#endif // _TAUSCHEMA_JSON_SAMPLE_STRUCTS_H_
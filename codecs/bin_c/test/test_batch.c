@@ -0,0 +1,144 @@
+#include "testmain.h"
+#include "../src/tauschema_batch.h"
+#include "../src/tauschema_writer.h"
+#include "tauschema_device_info_schema.h"
+
+#define BATCH_N 1000
+
+static uint32_t batch_result[BATCH_N];   // msglen read from each message
+static _Atomic uint32_t batch_calls;   // number of the decoder calls
+
+static bool read_msglen( tausch_cflater_t *cfl, size_t n, void *ctx )
+{
+    uint32_t *result = ctx;
+    uint32_t msglen = 0;
+    batch_calls += 1;
+    if( tausch_cflater_read( cfl, &msglen, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) == 0 )
+    {
+        return false;
+    }
+    result[n] += msglen;
+    return (msglen % 7) != 0;
+}
+
+bool test_batch( void )
+{
+    static uint8_t msgs[BATCH_N][16];
+    static tausch_view_t view[BATCH_N];
+    char errorbuf[500];   // temporary error message
+    tausch_schema_t devinfo_schema;
+
+    printf( "\n### Batch decoding tests \n\n" );
+
+    tausch_schema_init( &devinfo_schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+    for( uint32_t i = 0; i < BATCH_N; i++ )
+    {
+        tausch_writer_t wr;
+        uint32_t msglen = i + 1;
+        tausch_writer_init( &wr, msgs[i], sizeof(msgs[i]) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 8, &msglen );
+        tausch_writer_end( &wr );
+        view[i].buf = msgs[i];
+        view[i].len = tausch_writer_len( &wr );
+    }
+
+    {
+        printf( "   -- Decoding the batch in pool \n" );
+        TAUSCH_POOL_NEW( pool, 4 );
+        test( tausch_pool_init( &pool, pool_worker, 4 ), LINE( "" ) );
+
+        size_t expect = BATCH_N - BATCH_N / 7;
+        memset( batch_result, 0, sizeof(batch_result) );
+        batch_calls = 0;
+        size_t ok = tausch_pool_run( &pool, &devinfo_schema, view, BATCH_N, read_msglen, batch_result );
+        test( ok == expect, LINE( "decoded %d", (int)ok ) );
+        test( batch_calls == BATCH_N, LINE( "called %d", (int)batch_calls ) );
+        bool all = true;
+        for( uint32_t i = 0; i < BATCH_N; i++ ) all = all && (batch_result[i] == i + 1);
+        test( all, LINE( "every message is decoded once" ) );
+
+        printf( "   -- Reusing the pool, with broken and empty messages \n" );
+        view[10].len = 3;
+        view[30].len = 0;
+        batch_calls = 0;
+        ok = tausch_pool_run( &pool, &devinfo_schema, view, BATCH_N, read_msglen, batch_result );
+        test( ok == expect - 2, LINE( "decoded %d", (int)ok ) );
+        test( batch_calls == BATCH_N - 1, LINE( "called %d", (int)batch_calls ) );
+        test( (batch_result[0] == 2) && (batch_result[BATCH_N - 1] == 2 * BATCH_N), LINE( "" ) );
+
+        printf( "   -- Smaller batch than the pool \n" );
+        batch_calls = 0;
+        test( tausch_pool_run( &pool, &devinfo_schema, view, 2, read_msglen, batch_result ) == 2, LINE( "" ) );
+        test( batch_calls == 2, LINE( "" ) );
+        test( tausch_pool_run( &pool, &devinfo_schema, view, 0, read_msglen, batch_result ) == 0, LINE( "" ) );
+
+        tausch_pool_close( &pool );
+        test( pool.nworker == 0, LINE( "" ) );
+        test( tausch_pool_run( &pool, &devinfo_schema, view, 2, read_msglen, batch_result ) == 0, LINE( "closed" ) );
+        test( !tausch_pool_init( &pool, pool_worker, 0 ), LINE( "" ) );
+        tausch_pool_close( &pool );
+    }
+
+    {
+        printf( "   -- Decoding the elements of root scope in pool \n" );
+        static uint8_t big[BATCH_N * 16];
+        static tsch_size_t off[BATCH_N];
+        uint8_t zeros[3] = { 0 };
+        tausch_blob_t pad = { .buf = zeros, .len = sizeof(zeros) };
+        tausch_writer_t wr;
+        tausch_writer_init( &wr, big, sizeof(big) );
+        for( uint32_t i = 0; i < BATCH_N; i++ )
+        {
+            uint32_t msglen = i + 1;
+            tausch_writer_scope( &wr, 1 );
+            tausch_writer_write( &wr, 8, &msglen );
+            tausch_writer_end( &wr );
+            if( (i % 100) == 0 ) tausch_writer_write( &wr, 0, &pad );   // stuffing is not an element
+        }
+        test( tausch_writer_is_ok( &wr ), LINE( "" ) );
+        tsch_size_t len = tausch_writer_len( &wr );
+
+        test( tausch_batch_elements( big, len, NULL, 0 ) == BATCH_N, LINE( "" ) );
+        test( tausch_batch_elements( big, len, off, 10 ) == BATCH_N, LINE( "" ) );
+        test( (off[0] == 0) && (off[1] == 8 + 5), LINE( "second at %d", (int)off[1] ) );
+        test( tausch_batch_elements( big, len, off, BATCH_N ) == BATCH_N, LINE( "" ) );
+        test( tausch_batch_elements( big, len - 1, off, BATCH_N ) == TSCH_NOTHING, LINE( "no EOF" ) );
+
+        TAUSCH_POOL_NEW( pool, 3 );
+        test( tausch_pool_init( &pool, pool_worker, 3 ), LINE( "" ) );
+        memset( batch_result, 0, sizeof(batch_result) );
+        batch_calls = 0;
+        size_t ok = tausch_pool_run_elements( &pool, &devinfo_schema, big, len, off, BATCH_N, read_msglen, batch_result );
+        test( ok == BATCH_N - BATCH_N / 7, LINE( "decoded %d", (int)ok ) );
+        test( batch_calls == BATCH_N, LINE( "called %d", (int)batch_calls ) );
+        bool all = true;
+        for( uint32_t i = 0; i < BATCH_N; i++ ) all = all && (batch_result[i] == i + 1);
+        test( all, LINE( "the results are in order of the message" ) );
+
+        off[5] = len;
+        batch_calls = 0;
+        ok = tausch_pool_run_elements( &pool, &devinfo_schema, big, len, off, 10, read_msglen, batch_result );
+        test( (ok == 8) && (batch_calls == 9), LINE( "decoded %d called %d", (int)ok, (int)batch_calls ) );
+        tausch_pool_close( &pool );
+
+        printf( "   -- Seeking the flaterator \n" );
+        tausch_cflater_t cfl;
+        uint32_t u32 = 0;
+        tausch_cflater_init( &cfl, &devinfo_schema, big, len );
+        tausch_cflater_seek( &cfl, off[3] );
+        test( tausch_cflater_tag_n( &cfl ) == TAUSCH_NAM_DEVICE_INFO_info, LINE( "" ) );
+        test( tausch_cflater_read( &cfl, &u32, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) == 4, LINE( "" ) );
+        test( u32 == 4, LINE( "read %u", u32 ) );
+        tausch_cflater_next( &cfl );
+        test( tausch_cflater_tag_n( &cfl ) == TAUSCH_NAM_DEVICE_INFO_info, LINE( "" ) );
+        test( tausch_cflater_iter( &cfl )->idx == off[4], LINE( "" ) );
+        tausch_cflater_seek( &cfl, len );
+        test( !tausch_iter_is_ok( tausch_cflater_iter( &cfl ) ) && (cfl.flat.idx == 0), LINE( "" ) );
+        tausch_cflater_reset( &cfl );
+        test( tausch_iter_is_ok( tausch_cflater_iter( tausch_cflater_next( &cfl ) ) ), LINE( "" ) );
+    }
+
+    printf( " batch done \n\n");
+    return true;
+}
@@ -322,6 +322,273 @@ bool test_buf( void )
 
     }
 
+    {
+        printf(" --- Testing of vluint decoding with and without fast path. \n");
+        uint8_t buf[] = { 0x7f, 0x80, 0x01, 0xff, 0x7f, 0x80, 0x80, 0x01, 0xfe, 0xff, 0xff, 0xff, 0x0f, 0x00, 0x00 };
+        tsch_size_t expect[] = { 0x7f, 0x80, 0x3fff, 0x4000, 0xfffffffe, 0 };
+        for( tsch_size_t tail = 0; tail < 16; tail += 15 )
+        {
+            // place the sequence to the end of buffer and in front of long buffer
+            uint8_t mem[32] = { 0 };
+            tsch_size_t ofs = sizeof(mem) - sizeof(buf) - tail;
+            memcpy( &mem[ofs], buf, sizeof(buf) );
+            tausch_iter_t iter = TAUSCH_ITER_INIT( mem, sizeof(mem) - tail );
+            iter.next = iter.val = ofs;
+            for( size_t i = 0; i < sizeof(expect) / sizeof(expect[0]); i++ )
+            {
+                tsch_size_t v = tausch_iter_decode_vluint( &iter );
+                test( v == expect[i], LINE("vluint %ld decoded as %x with tail %d", i, v, tail) );
+            }
+            test( tausch_iter_is_ok( &iter ), LINE("iterator must stay valid with tail %d", tail) );
+        }
+
+        uint8_t overflow[][16] = {
+            { 0xff, 0xff, 0xff, 0xff, 0x10 },   // 2^36-1
+            { 0xff, 0xff, 0xff, 0xff, 0x0f },   // TSCH_NOTHING is not a value
+            { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 },   // over 64 bits
+            };
+        for( size_t i = 0; i < sizeof(overflow) / sizeof(overflow[0]); i++ )
+        {
+            tausch_iter_t iter = TAUSCH_ITER_INIT( overflow[i], sizeof(overflow[i]) );
+            test( tausch_iter_decode_vluint( &iter ) == TSCH_NOTHING, LINE("overflow %ld must fail", i) );
+            test( !tausch_iter_is_ok( &iter ), LINE("overflow %ld must invalidate iterator", i) );
+        }
+
+        uint8_t tagbuf[] = { 0xfe, 0xff, 0xff, 0xff, 0x7f, 0x00, 0x07 };
+        tausch_iter_t iter = TAUSCH_ITER_INIT( tagbuf, sizeof(tagbuf) );
+        test( !tausch_iter_next( &iter ), LINE("too big tag must fail") );
+        test( !tausch_iter_is_ok( &iter ), LINE("too big tag must invalidate iterator") );
+    }
+
+    {
+        printf(" --- Testing of EOF tracking. \n");
+        uint8_t buf[60];
+        tsch_size_t eof = 0;
+        tausch_format_buf( buf );
+        tausch_iter_t iter = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        tausch_iter_t walk = iter;   // untracked copy for reference
+        tausch_iter_track( &iter, &eof );
+        test( eof == TSCH_NOTHING, LINE("tracker must start unknown") );
+        test( tausch_iter_buff_free( &iter ) == sizeof(buf) - 1, LINE("") );
+        test( eof == 0, LINE("tracker must be found at 0, not %d", eof) );
+
+        uint32_t u32 = 5;
+        tausch_iter_t it = iter;
+        test( !tausch_iter_next( &it ), LINE("") );
+        test( tausch_iter_write( &it, 1, &u32 ), LINE("") );
+        test( eof == 6, LINE("tracker must follow the write, not %d", eof) );
+        test( !tausch_iter_next( &it ), LINE("") );
+        test( tausch_iter_write_scope( &it, 2 ), LINE("") );
+        test( tausch_iter_enter_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ), LINE("") );
+        test( tausch_iter_write( &it, 3, &u32 ), LINE("") );
+        test( !tausch_iter_next( &it ), LINE("") );
+        test( tausch_iter_write_end( &it ), LINE("") );
+        test( eof == 14, LINE("tracker must follow the end, not %d", eof) );
+        test( tausch_iter_buff_free( &iter ) == tausch_iter_buff_free( &walk ), LINE("") );
+
+        // erase the scope, it turns into stuffing and the EOF stays
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 2 ), LINE("") );
+        test( tausch_iter_erase( &it ), LINE("") );
+        test( tausch_iter_is_stuffing( &it ) == 8, LINE("") );
+        test( eof == 14, LINE("tracker must stay on erase, not %d", eof) );
+        test( tausch_iter_buff_free( &iter ) == tausch_iter_buff_free( &walk ), LINE("") );
+
+        it = iter;
+        test( tausch_iter_go_eof( &it ), LINE("") );
+        test( tausch_iter_is_eof( &it ) && (it.idx == 14), LINE("") );
+        test( tausch_iter_write( &it, 4, &u32 ), LINE("appending at EOF failed") );
+        test( eof == 20, LINE("") );
+
+        // shrinking the last element moves the EOF back
+        uint8_t one[1] = { 1 };
+        tausch_blob_t blob = { .buf = one, .len = 1 };
+        test( tausch_iter_write( &it, 4, &blob ), LINE("") );
+        test( eof == 17, LINE("tracker must move back, not %d", eof) );
+        test( tausch_iter_buff_free( &iter ) == tausch_iter_buff_free( &walk ), LINE("") );
+
+        // stale tracker is detected
+        eof = 3;
+        test( tausch_iter_buff_free( &iter ) == sizeof(buf) - 18, LINE("") );
+        test( eof == 17, LINE("") );
+    }
+
+    {
+        printf(" --- Testing of compaction. \n");
+        uint8_t buf[60];
+        tsch_size_t eof = 0;
+        uint32_t u32 = 0x11223344;
+        tausch_format_buf( buf );
+        tausch_iter_t iter = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        tausch_iter_track( &iter, &eof );
+        tausch_iter_t it = iter;
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 1, &u32 ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_scope( &it, 2 ), LINE("") );
+        test( tausch_iter_enter_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 3, &u32 ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 5, &u32 ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_end( &it ), LINE("") );
+        test( tausch_iter_exit_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 4, &u32 ), LINE("") );
+        test( tausch_iter_compact( &iter ) == 0, LINE("there is nothing to compact") );
+
+        it = iter;
+        test( tausch_iter_next( &it ) && tausch_iter_erase( &it ), LINE("") );
+        test( tausch_iter_next( &it ) && tausch_iter_enter_scope( &it ), LINE("") );
+        test( tausch_iter_next( &it ) && tausch_iter_erase( &it ), LINE("") );
+        test( tausch_iter_buff_free( &iter ) == sizeof(buf) - 27, LINE("") );
+        test( tausch_iter_next( &iter ), LINE("") );
+        test( tausch_iter_compact( &iter ) == 12, LINE("") );
+        test( tausch_iter_is_clean( &iter ) && (iter.scope == 0), LINE("the iterator must be reset") );
+        HEXCOMP( buf, "09 16 04 44 33 22 11 03 12 04 44 33 22 11 07", LINE("") );
+        test( eof == 14, LINE("tracker must follow the compaction, not %d", eof) );
+        tausch_iter_t walk = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        test( tausch_iter_buff_free( &walk ) == sizeof(buf) - 15, LINE("") );
+
+        // the stuffing in front of EOF is dropped as well
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 4 ) && tausch_iter_erase( &it ), LINE("") );
+        test( tausch_iter_compact( &iter ) == 6, LINE("") );
+        HEXCOMP( buf, "09 16 04 44 33 22 11 03 07", LINE("") );
+
+        buf[2] = 0x7f;   // the length goes over the buffer
+        test( tausch_iter_compact( &iter ) == 0, LINE("") );
+        test( !tausch_iter_is_ok( &iter ), LINE("") );
+    }
+
+    {
+        printf(" --- Testing of the hole index. \n");
+        uint8_t buf[100];
+        uint32_t u32 = 0x11223344;
+        TAUSCH_BLOB_NEW( blob, 20 );
+        memset( blob.buf, 0x55, blob.len );
+        TAUSCH_HOLES_NEW( holes, 8 );
+        TAUSCH_HOLES_NEW( built, 8 );
+        tausch_format_buf( buf );
+        tausch_iter_t iter = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        tausch_iter_holes( &iter, &holes );
+        test( holes.count == 0, LINE("") );
+
+        tausch_iter_t it = iter;
+        blob.len = 10;
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 1, &blob ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_scope( &it, 2 ), LINE("") );
+        test( tausch_iter_enter_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 3, &u32 ), LINE("") );
+        blob.len = 20;
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 5, &blob ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_end( &it ), LINE("") );
+        test( tausch_iter_exit_scope( &it ), LINE("") );
+        blob.len = 4;
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 4, &blob ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 6, &u32 ), LINE("") );
+        test( holes.count == 0, LINE("") );
+
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 1 ) && tausch_iter_erase( &it ), LINE("") );
+        test( tausch_iter_go_to_tag( &it, 4 ) && tausch_iter_erase( &it ), LINE("") );
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 2 ) && tausch_iter_enter_scope( &it ), LINE("") );
+        test( tausch_iter_go_to_tag( &it, 5 ) && tausch_iter_erase( &it ), LINE("") );
+        test( holes.count == 3, LINE("holes %d", holes.count) );
+        test( (holes.hole[2].idx == 19) && (holes.hole[2].len == 22) && (holes.hole[2].open == 12), LINE("") );
+        test( (holes.hole[0].open == TSCH_NOTHING) && (holes.hole[1].open == TSCH_NOTHING), LINE("") );
+
+        // the index built from the message must be the same
+        tausch_iter_t bi = iter;
+        tausch_iter_holes( &bi, &built );
+        test( built.count == 3, LINE("") );
+        for( tsch_size_t k = 0; k < built.count; k++ )
+        {
+            bool found = false;
+            for( tsch_size_t j = 0; j < holes.count; j++ )
+            {
+                found |= (holes.hole[j].idx == built.hole[k].idx) && (holes.hole[j].len == built.hole[k].len)
+                    && (holes.hole[j].open == built.hole[k].open) && (holes.hole[j].scope == built.hole[k].scope);
+            }
+            test( found, LINE("hole at %d", built.hole[k].idx) );
+        }
+
+        // best fit at root
+        it = iter;
+        test( tausch_iter_go_to_hole( &it, 6 ) && (it.idx == 42), LINE("the smallest hole, not %d", it.idx) );
+        test( tausch_iter_write( &it, 7, &u32 ), LINE("") );
+        it = iter;
+        test( tausch_iter_go_to_hole( &it, 6 ) && (it.idx == 0), LINE("") );
+        test( tausch_iter_write( &it, 8, &u32 ), LINE("") );
+        test( (holes.count == 2) && (holes.hole[1].idx == 6) && (holes.hole[1].len == 6), LINE("the remainder is indexed") );
+        it = iter;
+        test( !tausch_iter_go_to_hole( &it, 7 ), LINE("the hole in scope is not at root") );
+
+        // best fit in the scope
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 2 ) && tausch_iter_enter_scope( &it ), LINE("") );
+        test( tausch_iter_go_to_hole( &it, 7 ) && (it.idx == 19) && (it.scope == 1), LINE("") );
+        test( tausch_iter_exit_scope( &it ) && (it.nopen == 0), LINE("") );
+
+        // the stuffing written over without the index is dropped
+        it = iter;
+        it.holes = NULL;
+        test( tausch_iter_go_to_tag( &it, 0 ) && tausch_iter_write( &it, 9, &u32 ), LINE("") );
+        it = iter;
+        test( !tausch_iter_go_to_hole( &it, 6 ), LINE("") );
+        test( holes.count == 1, LINE("") );
+
+        // the holes of the erased scope are replaced with the hole of the scope
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 2 ) && tausch_iter_erase( &it ), LINE("") );
+        test( (holes.count == 1) && (holes.hole[0].scope == 0) && (holes.hole[0].idx == 12), LINE("holes %d", holes.count) );
+        it = iter;
+        test( tausch_iter_go_to_hole( &it, 7 ) && (it.idx == 12), LINE("") );
+
+        tausch_iter_compact( &iter );
+        test( holes.count == 0, LINE("") );
+    }
+
+    {
+        printf(" --- Testing of the hole index after leaving a subscope. \n");
+        uint8_t buf[100];
+        uint32_t u32 = 0x11223344;
+        TAUSCH_BLOB_NEW( blob, 20 );
+        memset( blob.buf, 0x55, blob.len );
+        TAUSCH_HOLES_NEW( holes, 8 );
+        tausch_format_buf( buf );
+        tausch_iter_t iter = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        tausch_iter_holes( &iter, &holes );
+
+        // scope 2 at 0 holds the scope 3 at 1, then blob 5 at 9, u32 4 at 31 and blob 6 at 37
+        tausch_iter_t it = iter;
+        test( !tausch_iter_next( &it ) && tausch_iter_write_scope( &it, 2 ), LINE("") );
+        test( tausch_iter_enter_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_scope( &it, 3 ), LINE("") );
+        test( tausch_iter_enter_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 1, &u32 ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_end( &it ), LINE("") );
+        test( tausch_iter_exit_scope( &it ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 5, &blob ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 4, &u32 ), LINE("") );
+        blob.len = 8;
+        test( !tausch_iter_next( &it ) && tausch_iter_write( &it, 6, &blob ), LINE("") );
+        test( !tausch_iter_next( &it ) && tausch_iter_write_end( &it ), LINE("") );
+
+        // the iterator returns to the opener of the outer scope
+        it = iter;
+        test( tausch_iter_go_to_tag( &it, 2 ) && tausch_iter_enter_scope( &it ), LINE("") );
+        test( tausch_iter_go_to_tag( &it, 3 ) && tausch_iter_enter_scope( &it ) && (it.nopen == 2), LINE("") );
+        test( tausch_iter_exit_scope( &it ) && (it.scope == 1) && (it.nopen == 1) && (it.open[0] == 0), LINE("") );
+        test( tausch_iter_go_to_tag( &it, 5 ) && tausch_iter_erase( &it ), LINE("") );
+        test( tausch_iter_go_to_tag( &it, 6 ) && tausch_iter_erase( &it ), LINE("") );
+        test( (holes.count == 2) && (holes.hole[0].open == 0) && (holes.hole[1].open == 0), LINE("holes %d", holes.count) );
+        test( (holes.hole[0].scope == 1) && (holes.hole[1].scope == 1), LINE("") );
+
+        // and writes with best fit after the subscope
+        test( tausch_iter_go_to_hole( &it, 6 ) && (it.idx == 37), LINE("the smallest hole, not %d", it.idx) );
+        test( tausch_iter_write( &it, 7, &u32 ), LINE("") );
+        test( (holes.count == 2) && (holes.hole[1].idx == 43) && (holes.hole[1].len == 4), LINE("the remainder is indexed") );
+        test( holes.hole[1].open == 0, LINE("") );
+    }
+
     {
         tausch_iter_t iter = iterini;
         iterini = iter; // to avoid compiler warning
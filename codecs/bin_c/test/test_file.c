@@ -0,0 +1,58 @@
+#include "testmain.h"
+#include "../src/tauschema_file.h"
+#include "../src/tauschema_writer.h"
+
+bool test_file( void )
+{
+    uint8_t msg[100];
+    char errorbuf[500];   // temporary error message
+    char path[] = "/tmp/tauschema_test_file.tlv";
+
+    printf( "\n### Memory mapped file tests \n\n" );
+
+    {
+        printf( "   -- Reading messages back to back \n" );
+        FILE *f = fopen( path, "wb" );
+        test( f != NULL, LINE( "" ) );
+        tausch_writer_t wr;
+        uint8_t sevens[5] = { 7, 7, 7, 7, 7 };
+        tausch_blob_t blob = { .buf = sevens, .len = 5 };
+        for( uint32_t i = 0; i < 3; i++ )
+        {
+            tausch_writer_init( &wr, msg, sizeof(msg) );
+            tausch_writer_scope( &wr, 5 );
+            tausch_writer_write( &wr, 1, &i );
+            tausch_writer_write( &wr, 2, &blob );
+            tausch_writer_end( &wr );
+            fwrite( msg, 1, tausch_writer_len( &wr ), f );
+        }
+        fwrite( "\x15\x06", 1, 2, f );   // the message cut off
+        fclose( f );
+
+        tausch_file_t file;
+        tausch_iter_t iter;
+        test( tausch_file_open( &file, path ), LINE( "" ) );
+        test( file.size == 3 * 16 + 2, LINE( "size %d", (int)file.size ) );
+        for( uint32_t i = 0; i < 3; i++ )
+        {
+            uint32_t u32 = 100;
+            tausch_view_t view;
+            test( tausch_file_next( &file, &iter ) && (iter.ebuf == 16) && (file.msg == i * 16), LINE( "" ) );
+            test( tausch_iter_next( &iter ) && tausch_iter_enter_scope( &iter ), LINE( "" ) );
+            test( tausch_iter_next( &iter ) && tausch_iter_read( &iter, &u32 ) && (u32 == i), LINE( "" ) );
+            test( tausch_iter_next( &iter ) && tausch_iter_view( &iter, &view ) && (view.len == 5), LINE( "" ) );
+            test( view.buf == &file.map[i * 16 + 9], LINE( "the value is read in place" ) );
+        }
+        test( !tausch_file_next( &file, &iter ) && !tausch_iter_is_ok( &iter ), LINE( "the message is not complete" ) );
+
+        test( tausch_file_seek( &file, 16 ) && tausch_file_next( &file, &iter ) && (file.msg == 16), LINE( "" ) );
+        test( !tausch_file_seek( &file, file.size ), LINE( "" ) );
+        tausch_file_close( &file );
+        test( !tausch_file_next( &file, &iter ), LINE( "" ) );
+        remove( path );
+        test( !tausch_file_open( &file, path ), LINE( "no file" ) );
+    }
+
+    printf( " file done \n\n" );
+    return true;
+}
@@ -1,6 +1,8 @@
 #include "testmain.h"
 #include "../src/tauschema_check.h"
+#include "../src/tauschema_stats.h"
 #include "tauschema_device_info_schema.h"
+#include "tauschema_json_sample_schema.h"
 
 bool test_flater( void )
 {
@@ -126,6 +128,20 @@ bool test_flater( void )
             LINE( "" ) );
         STRCOMP( stringblob.buf, "thisisablob", LINE("") );
 
+        printf( "   -- Testing view of a value \n" );
+        tausch_view_t view;
+        test( tausch_flater_view( &fl, &view, TAUSCH_NAM_DEVICE_INFO_serial, TAUSCH_NAM_DEVICE_INFO_data ), LINE( "" ) );
+        test( (view.len == 11) && (memcmp( view.buf, "thisisablob", 11 ) == 0), LINE( "" ) );
+        test( (view.buf > buf) && (view.buf < (buf + sizeof(buf))), LINE( "the view is into message" ) );
+        test( !tausch_flater_view( &fl, &view, TAUSCH_NAM_DEVICE_INFO_msglen ), LINE( "not a blob" ) );
+        test( (view.buf == NULL) && (view.len == 0), LINE( "" ) );
+        test( !tausch_flater_view( &fl, &view, TAUSCH_NAM_DEVICE_INFO_schurl, TAUSCH_NAM_DEVICE_INFO_data ), LINE( "" ) );
+        fc = tausch_flater_clone( &fl );
+        tausch_flater_go_to( &fc, TAUSCH_NAM_DEVICE_INFO_serial );
+        test( tausch_iter_view( &fc.iter, &view ) == false, LINE( "scope has no view" ) );
+        tausch_flater_go_to( &fc, TAUSCH_NAM_DEVICE_INFO_data );
+        test( tausch_iter_view( &fc.iter, &view ) && (view.len == 11), LINE( "" ) );
+
         printf( "   -- Testing overwriting of a value \n" );
         tausch_flater_reset( &fl );
         u8 = 200;
@@ -185,6 +201,308 @@ bool test_flater( void )
         memset( stringblob.buf, 255, stringblob.len );
         test( tausch_flater_read(&fl, &stringblob, TAUSCH_NAM_DEVICE_INFO_demostring) == 5, LINE(""));
         test( stringblob.buf[0] == 0, LINE(""));
+
+        printf( "   -- Testing of EOF tracking over scope writing \n" );
+        tsch_size_t eof = 0;
+        tausch_flater_reset( &fl );
+        tausch_format_buf( buf );
+        tausch_iter_track( &fl.iter, &eof );
+        ok = ok && TAUSCH_FLATER_WRITE_SCOPE( &fl, TAUSCH_NAM_DEVICE_INFO_info )
+        {
+            uint32_t u32 = 1400;
+            ok = ok && (tausch_flater_write( sfl, TAUSCH_NAM_DEVICE_INFO_msglen, &u32 ) > 0);
+            return ok;
+        }
+        TAUSCH_FLATER_CLOSE_SCOPE;
+        test( ok, LINE(""));
+        tausch_iter_t walk = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        test( tausch_iter_buff_free( &fl.iter ) == tausch_iter_buff_free( &walk ), LINE(""));
+        test( (eof == 8) && (buf[eof] == 7), LINE("the tracker is at %d", eof));
+        tausch_flater_go_eof( &fl );
+        test( tausch_iter_is_eof( &fl.iter ) && (fl.iter.idx == eof), LINE(""));
+
+        printf( "   -- Testing of hole index over scope writing \n" );
+        TAUSCH_HOLES_NEW( holes, 4 );
+        TAUSCH_HOLES_NEW( built, 4 );
+        tausch_format_buf( buf );
+        walk = (tausch_iter_t)TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        test( !tausch_iter_next( &walk ) && tausch_iter_write_stuffing( &walk, 40 ), LINE(""));
+        bool flag = true;
+        test( !tausch_iter_next( &walk ) && tausch_iter_write_bool( &walk, 2, &flag ), LINE(""));
+        test( !tausch_iter_next( &walk ) && tausch_iter_write_stuffing( &walk, 10 ), LINE(""));
+        test( !tausch_iter_next( &walk ) && tausch_iter_write_bool( &walk, 2, &flag ), LINE(""));
+        tausch_flater_reset( &fl );
+        fl.iter.eof = NULL;
+        tausch_iter_holes( &fl.iter, &holes );
+        test( (holes.count == 2) && (holes.hole[0].len == 40), LINE(""));
+        ok = ok && TAUSCH_FLATER_WRITE_SCOPE( &fl, TAUSCH_NAM_DEVICE_INFO_info )
+        {
+            uint32_t u32 = 1400;
+            ok = ok && (tausch_flater_write( sfl, TAUSCH_NAM_DEVICE_INFO_msglen, &u32 ) > 0);
+            return ok;
+        }
+        TAUSCH_FLATER_CLOSE_SCOPE;
+        test( ok, LINE(""));
+        // the index is updated in place, the same as when built again from the message
+        walk = (tausch_iter_t)TAUSCH_ITER_INIT( buf, sizeof(buf) );
+        tausch_iter_holes( &walk, &built );
+        test( holes.count == built.count, LINE("holes %d built %d", holes.count, built.count));
+        for( tsch_size_t k = 0; k < holes.count; k++ )
+        {
+            test( (holes.hole[k].idx == built.hole[k].idx) && (holes.hole[k].len == built.hole[k].len), LINE("hole %d", k));
+        }
+    }
+
+    {
+        printf( "\n### Read only iterators on const message \n\n" );
+
+        // the message composed at the beginning, placed into read only memory
+        static const uint8_t rom[] = { 0x05, 0x22, 0x04, 0x64, 0x00, 0x00, 0x00, 0x0d, 0x0a, 0x04, 0x00, 0x00,
+            0x00, 0x00, 0x06, 0x0b, 't', 'h', 'i', 's', 'i', 's', 'a', 'b', 'l', 'o', 'b', 0x03, 0x03, 0x07 };
+        tausch_schema_t devinfo_schema;
+        tausch_view_t view;
+        uint32_t u32 = 0;
+
+        printf( "   -- Walking with citer \n" );
+        tausch_citer_t ci = TAUSCH_CITER_INIT( rom, sizeof(rom) );
+        test( tausch_citer_next( &ci ) && tausch_iter_is_scope( tausch_citer_get( &ci ) ), LINE("") );
+        test( tausch_citer_enter_scope( &ci ), LINE("") );
+        test( tausch_citer_go_to_tag( &ci, 8 ), LINE("") );
+        test( tausch_citer_read( &ci, &u32 ) && (u32 == 100), LINE("read %u", u32) );
+        test( tausch_citer_go_to_tag( &ci, 3 ) && tausch_citer_enter_scope( &ci ), LINE("") );
+        test( tausch_citer_go_to_tag( &ci, 1 ), LINE("") );
+        test( tausch_citer_view( &ci, &view ) && (view.len == 11) && (view.buf == &rom[16]), LINE("") );
+        test( tausch_citer_exit_scope( &ci ) && tausch_citer_exit_scope( &ci ), LINE("") );
+        test( !tausch_citer_next( &ci ) && tausch_iter_is_eof( tausch_citer_get( &ci ) ), LINE("") );
+        tausch_citer_reset( &ci );
+        test( tausch_citer_go_eof( &ci ) && (ci.iter.idx == sizeof(rom) - 1), LINE("") );
+
+        printf( "   -- Reading with cflater \n" );
+        tausch_cflater_t cfl;
+        tausch_schema_init( &devinfo_schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        test( tausch_cflater_init( &cfl, &devinfo_schema, rom, sizeof(rom) ), LINE("") );
+        u32 = 0;
+        test( tausch_cflater_read( &cfl, &u32, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) == 4,
+            LINE("") );
+        test( u32 == 100, LINE("read %u", u32) );
+        test( tausch_cflater_view( &cfl, &view, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_serial,
+            TAUSCH_NAM_DEVICE_INFO_data ), LINE("") );
+        test( (view.len == 11) && (memcmp( view.buf, "thisisablob", 11 ) == 0), LINE("") );
+        tausch_cflater_next( &cfl );
+        test( tausch_cflater_tag_n( &cfl ) == TAUSCH_NAM_DEVICE_INFO_info, LINE("") );
+        tausch_cflater_t sub = tausch_cflater_clone( &cfl );
+        (void)tausch_cflater_go_to( &sub, TAUSCH_NAM_DEVICE_INFO_serial );
+        test( tausch_cflater_tag_n( &sub ) == TAUSCH_NAM_DEVICE_INFO_serial, LINE("") );
+        test( tausch_iter_is_scope( tausch_cflater_iter( &sub ) ), LINE("") );
+        tausch_cflater_reset( &cfl );
+        test( tausch_cflater_tag_n( tausch_cflater_next( &cfl ) ) == TAUSCH_NAM_DEVICE_INFO_info, LINE("") );
+
+        printf( "   -- Copying the name strings from read only schema \n" );
+        static const char names[] = "\0serial\0orig";
+        char name[3];
+        devinfo_schema.names.buf = (const uint8_t*)names;
+        devinfo_schema.names.len = sizeof(names);
+        test( TAUSCH_SCHEMA_STR_NAME( &devinfo_schema, name, 1 ) == 6, LINE("") );
+        test( strcmp( name, "se" ) == 0, LINE("the name is cut to %s", name) );
+        test( TAUSCH_SCHEMA_STR_NAME( &devinfo_schema, name, 8 ) == 4, LINE("") );
+        test( strcmp( name, "or" ) == 0, LINE("the name is cut to %s", name) );
+        test( TAUSCH_SCHEMA_STR_NAME( &devinfo_schema, name, sizeof(names) ) == 0, LINE("") );
+        test( strcmp( names + 1, "serial" ) == 0, LINE("the schema is not modified") );
+    }
+
+    {
+        printf( "\n### Lookup tables of scopes \n\n" );
+
+        printf( "   -- Sizing the tables \n" );
+        static tsch_size_t lookup[300];
+        tausch_schema_t devinfo_schema;
+        tausch_schema_init( &devinfo_schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        tsch_size_t n = tausch_schema_index( &devinfo_schema, NULL, 0 );
+        test( (n > devinfo_schema.rows.len) && (n <= 300), LINE( "size %d", (int)n ) );
+        test( tausch_schema_index( &devinfo_schema, lookup, n - 1 ) == n, LINE( "" ) );
+        test( devinfo_schema.index == NULL, LINE( "the tables do not fit" ) );
+        test( tausch_schema_index( &devinfo_schema, lookup, sizeof(lookup) / sizeof(lookup[0]) ) == n, LINE( "" ) );
+        test( devinfo_schema.index == lookup, LINE( "" ) );
+
+        printf( "   -- Running next and go_to with the tables \n" );
+        // the message of the flaterator tests before its modifications
+        static const uint8_t rom[] = {
+            0x05, 0x22, 0x04, 0x64, 0x00, 0x00, 0x00, 0x0d, 0x0a, 0x04, 0x00, 0x00, 0x00, 0x00, 0x06, 0x0b,
+            't', 'h', 'i', 's', 'i', 's', 'a', 'b', 'l', 'o', 'b', 0x03, 0x03, 0x07 };
+        tausch_stats_t st, st2;
+        tausch_flater_t fl, fc;
+        memcpy( buf, rom, sizeof(rom) );
+        tausch_stats_get( &st );
+        tausch_flater_init( &fl, &devinfo_schema, buf, sizeof (buf) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fl ) ) == TAUSCH_NAM_DEVICE_INFO_info, LINE( "" ) );
+        fc = tausch_flater_clone( &fl );
+        test( tausch_flater_tag_n( tausch_flater_next( &fc ) ) == TAUSCH_NAM_DEVICE_INFO_msglen, LINE( "" ) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fc ) ) == TAUSCH_NAM_DEVICE_INFO_serial, LINE( "" ) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fc ) ) == TAUSCH_NAM_DEVICE_INFO_, LINE( "" ) );
+        tausch_stats_get( &st2 );
+        test( st2.compares == st.compares, LINE( "compares %d", (int)(st2.compares - st.compares) ) );
+
+        fc = tausch_flater_clone( &fl );
+        test( tausch_flater_tag_n( tausch_flater_go_to( &fc, TAUSCH_NAM_DEVICE_INFO_serial,
+            TAUSCH_NAM_DEVICE_INFO_data ) ) == TAUSCH_NAM_DEVICE_INFO_data, LINE( "" ) );
+        TAUSCH_BLOB_NEW( stringblob, 100 );
+        test( tausch_flater_read( &fc, &stringblob ) == 11, LINE( "" ) );
+        STRCOMP( stringblob.buf, "thisisablob", LINE("") );
+        fc = tausch_flater_clone( &fl );
+        test( tausch_flater_tag_n( tausch_flater_go_to( &fc, TAUSCH_NAM_DEVICE_INFO_vendor ) ) == TAUSCH_NAM_DEVICE_INFO_,
+            LINE( "not in the message" ) );
+        fc = tausch_flater_clone( &fl );
+        test( tausch_flater_tag_n( tausch_flater_go_to( &fc, TAUSCH_NAM_DEVICE_INFO_orig ) ) == TAUSCH_NAM_DEVICE_INFO_,
+            LINE( "not in the scope" ) );
+        uint32_t u32 = 0;
+        test( tausch_flater_read( &fl, &u32, TAUSCH_NAM_DEVICE_INFO_msglen ) == 4, LINE( "" ) );
+        test( u32 == 100, LINE( "" ) );
+
+        printf( "   -- Sparse tags \n" );
+        // root, then items of tags 1, 100 and 7 named 1, 2 and 3
+        static const uint8_t rows[] = {
+            0x00, 0x00, TSCH_COLLECTION, 0x05, 0x00,
+            0x01, 0x01, TSCH_UINT_8, 0x00, 0x0a,
+            0x64, 0x02, TSCH_UINT_8, 0x00, 0x0f,
+            0x07, 0x03, TSCH_UINT_8, 0x00, 0x00 };
+        tausch_schema_t sparse = { .rows = { .buf = rows, .len = sizeof(rows) } };
+        uint8_t msg[20];
+        uint8_t u8 = 5;
+        tausch_format_buf( msg );
+        tausch_iter_t iter = TAUSCH_ITER_INIT( msg, sizeof(msg) );
+        test( !tausch_iter_next( &iter ) && tausch_iter_write( &iter, 100, &u8 ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ) && tausch_iter_write( &iter, 7, &u8 ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ) && tausch_iter_write( &iter, 50, &u8 ), LINE( "" ) );
+        n = tausch_schema_index( &sparse, lookup, sizeof(lookup) / sizeof(lookup[0]) );
+        test( (n == sizeof(rows) + 3 + 2 * 3 + 3 + 3) && (sparse.index == lookup), LINE( "size %d", (int)n ) );
+        tausch_flater_init( &fl, &sparse, msg, sizeof(msg) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fl ) ) == 2, LINE( "" ) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fl ) ) == 3, LINE( "" ) );
+        test( (tausch_flater_tag_n( tausch_flater_next( &fl ) ) == 0) && (fl.idx == 0), LINE( "unknown tag" ) );
+        tausch_flater_reset( &fl );
+        test( (tausch_flater_read( &fl, &u8, 3 ) == 1) && (u8 == 5), LINE( "" ) );
+    }
+
+    {
+        printf( "\n### Expanded rows of schema \n\n" );
+
+        printf( "   -- Sizing the rows \n" );
+        static tausch_schema_row_t expanded[100];
+        static tsch_size_t slot[300];
+        tausch_schema_t plain, schema;
+        tausch_schema_init( &plain, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        tausch_schema_init( &schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        tsch_size_t n = tausch_schema_expand( &schema, NULL, 0, NULL );
+        test( (n > 20) && (n < schema.rows.len / 3) && (schema.rows.len <= 300), LINE( "rows %d of %d bytes", (int)n, (int)schema.rows.len ) );
+        test( (tausch_schema_expand( &schema, expanded, n - 1, slot ) == n) && (schema.expanded == NULL), LINE( "" ) );
+        test( (tausch_schema_expand( &schema, expanded, 100, NULL ) == n) && (schema.expanded == NULL), LINE( "" ) );
+        test( (tausch_schema_expand( &schema, expanded, 100, slot ) == n) && (schema.expanded == expanded), LINE( "" ) );
+        test( (schema.slot == slot) && (slot[0] == 0) && (slot[1] == TSCH_NOTHING), LINE( "" ) );
+
+        printf( "   -- Rows are the same as decoded \n" );
+        tsch_size_t todo[200] = { 0 };
+        size_t ntodo = 1;
+        size_t nrows = 0;
+        bool same = true;
+        tausch_flatrow_t a, b;
+        tausch_flatrow_init( &a, &plain );
+        tausch_flatrow_init( &b, &schema );
+        while( (ntodo > 0) && (ntodo < 198) )
+        {
+            tsch_size_t idx = todo[--ntodo];
+            same = same && tausch_flatrow_decode( &a, idx ) && tausch_flatrow_decode( &b, idx );
+            same = same && (a.item == b.item) && (a.name == b.name) && (a.desc == b.desc) && (a.ntype == b.ntype)
+                && (a.sub == b.sub) && (a.next == b.next);
+            if( a.sub > 0 ) todo[ntodo++] = a.sub;
+            if( a.next > 0 ) todo[ntodo++] = a.next;
+            nrows += 1;
+        }
+        test( same && (ntodo == 0) && (nrows > 20), LINE( "rows %d", (int)nrows ) );
+        test( !tausch_flatrow_decode( &b, schema.rows.len ), LINE( "" ) );
+        test( !tausch_flatrow_decode( &b, 1 ), LINE( "the offset inside of row" ) );
+
+        printf( "   -- Flaterator does not decode rows \n" );
+        static const uint8_t rom[] = {
+            0x05, 0x22, 0x04, 0x64, 0x00, 0x00, 0x00, 0x0d, 0x0a, 0x04, 0x00, 0x00, 0x00, 0x00, 0x06, 0x0b,
+            't', 'h', 'i', 's', 'i', 's', 'a', 'b', 'l', 'o', 'b', 0x03, 0x03, 0x07 };
+        tausch_stats_t st, st2;
+        tausch_flater_t fl;
+        uint32_t u32 = 0;
+        TAUSCH_BLOB_NEW( stringblob, 100 );
+        memcpy( buf, rom, sizeof(rom) );
+        tausch_stats_get( &st );
+        tausch_flater_init( &fl, &schema, buf, sizeof (buf) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fl ) ) == TAUSCH_NAM_DEVICE_INFO_info, LINE( "" ) );
+        tausch_flater_t fc = tausch_flater_clone( &fl );
+        test( tausch_flater_tag_n( tausch_flater_next( &fc ) ) == TAUSCH_NAM_DEVICE_INFO_msglen, LINE( "" ) );
+        test( tausch_flater_tag_n( tausch_flater_next( &fc ) ) == TAUSCH_NAM_DEVICE_INFO_serial, LINE( "" ) );
+        test( (tausch_flater_read( &fl, &u32, TAUSCH_NAM_DEVICE_INFO_msglen ) == 4) && (u32 == 100), LINE( "" ) );
+        test( tausch_flater_read( &fl, &stringblob, TAUSCH_NAM_DEVICE_INFO_serial, TAUSCH_NAM_DEVICE_INFO_data ) == 11,
+            LINE( "" ) );
+        STRCOMP( stringblob.buf, "thisisablob", LINE("") );
+        tausch_stats_get( &st2 );
+        test( st2.rows == st.rows, LINE( "rows %d", (int)(st2.rows - st.rows) ) );
+    }
+
+    {
+        printf( "\n### Names of schema \n\n" );
+
+        static struct { char *name; tsch_size_t n; } known[] = {
+            { "big", TAUSCH_NAM_JSON_SAMPLE_big }, { "count", TAUSCH_NAM_JSON_SAMPLE_count },
+            { "flag", TAUSCH_NAM_JSON_SAMPLE_flag }, { "label", TAUSCH_NAM_JSON_SAMPLE_label },
+            { "level", TAUSCH_NAM_JSON_SAMPLE_level }, { "mark", TAUSCH_NAM_JSON_SAMPLE_mark },
+            { "offset", TAUSCH_NAM_JSON_SAMPLE_offset }, { "origin", TAUSCH_NAM_JSON_SAMPLE_origin },
+            { "path", TAUSCH_NAM_JSON_SAMPLE_path }, { "point", TAUSCH_NAM_JSON_SAMPLE_point },
+            { "ratio", TAUSCH_NAM_JSON_SAMPLE_ratio }, { "raw", TAUSCH_NAM_JSON_SAMPLE_raw },
+            { "sample", TAUSCH_NAM_JSON_SAMPLE_sample }, { "small", TAUSCH_NAM_JSON_SAMPLE_small },
+            { "x", TAUSCH_NAM_JSON_SAMPLE_x }, { "y", TAUSCH_NAM_JSON_SAMPLE_y },
+            { "", 0 }, { "a", 0 }, { "bigger", 0 }, { "coun", 0 }, { "z", 0 }, { "pointx", 0 } };
+        static tsch_size_t hash[100];
+        tausch_schema_t schema;
+        tausch_schema_init( &schema, tauschema_json_sample_flatrows, tauschema_json_sample_flatsize );
+
+        printf( "   -- Binary search \n" );
+        for( size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++ )
+        {
+            tsch_size_t n = tausch_schema_name_n( &schema, known[i].name );
+            test( n == known[i].n, LINE( "%s is %d", known[i].name, (int)n ) );
+        }
+
+        printf( "   -- Perfect hash \n" );
+        tsch_size_t n = tausch_schema_hash( &schema, NULL, 0 );
+        test( (n > 16) && (n <= 100), LINE( "size %d", (int)n ) );
+        test( (tausch_schema_hash( &schema, hash, n - 1 ) == n) && (schema.hash == NULL), LINE( "" ) );
+        test( (tausch_schema_hash( &schema, hash, 100 ) == n) && (schema.hash == hash), LINE( "" ) );
+        for( size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++ )
+        {
+            tsch_size_t k = tausch_schema_name_n( &schema, known[i].name );
+            test( k == known[i].n, LINE( "%s is %d", known[i].name, (int)k ) );
+        }
+
+        printf( "   -- Many names \n" );
+        static uint8_t blob[1 + 1000 * 6];
+        static tsch_size_t big[4000];
+        char name[8];
+        bool ok = true;
+        tausch_schema_t many = { .names = { .buf = blob, .len = sizeof(blob) } };
+        blob[0] = 0;
+        for( int i = 0; i < 1000; i++ ) snprintf( (char*)&blob[1 + i * 6], 6, "n%04d", i );
+        for( int i = 0; (i < 1000) && ok; i++ )
+        {
+            snprintf( name, sizeof(name), "n%04d", i );
+            ok = tausch_schema_name_n( &many, name ) == 1 + i * 6;
+        }
+        test( ok, LINE( "" ) );
+        n = tausch_schema_hash( &many, big, 4000 );
+        test( (n <= 4000) && (many.hash == big), LINE( "size %d", (int)n ) );
+        for( int i = 0; (i < 1000) && ok; i++ )
+        {
+            snprintf( name, sizeof(name), "n%04d", i );
+            ok = tausch_schema_name_n( &many, name ) == 1 + i * 6;
+        }
+        test( ok, LINE( "" ) );
+        test( tausch_schema_name_n( &many, "n1000" ) == 0, LINE( "" ) );
+        test( tausch_schema_name_n( &many, "n000" ) == 0, LINE( "" ) );
     }
 
     printf( " flater done \n\n");
@@ -0,0 +1,132 @@
+#include "testmain.h"
+#include "../src/tauschema_index.h"
+
+/**
+ * Compare the iterator against index entry
+ */
+static bool same( tausch_iter_t *iter, tausch_index_t *index, tsch_size_t n )
+{
+    tausch_iter_t ix;
+    tausch_index_iter( index, n, &ix );
+    return (iter->idx == ix.idx) && (iter->next == ix.next) && (iter->val == ix.val) && (iter->tag == ix.tag)
+        && (iter->vlen == ix.vlen) && (iter->scope == ix.scope) && (iter->lc == ix.lc);
+}
+
+bool test_index( void )
+{
+    uint8_t buf[300];   // the message to index
+    char errorbuf[500];   // temporary error message
+
+    printf( "\n### Structural index tests \n\n" );
+
+    tausch_format_buf( buf );
+    tausch_iter_t iter_ini = TAUSCH_ITER_INIT( buf, sizeof(buf) );
+    {
+        printf( "   -- Producing the message \n" );
+        tausch_iter_t iter = iter_ini;
+        uint32_t u32 = 0x12345678;
+        bool t = true;
+        TAUSCH_BLOB_NEW( blob, 100 );
+        memset( blob.buf, 0x80, blob.len );   // continuation bits in the blob must not confuse
+
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write( &iter, 3, &u32 ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_scope( &iter, 40 ), LINE( "" ) );
+        test( tausch_iter_enter_scope( &iter ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write( &iter, 1, &blob ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_scope( &iter, 2 ), LINE( "" ) );
+        test( tausch_iter_enter_scope( &iter ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write( &iter, 300, &t ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_end( &iter ), LINE( "" ) );
+        test( tausch_iter_exit_scope( &iter ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_stuffing( &iter, 3 ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write( &iter, 5, &blob ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_end( &iter ), LINE( "" ) );
+        test( tausch_iter_exit_scope( &iter ), LINE( "" ) );
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write( &iter, 4, &t ), LINE( "" ) );
+    }
+
+    TAUSCH_INDEX_NEW( index, 20 );
+    {
+        printf( "   -- Building and comparing against the iterator \n" );
+        test( tausch_index_build( &index, buf, sizeof(buf) ), LINE( "building the index failed" ) );
+        test( index.count == 11, LINE( "there must be 11 entries, not %d", index.count ) );
+
+        // walk all the message with iterator, the index must have the same sequence
+        tausch_iter_t iter = iter_ini;
+        tsch_size_t n = 0;
+        for( ;; )
+        {
+            if( tausch_iter_next( &iter ) || tausch_iter_is_end( &iter ) )
+            {
+                test( same( &iter, &index, n ), LINE( "entry %d does not match the iterator", n ) );
+                n += 1;
+            }
+            if( tausch_iter_is_scope( &iter ) ) test( tausch_iter_enter_scope( &iter ), LINE( "" ) );
+            else if( tausch_iter_is_eof( &iter ) || !tausch_iter_is_ok( &iter ) ) break;
+            else if( tausch_iter_is_end( &iter ) ) test( tausch_iter_exit_scope( &iter ), LINE( "" ) );
+        }
+        test( n == index.count, LINE( "iterator walked %d entries", n ) );
+        test( tausch_index_buff_free( &index ) == tausch_iter_buff_free( &iter_ini ), LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Navigating the index \n" );
+        tsch_size_t n = tausch_index_go_to_tag( &index, 0, 4 );
+        test( n == 9, LINE( "the tag 4 is entry 9, not %d", n ) );
+        test( tausch_index_go_to_tag( &index, 0, 300 ) == TSCH_NOTHING, LINE( "tag 300 is not at root" ) );
+
+        tsch_size_t s = tausch_index_go_to_tag( &index, 0, 40 );
+        test( s == 1, LINE( "" ) );
+        test( tausch_index_next( &index, s ) == 9, LINE( "next must skip the scope" ) );
+        n = tausch_index_enter_scope( &index, s );
+        test( n == 2, LINE( "" ) );
+        n = tausch_index_go_to_tag( &index, n, 5 );
+        test( n == 7, LINE( "the tag 5 is entry 7, not %d", n ) );
+        test( tausch_index_exit_scope( &index, n ) == 9, LINE( "" ) );
+        test( tausch_index_exit_scope( &index, 9 ) == 10, LINE( "exit from root stays at EOF" ) );
+        test( tausch_index_enter_scope( &index, 0 ) == TSCH_NOTHING, LINE( "" ) );
+
+        // the iterator from the index continues as the iterator does
+        tausch_iter_t iter;
+        tausch_index_iter( &index, tausch_index_go_to_tag( &index, 3, 2 ), &iter );
+        test( tausch_iter_enter_scope( &iter ), LINE( "" ) );
+        test( tausch_iter_go_to_tag( &iter, 300 ), LINE( "" ) );
+        test( same( &iter, &index, 4 ), LINE( "" ) );
+        tausch_index_iter( &index, 1, &iter );
+        test( tausch_iter_next( &iter ), LINE( "" ) );
+        test( same( &iter, &index, 9 ), LINE( "" ) );
+        tausch_index_iter( &index, 11, &iter );
+        test( !tausch_iter_is_ok( &iter ), LINE( "iterator of missing entry must be broken" ) );
+    }
+
+    {
+        printf( "   -- Broken messages \n" );
+        TAUSCH_INDEX_NEW( small, 5 );
+        test( !tausch_index_build( &small, buf, sizeof(buf) ), LINE( "too few entries must fail" ) );
+
+        uint8_t over[] = { 0x0a, 0x20, 0x00, 0x07 };
+        test( !tausch_index_build( &index, over, sizeof(over) ), LINE( "value over the buffer must fail" ) );
+
+        uint8_t eos[] = { 0x0a, 0x01, 0x00, 0x03, 0x07 };
+        test( !tausch_index_build( &index, eos, sizeof(eos) ), LINE( "END at root must fail" ) );
+
+        uint8_t noeof[] = { 0x0a, 0x01, 0x00, 0x05 };
+        test( !tausch_index_build( &index, noeof, sizeof(noeof) ), LINE( "missing EOF must fail" ) );
+
+        uint8_t open[] = { 0x05, 0x0a, 0x01, 0x00, 0x07 };
+        test( tausch_index_build( &index, open, sizeof(open) ), LINE( "EOF closes the scopes" ) );
+        test( tausch_index_next( &index, 0 ) == 2, LINE( "" ) );
+    }
+
+    return true;
+}
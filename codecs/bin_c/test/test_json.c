@@ -0,0 +1,224 @@
+#include "testmain.h"
+#include "../src/tauschema_json.h"
+#include "../src/tauschema_writer.h"
+#include "tauschema_json_sample_schema.h"
+#include "tauschema_device_info_schema.h"
+
+static char json_out[1000];   // text collected by the sink
+static size_t json_len;
+
+static bool json_sink( void *ctx, const char *data, size_t len )
+{
+    size_t *calls = ctx;
+    *calls += 1;
+    if( json_len + len > sizeof(json_out) ) return false;
+    memcpy( &json_out[json_len], data, len );
+    json_len += len;
+    return true;
+}
+
+bool test_json( void )
+{
+    uint8_t msg[200];
+    char text[400];
+    char errorbuf[500];   // temporary error message
+    tausch_schema_t schema;
+    tausch_writer_t wr;
+    tausch_json_t js;
+
+    printf( "\n### TLV to JSON tests \n\n" );
+
+    tausch_schema_init( &schema, tauschema_json_sample_flatrows, tauschema_json_sample_flatsize );
+    {
+        bool flag = true;
+        uint16_t count = 300;
+        int8_t offset = -5;
+        double ratio = 0.1;
+        float level = 1.5f;
+        int32_t x = -1, y = 2;
+        uint64_t big = UINT64_MAX;
+        int64_t small = INT64_MIN;
+        uint8_t raw[4] = { 0, 1, 2, 3 };
+        tausch_blob_t rawblob = { .buf = raw, .len = 4 };
+        uint8_t zeros[2] = { 0 };
+        tausch_blob_t pad = { .buf = zeros, .len = 2 };
+
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 1, &flag );
+        tausch_writer_write( &wr, 2, &count );
+        tausch_writer_write( &wr, 0, &pad );   // stuffing is skipped
+        tausch_writer_write( &wr, 3, &offset );
+        tausch_writer_write( &wr, 4, &ratio );
+        tausch_writer_write( &wr, 5, &level );
+        tausch_writer_write( &wr, 6, "a\"b\n\x01/" );
+        tausch_writer_write( &wr, 7, &rawblob );
+        tausch_writer_write( &wr, 40, &count );   // not in schema, skipped
+        tausch_writer_scope( &wr, 8 );
+        tausch_writer_write( &wr, 1, &x );
+        tausch_writer_write( &wr, 2, &y );
+        tausch_writer_end( &wr );
+        tausch_writer_scope( &wr, 9 );
+        tausch_writer_scope( &wr, 1 );
+        x = 3;
+        y = 4;
+        tausch_writer_write( &wr, 1, &x );
+        tausch_writer_write( &wr, 2, &y );
+        tausch_writer_end( &wr );
+        tausch_writer_write( &wr, 2, "m" );
+        tausch_writer_end( &wr );
+        tausch_writer_write( &wr, 10, &big );
+        tausch_writer_write( &wr, 11, &small );
+        tausch_writer_end( &wr );
+        test( tausch_writer_is_ok( &wr ), LINE( "" ) );
+    }
+    tsch_size_t len = tausch_writer_len( &wr );
+    const char *expect = "{\"sample\":{\"flag\":true,\"count\":300,\"offset\":-5,\"ratio\":0.1,\"level\":1.5,"
+        "\"label\":\"a\\\"b\\n\\u0001/\",\"raw\":\"AAECAw==\",\"origin\":{\"x\":-1,\"y\":2},"
+        "\"path\":[{\"point\":{\"x\":3,\"y\":4}},{\"mark\":\"m\"}],"
+        "\"big\":18446744073709551615,\"small\":-9223372036854775808}}";
+
+    {
+        printf( "   -- Converting into buffer \n" );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        size_t n = tausch_json_encode( &js, &schema, msg, len );
+        test( n == strlen( expect ), LINE( "produced %d", (int)n ) );
+        test( strcmp( text, expect ) == 0, LINE( "got %s", text ) );
+
+        printf( "   -- Buffer overflow \n" );
+        tausch_json_init( &js, text, n, NULL, NULL );
+        test( tausch_json_encode( &js, &schema, msg, len ) == 0, LINE( "no room for 0" ) );
+        tausch_json_init( &js, text, 20, NULL, NULL );
+        test( tausch_json_encode( &js, &schema, msg, len ) == 0, LINE( "" ) );
+        test( !js.ok, LINE( "" ) );
+
+        printf( "   -- Broken message \n" );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( tausch_json_encode( &js, &schema, msg, len - 1 ) == 0, LINE( "no EOF" ) );
+    }
+
+    {
+        printf( "   -- Converting into sink \n" );
+        size_t calls = 0;
+        char small[16];
+        json_len = 0;
+        tausch_json_init( &js, small, sizeof(small), json_sink, &calls );
+        size_t n = tausch_json_encode( &js, &schema, msg, len );
+        test( (n == strlen( expect )) && (json_len == n), LINE( "produced %d", (int)n ) );
+        test( (json_len == n) && (memcmp( json_out, expect, n ) == 0), LINE( "" ) );
+        test( calls > n / sizeof(small), LINE( "sink called %d times", (int)calls ) );
+
+        printf( "   -- Long strings \n" );
+        char label[100];
+        memset( label, 'z', sizeof(label) - 1 );
+        label[sizeof(label) - 1] = 0;
+        label[40] = '\t';
+        label[70] = '\\';
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 6, label );
+        tausch_writer_end( &wr );
+        json_len = 0;
+        tausch_json_init( &js, small, sizeof(small), json_sink, &calls );
+        n = tausch_json_encode( &js, &schema, msg, tausch_writer_len( &wr ) );
+        test( n == 20 + 99 + 2 + 3, LINE( "produced %d", (int)n ) );
+        test( (memcmp( &json_out[20 + 40], "\\tz", 3 ) == 0) && (memcmp( &json_out[20 + 70 + 1], "\\\\z", 3 ) == 0),
+            LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Schema without names \n" );
+        tausch_schema_t devinfo_schema;
+        uint32_t msglen = 1400;
+        tausch_schema_init( &devinfo_schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 8, &msglen );
+        tausch_writer_end( &wr );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( tausch_json_encode( &js, &devinfo_schema, msg, tausch_writer_len( &wr ) ) > 0, LINE( "" ) );
+        test( strcmp( text, "{\"1\":{\"8\":1400}}" ) == 0, LINE( "got %s", text ) );
+    }
+
+    {
+        printf( "   -- JSON to TLV \n" );
+        tausch_json_key_t key[30];   // one per schema row
+        tausch_json_keys_t keys;
+        uint8_t back[200];
+        test( !tausch_json_keys_init( &keys, &schema, key, 5 ), LINE( "too small table" ) );
+        test( tausch_json_keys_init( &keys, &schema, key, 20 ), LINE( "" ) );
+        test( keys.len == 17, LINE( "keys %d", (int)keys.len ) );
+        test( (key[0].count == 1) && (key[1].ntype == TSCH_COLLECTION) && (key[1].count == 11), LINE( "" ) );
+        const tausch_json_key_t *k = &key[key[1].first];
+        for( tsch_size_t i = 1; i < key[1].count; i++ )
+        {
+            test( k[i - 1].name < k[i].name, LINE( "not sorted at %d", (int)i ) );
+        }
+
+        tausch_writer_init( &wr, back, sizeof(back) );
+        tsch_size_t blen = tausch_json_decode( &keys, expect, strlen( expect ), &wr );
+        test( blen > 0, LINE( "" ) );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( tausch_json_encode( &js, &schema, back, blen ) > 0, LINE( "" ) );
+        test( strcmp( text, expect ) == 0, LINE( "got %s", text ) );
+        test( blen == len - 4 - 5, LINE( "no stuffing and unknown, got %d", (int)blen ) );
+
+        printf( "   -- Escapes, white space and null \n" );
+        const char *in = " { \"sample\" : {\n\t\"la\\u0062el\": \"\\u00e4\\ud83d\\ude00\\/\\\"\", \"count\" : null,"
+            " \"raw\":\"AAE\", \"level\": 2, \"offset\": -1e2, \"path\": [] } }\n";
+        tausch_writer_init( &wr, back, sizeof(back) );
+        blen = tausch_json_decode( &keys, in, strlen( in ), &wr );
+        test( blen > 0, LINE( "" ) );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( tausch_json_encode( &js, &schema, back, blen ) > 0, LINE( "" ) );
+        test( strcmp( text, "{\"sample\":{\"label\":\"\xc3\xa4\xf0\x9f\x98\x80/\\\"\",\"count\":null,"
+            "\"raw\":\"AAE=\",\"level\":2,\"offset\":-100,\"path\":[]}}" ) == 0, LINE( "got %s", text ) );
+
+        printf( "   -- Bad input \n" );
+        static const char *bad[] = {
+            "{\"sample\":{\"unknown\":1}}",
+            "{\"sample\":{\"count\":65536}}",
+            "{\"sample\":{\"count\":-1}}",
+            "{\"sample\":{\"count\":1.5}}",
+            "{\"sample\":{\"offset\":128}}",
+            "{\"sample\":{\"offset\":-129}}",
+            "{\"sample\":{\"big\":18446744073709551616}}",
+            "{\"sample\":{\"level\":1e39}}",
+            "{\"sample\":{\"flag\":1}}",
+            "{\"sample\":{\"label\":5}}",
+            "{\"sample\":{\"label\":\"\\ud83d\"}}",
+            "{\"sample\":{\"label\":\"a\nb\"}}",
+            "{\"sample\":{\"raw\":\"A\"}}",
+            "{\"sample\":{\"raw\":\"A*==\"}}",
+            "{\"sample\":{\"path\":{}}}",
+            "{\"sample\":{\"path\":[{\"x\":1}]}}",
+            "{\"sample\":{\"flag\":true,}}",
+            "{\"sample\":{\"flag\":true}",
+            "{\"sample\":{}} x",
+            "[]",
+        };
+        for( size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++ )
+        {
+            tausch_writer_init( &wr, back, sizeof(back) );
+            test( tausch_json_decode( &keys, bad[i], strlen( bad[i] ), &wr ) == 0, LINE( "accepted %s", bad[i] ) );
+        }
+        tausch_writer_init( &wr, back, 10 );
+        test( tausch_json_decode( &keys, expect, strlen( expect ), &wr ) == 0, LINE( "no room" ) );
+
+        printf( "   -- Schema without names \n" );
+        tausch_schema_t devinfo_schema;
+        tausch_schema_init( &devinfo_schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        test( tausch_json_keys_init( &keys, &devinfo_schema, key, 30 ), LINE( "" ) );
+        in = "{\"1\":{\"8\":1400}}";
+        tausch_writer_init( &wr, back, sizeof(back) );
+        blen = tausch_json_decode( &keys, in, strlen( in ), &wr );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( (blen > 0) && (tausch_json_encode( &js, &devinfo_schema, back, blen ) > 0), LINE( "" ) );
+        test( strcmp( text, in ) == 0, LINE( "got %s", text ) );
+        tausch_writer_init( &wr, back, sizeof(back) );
+        test( tausch_json_decode( &keys, "{\"1\":{\"x\":1}}", 13, &wr ) == 0, LINE( "" ) );
+    }
+
+    printf( " json done \n\n");
+    return true;
+}
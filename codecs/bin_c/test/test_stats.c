@@ -0,0 +1,134 @@
+#include "testmain.h"
+#include "../src/tauschema_stats.h"
+#include "../src/tauschema_batch.h"
+#include "../src/tauschema_writer.h"
+#include "tauschema_device_info_schema.h"
+
+#ifdef TAUSCH_STATS
+
+static bool count_msg( tausch_cflater_t *cfl, size_t n, void *ctx )
+{
+    uint32_t msglen = 0;
+    return tausch_cflater_read( cfl, &msglen, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) > 0;
+}
+
+bool test_stats( void )
+{
+    uint8_t msg[40];
+    char errorbuf[500];   // temporary error message
+    tausch_writer_t wr;
+    tausch_iter_t iter;
+    tausch_stats_t st;
+    uint8_t u8 = 1;
+    uint32_t u32 = 2;
+    uint8_t zeros[8] = { 0 };
+    tausch_blob_t pad = { .buf = zeros, .len = 8 };
+    tausch_blob_t pad2 = { .buf = zeros, .len = 2 };
+
+    printf( "\n### Hot path counters tests \n\n" );
+
+    {
+        printf( "   -- Stepping over the message \n" );
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_write( &wr, 1, &u8 );   // 3 bytes
+        tausch_writer_scope( &wr, 2 );   // 1 byte
+        tausch_writer_write( &wr, 5, &u32 );   // 6 bytes
+        tausch_writer_end( &wr );   // 1 byte
+        tausch_writer_write( &wr, 3, &u8 );   // 3 bytes
+
+        tausch_stats_clear();
+        tausch_iter_init( &iter, msg, tausch_writer_len( &wr ) );
+        while( tausch_iter_next( &iter ) )
+            ;
+        tausch_stats_get( &st );
+        test( st.tlvs == 6, LINE( "tlvs %d", (int)st.tlvs ) );
+        test( st.scanned == 15, LINE( "scanned %d", (int)st.scanned ) );
+        test( (st.failures == 0) && (st.rollbacks == 0), LINE( "" ) );
+
+        printf( "   -- Failures and rollbacks \n" );
+        tausch_iter_init( &iter, msg, 2 );   // the value is cut
+        test( !tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_stats_get( &st )->failures == 1, LINE( "failures %d", (int)st.failures ) );
+
+        tausch_iter_init( &iter, msg, tausch_writer_len( &wr ) );
+        test( tausch_iter_next( &iter ) && tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_enter_scope( &iter ) && tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_typX( &iter, 5, &u8, 1 ) == 0, LINE( "length must match" ) );
+        tausch_stats_get( &st );
+        test( (st.rollbacks == 1) && (st.failures == 2), LINE( "rollbacks %d", (int)st.rollbacks ) );
+        tausch_iter_init( &iter, msg, tausch_writer_len( &wr ) );
+        test( !tausch_iter_erase( &iter ), LINE( "clean iterator can not be erased" ) );
+        test( tausch_stats_get( &st )->failures == 3, LINE( "failures %d", (int)st.failures ) );
+
+        printf( "   -- Merging of stuffing \n" );
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_write( &wr, 0, &pad );
+        tausch_writer_write( &wr, 0, &pad2 );
+        tausch_writer_write( &wr, 3, &u8 );
+        tausch_iter_init( &iter, msg, tausch_writer_len( &wr ) );
+        test( tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_write_typX( &iter, 2, &u8, 1 ) == 1, LINE( "" ) );
+        test( tausch_stats_get( &st )->merges == 1, LINE( "merges %d", (int)st.merges ) );
+    }
+
+    {
+        printf( "   -- Flat rows and siblings \n" );
+        tausch_schema_t schema;
+        tausch_flater_t fl;
+        tausch_schema_init( &schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 8, &u32 );
+        tausch_writer_end( &wr );
+        tausch_stats_clear();
+        tausch_flater_init( &fl, &schema, msg, tausch_writer_len( &wr ) );
+        tausch_stats_get( &st );
+        tausch_flater_next( &fl );
+        tausch_stats_t st2;
+        tausch_stats_get( &st2 );
+        test( (fl.idx != 0) && (st2.compares - st.compares == 1), LINE( "compares %d", (int)(st2.compares - st.compares) ) );
+        test( st2.rows - st.rows == 2, LINE( "rows %d", (int)(st2.rows - st.rows) ) );
+        test( tausch_flater_read( &fl, &u32, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) > 0, LINE( "" ) );
+        tausch_stats_get( &st );
+        test( st.rows > st2.rows, LINE( "" ) );
+
+        printf( "   -- Total of the threads \n" );
+        static uint8_t msgs[20][16];
+        tausch_view_t view[20];
+        for( int i = 0; i < 20; i++ )
+        {
+            memcpy( msgs[i], msg, tausch_writer_len( &wr ) );
+            view[i].buf = msgs[i];
+            view[i].len = tausch_writer_len( &wr );
+        }
+        tausch_stats_merge();
+        test( tausch_stats_get( &st )->rows == 0, LINE( "merged counters are cleared" ) );
+        tausch_stats_total( &st );
+        test( st.rows >= st2.rows, LINE( "rows %d", (int)st.rows ) );
+        uint64_t rows = st.rows;
+
+        TAUSCH_POOL_NEW( pool, 2 );
+        test( tausch_pool_init( &pool, pool_worker, 2 ), LINE( "" ) );
+        test( tausch_pool_run( &pool, &schema, view, 20, count_msg, NULL ) == 20, LINE( "" ) );
+        tausch_pool_close( &pool );
+        test( tausch_stats_get( &st )->rows == 0, LINE( "the workers count for themselves" ) );
+        tausch_stats_total( &st );
+        test( st.rows >= rows + 20 * 3, LINE( "rows %d", (int)st.rows ) );
+        test( st.tlvs >= 20 * 2, LINE( "tlvs %d", (int)st.tlvs ) );
+        tausch_stats_clear();
+        test( tausch_stats_total( &st )->tlvs == 0, LINE( "" ) );
+    }
+
+    printf( " stats done \n\n");
+    return true;
+}
+
+#else
+
+bool test_stats( void )
+{
+    printf( "\n### Hot path counters are not compiled in, define TAUSCH_STATS \n\n" );
+    return true;
+}
+
+#endif
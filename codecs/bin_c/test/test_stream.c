@@ -0,0 +1,209 @@
+#include "testmain.h"
+#include "../src/tauschema_stream.h"
+#include "../src/tauschema_writer.h"
+
+/**
+ * Feed the message in chunks into the decoder with buffer of size bytes, consuming the
+ * decoded bytes when more is needed. The tags delivered are printed into seq, '.' for EOF
+ * and '!' when the decoder did break.
+ */
+static void stream_walk( uint8_t *msg, size_t len, tsch_size_t chunk, tsch_size_t size, char *seq )
+{
+    uint8_t buf[64];
+    tausch_stream_t st;
+    size_t sent = 0;
+    seq[0] = 0;
+    tausch_stream_init( &st, buf, size );
+    for( ;; )
+    {
+        if( tausch_stream_next( &st ) )
+        {
+            tausch_view_t view;
+            char *s = seq + strlen( seq );
+            if( tausch_iter_view( &st.iter, &view ) && (view.len > 1) && (view.buf[1] != view.buf[0] + 1) )
+            {
+                sprintf( s, "x" );   // the value got broken
+            }
+            else
+            {
+                sprintf( s, "%d%s ", (int)st.iter.tag, tausch_iter_is_scope( &st.iter ) ? "{" : "" );
+            }
+            continue;
+        }
+        if( st.eof || !tausch_stream_is_ok( &st ) || (sent >= len) )
+        {
+            strcat( seq, st.eof ? "." : "!" );
+            return;
+        }
+        tsch_size_t room;
+        (void)tausch_stream_consume( &st );
+        uint8_t *p = tausch_stream_space( &st, &room );
+        tsch_size_t n = (len - sent) < chunk ? (tsch_size_t)(len - sent) : chunk;
+        n = n < room ? n : room;
+        memcpy( p, &msg[sent], n );
+        sent += n;
+        tausch_stream_fill( &st, n );
+    }
+}
+
+bool test_stream( void )
+{
+    uint8_t msg[100];
+    char seq[100];
+    char errorbuf[500];   // temporary error message
+
+    printf( "\n### Stream decoder tests \n\n" );
+
+    tausch_writer_t wr;
+    uint32_t u32 = 0x04030201;
+    uint8_t u8 = 9;
+    TAUSCH_BLOB_NEW( blob, 20 );
+    for( int i = 0; i < blob.len; i++ ) blob.buf[i] = (uint8_t)i;
+
+    tausch_writer_init( &wr, msg, sizeof(msg) );
+    test( tausch_writer_scope( &wr, 5 ), LINE( "" ) );
+    test( tausch_writer_write( &wr, 1, &u32 ), LINE( "" ) );
+    test( tausch_writer_write( &wr, 2, &blob ), LINE( "" ) );
+    test( tausch_writer_end( &wr ), LINE( "" ) );
+    test( tausch_writer_sized_scope( &wr, 6 ), LINE( "" ) );
+    test( tausch_writer_write( &wr, 3, &u8 ), LINE( "" ) );
+    test( tausch_writer_write( &wr, 4, (bool*)NULL ), LINE( "" ) );
+    test( tausch_writer_end( &wr ), LINE( "" ) );
+    test( tausch_writer_write( &wr, 7, (bool*)NULL ), LINE( "" ) );
+    size_t len = tausch_writer_len( &wr );
+    tausch_iter_t iter;
+    tausch_writer_iter( &wr, &iter );
+    test( tausch_iter_next( &iter ) && tausch_iter_enter_scope( &iter ), LINE( "" ) );
+    test( tausch_iter_next( &iter ) && tausch_iter_erase( &iter ), LINE( "" ) );
+    char *expect = "5{ 2 0 6{ 3 4 0 7 .";
+
+    {
+        printf( "   -- Decoding in chunks \n" );
+        for( tsch_size_t chunk = 1; chunk < 9; chunk++ )
+        {
+            stream_walk( msg, len, chunk, 24, seq );
+            test( strcmp( seq, expect ) == 0, LINE( "chunk %d: %s", chunk, seq ) );
+        }
+        stream_walk( msg, len, 100, 64, seq );
+        test( strcmp( seq, expect ) == 0, LINE( "%s", seq ) );
+        stream_walk( msg, len, 5, 21, seq );
+        test( strcmp( seq, "5{ !" ) == 0, LINE( "the blob does not fit: %s", seq ) );
+    }
+
+    {
+        printf( "   -- Needed bytes \n" );
+        uint8_t buf[40];
+        tausch_stream_t st;
+        tsch_size_t room;
+        tausch_stream_init( &st, buf, sizeof(buf) );
+        test( !tausch_stream_next( &st ) && (tausch_stream_need( &st ) == 1), LINE( "" ) );
+        memcpy( tausch_stream_space( &st, &room ), msg, 10 );
+        test( room == sizeof(buf), LINE( "" ) );
+        test( tausch_stream_fill( &st, 10 ), LINE( "" ) );
+        test( tausch_stream_next( &st ) && (st.iter.tag == 5) && (st.scope == 1), LINE( "" ) );
+        test( !tausch_stream_next( &st ), LINE( "" ) );
+        test( tausch_stream_need( &st ) == 19, LINE( "need %d", tausch_stream_need( &st ) ) );
+        test( tausch_stream_consume( &st ) == 7, LINE( "the stuffing is dropped" ) );
+        test( !tausch_iter_is_ok( &st.iter ), LINE( "" ) );
+        memcpy( tausch_stream_space( &st, &room ), &msg[10], 19 );
+        test( tausch_stream_fill( &st, 19 ) && (tausch_stream_need( &st ) == 0), LINE( "" ) );
+        test( tausch_stream_next( &st ) && (st.iter.tag == 2) && (st.iter.vlen == 20), LINE( "" ) );
+        test( tausch_stream_fill( &st, 100 ) == false, LINE( "more than the space" ) );
+    }
+
+    {
+        printf( "   -- Broken messages \n" );
+        uint8_t bad[10];
+        memcpy( bad, "\x03\x07", 2 );
+        stream_walk( bad, 2, 1, 10, seq );
+        test( strcmp( seq, "!" ) == 0, LINE( "END at root %s", seq ) );
+        memcpy( bad, "\x05\x07", 2 );
+        stream_walk( bad, 2, 1, 10, seq );
+        test( strcmp( seq, "1{ !" ) == 0, LINE( "EOF in scope %s", seq ) );
+        memcpy( bad, "\x17\x03\x00\x03\x07", 5 );
+        stream_walk( bad, 5, 1, 10, seq );
+        test( strcmp( seq, "5{ !" ) == 0, LINE( "wrong length of sized scope %s", seq ) );
+        memcpy( bad, "\x17\x02\x00\x03\x07", 5 );
+        stream_walk( bad, 5, 2, 10, seq );
+        test( strcmp( seq, "5{ 0 ." ) == 0, LINE( "%s", seq ) );
+        memcpy( bad, "\x86\x80\x80\x80", 4 );
+        stream_walk( bad, 4, 1, 3, seq );
+        test( strcmp( seq, "!" ) == 0, LINE( "the header does not fit %s", seq ) );
+    }
+
+    {
+        printf( "   -- Framing of messages \n" );
+        uint8_t m2[20];
+        uint8_t bytes[3] = { 0x07, 0x07, 0x03 };
+        tausch_blob_t b3 = { .buf = bytes, .len = 3 };
+        uint8_t u7 = 7;
+        tausch_writer_init( &wr, m2, sizeof(m2) );
+        tausch_writer_write( &wr, 1, &b3 );
+        tausch_writer_write( &wr, 2, &u7 );
+        size_t len2 = tausch_writer_len( &wr );
+        test( len2 == 9, LINE( "" ) );
+
+        // the messages back to back with corrupted bytes between
+        uint8_t flow[200];
+        size_t flen = 0;
+        memcpy( &flow[flen], msg, len ); flen += len;
+        memcpy( &flow[flen], m2, len2 ); flen += len2;
+        memcpy( &flow[flen], "\x07\x03\x07", 3 ); flen += 3;
+        memcpy( &flow[flen], m2, len2 ); flen += len2;
+        size_t expect_len[4] = { len, len2, 1, len2 };
+
+        for( tsch_size_t chunk = 1; chunk < 70; chunk += 4 )
+        {
+            uint8_t buf[64];
+            tausch_framer_t fr;
+            tausch_view_t view;
+            size_t sent = 0;
+            int nmsg = 0;
+            bool ok = true;
+            tausch_framer_init( &fr, buf, sizeof(buf) );
+            while( sent < flen )
+            {
+                tsch_size_t room;
+                uint8_t *p = tausch_framer_space( &fr, &room );
+                tsch_size_t n = (flen - sent) < chunk ? (tsch_size_t)(flen - sent) : chunk;
+                n = n < room ? n : room;
+                memcpy( p, &flow[sent], n );
+                sent += n;
+                tausch_framer_fill( &fr, n ); if( n == 0 ) { printf("DBG stuck chunk %d sent %d start %d have %d rs %d ok %d need %d\n", chunk, (int)sent, fr.start, fr.st.have, fr.resync, fr.st.size, fr.st.need); break; }
+                while( tausch_framer_next( &fr, &view ) )
+                {
+                    ok &= (nmsg < 4) && (view.len == expect_len[nmsg]) && (view.buf[view.len - 1] == 0x07);
+                    ok &= (nmsg != 1) || (memcmp( view.buf, m2, len2 ) == 0);
+                    nmsg += 1; if( nmsg > 10 ) { printf("DBG many chunk %d len %d start %d\n", chunk, view.len, fr.start); break; }
+                }
+            }
+            test( ok && (nmsg == 4) && (fr.dropped == 2), LINE( "chunk %d, %d messages", chunk, nmsg ) );
+        }
+
+        // the message that does not fit is dropped
+        flen = 0;
+        memcpy( &flow[flen], msg, len ); flen += len;
+        memcpy( &flow[flen], m2, len2 ); flen += len2;
+        uint8_t buf[20];
+        tausch_framer_t fr;
+        tausch_view_t view;
+        tausch_view_t last = { 0 };
+        size_t sent = 0;
+        tausch_framer_init( &fr, buf, sizeof(buf) );
+        while( sent < flen )
+        {
+            tsch_size_t room;
+            uint8_t *p = tausch_framer_space( &fr, &room );
+            tsch_size_t n = (flen - sent) < room ? (tsch_size_t)(flen - sent) : room;
+            memcpy( p, &flow[sent], n );
+            sent += n;
+            tausch_framer_fill( &fr, n );
+            while( tausch_framer_next( &fr, &view ) ) last = view;
+        }
+        test( fr.dropped > 0, LINE( "" ) );
+        test( (last.len == len2) && (memcmp( last.buf, m2, len2 ) == 0), LINE( "synchronized again" ) );
+    }
+
+    printf( " stream done \n\n" );
+    return true;
+}
@@ -0,0 +1,212 @@
+#include "testmain.h"
+#include "../src/tauschema_json.h"
+#include "../src/tauschema_writer.h"
+#include "tauschema_json_sample_schema.h"
+#include "tauschema_json_sample_structs.h"
+#include "tauschema_device_info_structs.h"
+
+bool test_structs( void )
+{
+    uint8_t msg[300];
+    uint8_t out[300];
+    uint8_t again[300];
+    char text[400];
+    char errorbuf[500];   // temporary error message
+    tausch_schema_t schema;
+    tausch_writer_t wr;
+    tausch_json_t js;
+    tausch_json_sample_t s;
+    tausch_json_sample_t s2;
+
+    printf( "\n### Generated struct codecs \n\n" );
+
+    tausch_schema_init( &schema, tauschema_json_sample_flatrows, tauschema_json_sample_flatsize );
+    {
+        bool flag = true;
+        uint16_t count = 300;
+        int8_t offset = -5;
+        double ratio = 0.1;
+        float level = 1.5f;
+        int32_t x = -1, y = 2;
+        uint64_t big = UINT64_MAX;
+        int64_t small = INT64_MIN;
+        uint8_t raw[4] = { 0, 1, 2, 3 };
+        tausch_blob_t rawblob = { .buf = raw, .len = 4 };
+        uint8_t zeros[2] = { 0 };
+        tausch_blob_t pad = { .buf = zeros, .len = 2 };
+
+        tausch_writer_init( &wr, msg, sizeof(msg) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 1, &flag );
+        tausch_writer_write( &wr, 2, &count );
+        tausch_writer_write( &wr, 0, &pad );   // stuffing is skipped
+        tausch_writer_write( &wr, 3, &offset );
+        tausch_writer_write( &wr, 4, &ratio );
+        tausch_writer_write( &wr, 5, &level );
+        tausch_writer_write( &wr, 6, "label" );
+        tausch_writer_write( &wr, 7, &rawblob );
+        tausch_writer_write( &wr, 40, &count );   // not in schema, skipped
+        tausch_writer_scope( &wr, 41 );           // not in schema, jumped over
+        tausch_writer_write( &wr, 1, &x );
+        tausch_writer_end( &wr );
+        tausch_writer_scope( &wr, 8 );
+        tausch_writer_write( &wr, 1, &x );
+        tausch_writer_write( &wr, 2, &y );
+        tausch_writer_end( &wr );
+        tausch_writer_scope( &wr, 9 );
+        tausch_writer_scope( &wr, 1 );
+        x = 3;
+        y = 4;
+        tausch_writer_write( &wr, 1, &x );
+        tausch_writer_write( &wr, 2, &y );
+        tausch_writer_end( &wr );
+        tausch_writer_write( &wr, 0, &pad );
+        tausch_writer_write( &wr, 2, "m" );
+        tausch_writer_end( &wr );
+        tausch_writer_write( &wr, 10, &big );
+        tausch_writer_write( &wr, 11, &small );
+        tausch_writer_end( &wr );
+        test( tausch_writer_is_ok( &wr ), LINE( "" ) );
+    }
+    tsch_size_t len = tausch_writer_len( &wr );
+    const char *expect = "{\"sample\":{\"flag\":true,\"count\":300,\"offset\":-5,\"ratio\":0.1,\"level\":1.5,"
+        "\"label\":\"label\",\"raw\":\"AAECAw==\",\"origin\":{\"x\":-1,\"y\":2},"
+        "\"path\":[{\"point\":{\"x\":3,\"y\":4}},{\"mark\":\"m\"}],"
+        "\"big\":18446744073709551615,\"small\":-9223372036854775808}}";
+
+    {
+        printf( "   -- Decoding into struct \n" );
+        test( tausch_json_sample_decode( &s, msg, len ), LINE( "" ) );
+        test( s.has_sample, LINE( "" ) );
+        tausch_json_sample_sample_t *sm = &s.sample;
+        test( sm->has_flag && sm->flag, LINE( "" ) );
+        test( sm->has_count && (sm->count == 300), LINE( "count %d", sm->count ) );
+        test( sm->has_offset && (sm->offset == -5), LINE( "" ) );
+        test( sm->has_ratio && (sm->ratio == 0.1), LINE( "" ) );
+        test( sm->has_level && (sm->level == 1.5f), LINE( "" ) );
+        test( sm->has_label && (sm->label.len == 5) && (memcmp( sm->label.buf, "label", 5 ) == 0), LINE( "" ) );
+        test( (sm->label.buf > msg) && (sm->label.buf < msg + len), LINE( "label is view into message" ) );
+        test( sm->has_raw && (sm->raw.len == 4) && (sm->raw.buf[3] == 3), LINE( "" ) );
+        test( sm->has_origin && sm->origin.has_x && (sm->origin.x == -1), LINE( "" ) );
+        test( sm->origin.has_y && (sm->origin.y == 2), LINE( "" ) );
+        test( sm->has_path && (sm->path.n == 2), LINE( "path has %d", (int)sm->path.n ) );
+        test( (sm->path.item[0].tag == 1) && (sm->path.item[0].point.x == 3) && (sm->path.item[0].point.y == 4), LINE( "" ) );
+        test( (sm->path.item[1].tag == 2) && (sm->path.item[1].mark.len == 1) && (sm->path.item[1].mark.buf[0] == 'm'), LINE( "" ) );
+        test( sm->has_big && (sm->big == UINT64_MAX), LINE( "" ) );
+        test( sm->has_small && (sm->small == INT64_MIN), LINE( "" ) );
+
+        printf( "   -- Encoding from struct \n" );
+        tsch_size_t n = tausch_json_sample_encode( &s, out, sizeof(out) );
+        test( (n > 0) && (n < len), LINE( "encoded %d of %d", (int)n, (int)len ) );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( tausch_json_encode( &js, &schema, out, n ) == strlen( expect ), LINE( "" ) );
+        test( strcmp( text, expect ) == 0, LINE( "got %s", text ) );
+        test( tausch_json_sample_decode( &s2, out, n ), LINE( "" ) );
+        test( (s2.sample.path.n == 2) && (s2.sample.small == INT64_MIN), LINE( "" ) );
+        test( tausch_json_sample_encode( &s2, again, sizeof(again) ) == n, LINE( "" ) );
+        test( memcmp( again, out, n ) == 0, LINE( "second round is the same" ) );
+
+        printf( "   -- Absent items \n" );
+        memset( &s2, 0, sizeof(s2) );
+        s2.has_sample = 1;
+        s2.sample.has_count = 1;
+        s2.sample.count = 7;
+        n = tausch_json_sample_encode( &s2, out, sizeof(out) );
+        tausch_json_init( &js, text, sizeof(text), NULL, NULL );
+        test( (n > 0) && (tausch_json_encode( &js, &schema, out, n ) > 0), LINE( "" ) );
+        test( strcmp( text, "{\"sample\":{\"count\":7}}" ) == 0, LINE( "got %s", text ) );
+        test( tausch_json_sample_decode( &s2, out, n ), LINE( "" ) );
+        test( s2.sample.has_count && !s2.sample.has_flag && !s2.sample.has_path, LINE( "" ) );
+
+        printf( "   -- Buffer overflow \n" );
+        test( tausch_json_sample_encode( &s, out, 20 ) == 0, LINE( "" ) );
+        test( tausch_json_sample_encode( &s, out, 0 ) == 0, LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Broken messages \n" );
+        tsch_size_t n = tausch_json_sample_encode( &s, out, sizeof(out) );
+        test( !tausch_json_sample_decode( &s2, out, n - 1 ), LINE( "no EOF" ) );
+        out[n - 2] = 7;   // EOF in place of END of sample
+        test( !tausch_json_sample_decode( &s2, out, n ), LINE( "scope closed by EOF" ) );
+
+        printf( "   -- Unexpected scopes \n" );
+        tausch_writer_init( &wr, out, sizeof(out) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_scope( &wr, 2 );   // count as scope is skipped
+        tausch_writer_end( &wr );
+        tausch_writer_end( &wr );
+        test( tausch_json_sample_decode( &s2, out, tausch_writer_len( &wr ) ), LINE( "" ) );
+        test( s2.has_sample && !s2.sample.has_count, LINE( "" ) );
+        tausch_writer_init( &wr, out, sizeof(out) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_write( &wr, 8, "xy" );   // origin must be scope
+        tausch_writer_end( &wr );
+        test( !tausch_json_sample_decode( &s2, out, tausch_writer_len( &wr ) ), LINE( "" ) );
+
+        printf( "   -- Variadic overflow \n" );
+        s2 = s;
+        s2.sample.path.n = TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX + 1;
+        test( tausch_json_sample_encode( &s2, out, sizeof(out) ) == 0, LINE( "" ) );
+        tausch_writer_init( &wr, out, sizeof(out) );
+        tausch_writer_scope( &wr, 1 );
+        tausch_writer_scope( &wr, 9 );
+        for( int i = 0; i <= TAUSCH_JSON_SAMPLE_SAMPLE_PATH_MAX; i++ )
+        {
+            tausch_writer_write( &wr, 2, "m" );
+        }
+        tausch_writer_end( &wr );
+        tausch_writer_end( &wr );
+        test( tausch_writer_is_ok( &wr ), LINE( "" ) );
+        test( !tausch_json_sample_decode( &s2, out, tausch_writer_len( &wr ) ), LINE( "" ) );
+        s2 = s;
+        s2.sample.path.item[1].tag = 5;
+        test( tausch_json_sample_encode( &s2, out, sizeof(out) ) == 0, LINE( "unknown tag in variadic" ) );
+    }
+
+    {
+        printf( "   -- Device info \n" );
+        tausch_device_info_t d;
+        tausch_device_info_t d2;
+        memset( &d, 0, sizeof(d) );
+        d.has_info = 1;
+        d.info.has_msglen = 1;
+        d.info.msglen = 1000;
+        d.info.has_sized = 1;
+        d.info.sized = true;
+        d.info.has_name = 1;
+        d.info.name.has_data = 1;
+        d.info.name.data = (tausch_view_t){ .buf = (const uint8_t*)"device", .len = 6 };
+        d.info.has_schbin = 1;
+        d.info.schbin.n = 3;
+        for( tsch_size_t i = 0; i < d.info.schbin.n; i++ )
+        {
+            tausch_device_info_schrow_t *row = &d.info.schbin.item[i];
+            row->has_item = 1;
+            row->item = i + 1;
+            row->has_next = 1;
+            row->next = 10 * i;
+            row->has_name = 1;
+            row->name.has_orig = 1;
+            row->name.orig = 100 + i;
+        }
+        tsch_size_t n = tausch_device_info_encode( &d, out, sizeof(out) );
+        test( n > 0, LINE( "" ) );
+        test( tausch_device_info_decode( &d2, out, n ), LINE( "" ) );
+        test( d2.has_info && (d2.info.msglen == 1000) && d2.info.sized, LINE( "" ) );
+        test( d2.info.has_name && (d2.info.name.data.len == 6), LINE( "" ) );
+        test( memcmp( d2.info.name.data.buf, "device", 6 ) == 0, LINE( "" ) );
+        test( !d2.info.has_version && !d2.info.name.has_orig, LINE( "" ) );
+        test( d2.info.has_schbin && (d2.info.schbin.n == 3), LINE( "" ) );
+        for( tsch_size_t i = 0; i < d2.info.schbin.n; i++ )
+        {
+            tausch_device_info_schrow_t *row = &d2.info.schbin.item[i];
+            test( row->has_item && (row->item == i + 1), LINE( "row %d", (int)i ) );
+            test( row->has_next && (row->next == 10 * i), LINE( "row %d", (int)i ) );
+            test( row->has_name && (row->name.orig == 100 + i), LINE( "row %d", (int)i ) );
+            test( !row->has_desc && !row->has_type, LINE( "row %d", (int)i ) );
+        }
+    }
+
+    return true;
+}
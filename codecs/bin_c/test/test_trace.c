@@ -0,0 +1,137 @@
+#include "testmain.h"
+#include "../src/tauschema_trace.h"
+#include "../src/tauschema_check.h"
+#include "tauschema_device_info_schema.h"
+
+#ifdef TAUSCH_TRACE
+
+static tausch_trace_op_t trace_ops[20];   // operations seen by the hook
+static tsch_size_t trace_names[20];
+static size_t trace_n;
+
+static void trace_hook( void *ctx, tausch_trace_op_t op, tsch_size_t name, uint64_t ns )
+{
+    if( trace_n < 20 )
+    {
+        trace_ops[trace_n] = op;
+        trace_names[trace_n] = name;
+    }
+    trace_n += 1;
+}
+
+#endif
+
+bool test_trace( void )
+{
+    static tausch_hist_t h;
+    char text[2000];
+    char errorbuf[500];   // temporary error message
+
+    printf( "\n### Tracing tests \n\n" );
+
+    {
+        printf( "   -- Histogram \n" );
+        tausch_hist_clear( &h );
+        test( tausch_hist_percentile( &h, 50 ) == 0, LINE( "empty" ) );
+        tausch_hist_add( &h, 3 );
+        test( (tausch_hist_percentile( &h, 0 ) == 3) && (tausch_hist_percentile( &h, 100 ) == 3), LINE( "" ) );
+
+        tausch_hist_clear( &h );
+        for( uint64_t v = 1; v <= 1000; v++ ) tausch_hist_add( &h, v );
+        uint64_t p50 = tausch_hist_percentile( &h, 50 );
+        uint64_t p99 = tausch_hist_percentile( &h, 99 );
+        test( (p50 >= 500) && (p50 <= 500 + 500 / 8), LINE( "p50 %d", (int)p50 ) );
+        test( (p99 >= 990) && (p99 <= 1000), LINE( "p99 %d", (int)p99 ) );
+        test( tausch_hist_percentile( &h, 100 ) == 1000, LINE( "" ) );
+        test( tausch_hist_percentile( &h, 0 ) == 1, LINE( "" ) );
+
+        // the buckets are exact below 16 and 1/8 of power of two above
+        uint64_t prev = 0;
+        bool monotonic = true;
+        for( uint64_t v = 1; v < ((uint64_t)1 << 40); v = v * 3 / 2 + 1 )
+        {
+            tausch_hist_clear( &h );
+            tausch_hist_add( &h, v );
+            tausch_hist_add( &h, UINT64_MAX );
+            uint64_t p = tausch_hist_percentile( &h, 50 );
+            monotonic = monotonic && (p >= v) && (p - v <= v / 8) && (p > prev);
+            prev = p;
+        }
+        test( monotonic, LINE( "" ) );
+        test( tausch_hist_percentile( &h, 100 ) == UINT64_MAX, LINE( "" ) );
+
+        printf( "   -- Text of histogram \n" );
+        tausch_hist_clear( &h );
+        tausch_hist_add( &h, 10 );
+        tausch_hist_add( &h, 10 );
+        tausch_hist_add( &h, 100 );
+        size_t n = tausch_hist_dump( &h, "lat", text, sizeof(text) );
+        test( n == strlen( text ), LINE( "" ) );
+        test( strncmp( text, "lat: n 3 mean 40 p50 10 p90 100 p99 100 p99.9 100 max 100\n", 58 ) == 0, LINE( "%.100s", text ) );
+        test( strstr( text, "\n                    10            2  66.667%\n" ) != NULL, LINE( "%.100s", text ) );
+        char small[20];
+        test( tausch_hist_dump( &h, "lat", small, sizeof(small) ) == n, LINE( "" ) );
+        test( strlen( small ) == sizeof(small) - 1, LINE( "" ) );
+    }
+
+#ifdef TAUSCH_TRACE
+    {
+        printf( "   -- Tracing of flaterator \n" );
+        uint8_t msg[60];
+        tausch_schema_t schema;
+        tausch_flater_t fl;
+        bool ok = true;
+        uint32_t msglen = 0;
+
+        tausch_schema_init( &schema, tauschema_device_info_flatrows, tauschema_device_info_flatsize );
+        for( int op = 0; op < TAUSCH_TRACE_N; op++ ) tausch_hist_clear( tausch_trace_hist( op ) );
+        trace_n = 0;
+        tausch_trace_hook( trace_hook, NULL );
+
+        tausch_format_buf( msg );
+        tausch_flater_init( &fl, &schema, msg, sizeof(msg) );
+        ok = ok && TAUSCH_FLATER_WRITE_SCOPE( &fl, TAUSCH_NAM_DEVICE_INFO_info )
+        {
+            uint32_t mslen = 1400;
+            ok = ok && (tausch_flater_write( sfl, TAUSCH_NAM_DEVICE_INFO_msglen, &mslen ) > 0);
+            return ok;
+        }
+        TAUSCH_FLATER_CLOSE_SCOPE;
+        test( ok && (trace_n == 1), LINE( "ops %d", (int)trace_n ) );
+        test( (trace_ops[0] == TAUSCH_TRACE_WRITE_SCOPE) && (trace_names[0] == TAUSCH_NAM_DEVICE_INFO_info),
+            LINE( "" ) );
+
+        tausch_flater_init( &fl, &schema, msg, sizeof(msg) );
+        test( tausch_flater_read( &fl, &msglen, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_msglen ) > 0,
+            LINE( "" ) );
+        test( tausch_flater_read( &fl, &msglen, TAUSCH_NAM_DEVICE_INFO_info, TAUSCH_NAM_DEVICE_INFO_vendor ) == 0,
+            LINE( "" ) );
+        test( (trace_n == 3) && (trace_ops[1] == TAUSCH_TRACE_READ) && (trace_ops[2] == TAUSCH_TRACE_READ),
+            LINE( "ops %d", (int)trace_n ) );
+        test( (trace_names[1] == TAUSCH_NAM_DEVICE_INFO_msglen) && (trace_names[2] == 0), LINE( "" ) );
+
+        printf( "   -- Message is done at EOF \n" );
+        tausch_flater_next( &fl );
+        tausch_flater_t sub = tausch_flater_clone( &fl );
+        while( tausch_iter_is_ok( &tausch_flater_next( &sub )->iter ) && !tausch_iter_is_end( &sub.iter ) )
+            ;
+        test( trace_n == 3, LINE( "clone does not finish the message" ) );
+        test( tausch_iter_erase( &fl.iter ), LINE( "" ) );
+        test( (trace_n == 4) && (trace_ops[3] == TAUSCH_TRACE_ERASE) && (trace_names[3] == 1), LINE( "" ) );
+        tausch_flater_next( &fl );
+        tausch_flater_next( &fl );
+        test( tausch_iter_is_eof( &fl.iter ), LINE( "" ) );
+        test( (trace_n == 5) && (trace_ops[4] == TAUSCH_TRACE_MESSAGE), LINE( "ops %d", (int)trace_n ) );
+
+        tausch_trace_hook( NULL, NULL );
+        test( tausch_trace_hist( TAUSCH_TRACE_READ )->n == 2, LINE( "" ) );
+        test( tausch_trace_hist( TAUSCH_TRACE_MESSAGE )->n == 1, LINE( "" ) );
+        size_t n = tausch_trace_dump( text, sizeof(text) );
+        test( (n == strlen( text )) && (strstr( text, "read: n 2 " ) != NULL), LINE( "%.100s", text ) );
+        test( strstr( text, "write_scope: n 1 " ) != NULL, LINE( "%.100s", text ) );
+    }
+#endif
+
+    printf( " trace done \n\n");
+    return true;
+}
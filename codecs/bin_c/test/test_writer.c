@@ -0,0 +1,253 @@
+#include "testmain.h"
+#include "../src/tauschema_writer.h"
+#include "../src/tauschema_index.h"
+
+/**
+ * Compose the same message with the iterator and the writer, the messages must match.
+ * The buffer is filled up until the writing fails.
+ */
+static void compare_with_iter( tsch_size_t size, tsch_size_t bloblen )
+{
+    uint8_t ibuf[300];   // written by iterator
+    uint8_t wbuf[300];   // written by writer
+    char errorbuf[500];   // temporary error message
+    TAUSCH_BLOB_NEW( blob, 200 );
+    memset( blob.buf, 0xa5, blob.len );
+    blob.len = bloblen;
+
+    tausch_format_buf( ibuf );
+    tausch_iter_t iter = TAUSCH_ITER_INIT( ibuf, size );
+    tausch_writer_t wr;
+    tausch_writer_init( &wr, wbuf, size );
+
+    bool iok = true;
+    bool wok = true;
+    for( uint32_t i = 0; iok && wok; i++ )
+    {
+        uint32_t u32 = 0x12345678 + i;
+        uint16_t u16 = (uint16_t)i;
+        bool t = (i & 1) != 0;
+        tsch_size_t rv = 0;
+        tsch_size_t wv = 0;
+
+        (void)tausch_iter_next( &iter );
+        switch( i % 8 )
+        {
+            case 0:
+                iok = tausch_iter_write_scope( &iter, 200 + i ) && tausch_iter_enter_scope( &iter );
+                wok = tausch_writer_scope( &wr, 200 + i );
+                break;
+            case 1:
+                iok = (rv = tausch_iter_write( &iter, 1, &u32 )) > 0;
+                wok = (wv = tausch_writer_write( &wr, 1, &u32 )) > 0;
+                break;
+            case 2:
+                iok = (rv = tausch_iter_write( &iter, 20000, &u16 )) > 0;
+                wok = (wv = tausch_writer_write( &wr, 20000, &u16 )) > 0;
+                break;
+            case 3:
+                iok = (rv = tausch_iter_write( &iter, 3, &blob )) > 0;
+                wok = (wv = tausch_writer_write( &wr, 3, &blob )) > 0;
+                break;
+            case 4:
+                iok = tausch_iter_write( &iter, 4, &t );
+                wok = tausch_writer_write( &wr, 4, &t );
+                break;
+            case 5:
+                iok = tausch_iter_write( &iter, 5, (bool*)NULL );
+                wok = tausch_writer_write( &wr, 5, (bool*)NULL );
+                break;
+            case 6:
+                iok = (rv = tausch_iter_write( &iter, 6, "text" )) > 0;
+                wok = (wv = tausch_writer_write( &wr, 6, "text" )) > 0;
+                break;
+            default:
+                iok = tausch_iter_write_end( &iter ) && tausch_iter_exit_scope( &iter );
+                wok = tausch_writer_end( &wr );
+                break;
+        }
+        test( (iok == wok) && (rv == wv), LINE( "writing %d with size %d, iterator %d and writer %d", i, size, iok, wok ) );
+    }
+
+    tausch_iter_t wit;
+    tausch_writer_iter( &wr, &wit );
+    test( tausch_iter_buff_free( &wit ) == tausch_writer_buff_free( &wr ), LINE( "size %d", size ) );
+    test( tausch_iter_buff_free( &iter ) == tausch_writer_buff_free( &wr ), LINE( "size %d", size ) );
+    tsch_size_t len = tausch_writer_len( &wr );
+    test( bincompare( ibuf, wbuf, len ), LINE( "size %d, blob %d", size, bloblen ) );
+}
+
+bool test_writer( void )
+{
+    uint8_t buf[50];   // the message
+    char errorbuf[500];   // temporary error message
+
+    printf( "\n### Append only writer tests \n\n" );
+
+    {
+        printf( "   -- Writing the message \n" );
+        tausch_writer_t wr;
+        uint32_t u32 = 0x12345678;
+        test( tausch_writer_init( &wr, buf, sizeof(buf) ) == &wr, LINE( "" ) );
+        test( tausch_writer_len( &wr ) == 1, LINE( "" ) );
+        HEXCOMP( buf, "07", LINE( "" ) );
+        test( !tausch_writer_end( &wr ), LINE( "there is no scope to close" ) );
+        test( tausch_writer_scope( &wr, 1 ), LINE( "" ) );
+        test( tausch_writer_write( &wr, 2, &u32 ) == 4, LINE( "" ) );
+        test( tausch_writer_write( &wr, 3, (bool*)NULL ), LINE( "" ) );
+        test( tausch_writer_end( &wr ), LINE( "" ) );
+        test( wr.scope == 0, LINE( "" ) );
+        test( tausch_writer_len( &wr ) == 10, LINE( "" ) );
+        HEXCOMP( buf, "05 0a 04 78 56 34 12 0c 03 07", LINE( "" ) );
+        test( tausch_writer_buff_free( &wr ) == sizeof(buf) - 10, LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Writing does not fit \n" );
+        tausch_writer_t wr;
+        uint32_t u32 = 0x12345678;
+        tausch_writer_init( &wr, buf, 6 );
+        test( !tausch_writer_write( &wr, 2, &u32 ), LINE( "no space for EOF" ) );
+        test( tausch_writer_len( &wr ) == 1, LINE( "the writer must stay untouched" ) );
+        HEXCOMP( buf, "07", LINE( "" ) );
+        TAUSCH_BLOB_NEW( blob, 10 );
+        memset( blob.buf, 0x11, blob.len );
+        test( tausch_writer_write( &wr, 2, &blob ) == 3, LINE( "blob is cut to fit" ) );
+        HEXCOMP( buf, "0a 03 11 11 11 07", LINE( "" ) );
+        test( !tausch_writer_scope( &wr, 1 ), LINE( "" ) );
+        test( tausch_writer_is_ok( &wr ), LINE( "" ) );
+        tausch_writer_init( &wr, buf, 0 );
+        test( !tausch_writer_is_ok( &wr ), LINE( "" ) );
+        test( !tausch_writer_scope( &wr, 1 ), LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Writing and skipping of sized scopes \n" );
+        uint8_t sbuf[300];   // the length field takes 2 bytes
+        tausch_writer_t wr;
+        uint32_t u32 = 0x12345678;
+        tausch_writer_init( &wr, sbuf, sizeof(sbuf) );
+        test( !tausch_writer_sized_scope( &wr, 1 ), LINE( "tag 1 is EOF" ) );
+        test( tausch_writer_sized_scope( &wr, 5 ), LINE( "" ) );
+        test( tausch_writer_write( &wr, 1, &u32 ), LINE( "" ) );
+        test( tausch_writer_sized_scope( &wr, 6 ), LINE( "" ) );
+        test( tausch_writer_write( &wr, 3, "ab" ), LINE( "" ) );
+        test( tausch_writer_end( &wr ), LINE( "" ) );
+        test( tausch_writer_end( &wr ), LINE( "" ) );
+        test( tausch_writer_write( &wr, 4, (bool*)NULL ), LINE( "" ) );
+        test( (wr.scope == 0) && (wr.nsized == 0), LINE( "" ) );
+        HEXCOMP( sbuf, "17 8f 00 06 04 78 56 34 12 1b 85 00 0e 02 61 62 03 03 10 07", LINE( "" ) );
+
+        tausch_iter_t iter;
+        tausch_writer_iter( &wr, &iter );
+        test( tausch_iter_next( &iter ), LINE( "" ) );
+        test( tausch_iter_is_scope( &iter ) && tausch_iter_is_sized( &iter ), LINE( "" ) );
+        test( (iter.tag == 5) && (iter.vlen == 15) && (iter.next == 3), LINE( "" ) );
+        tausch_iter_t sub = iter;
+        test( tausch_iter_next( &iter ), LINE( "jump over the scope" ) );
+        test( (iter.tag == 4) && (iter.idx == 18) && (iter.scope == 0), LINE( "" ) );
+        test( !tausch_iter_next( &iter ) && tausch_iter_is_eof( &iter ), LINE( "" ) );
+
+        test( tausch_iter_enter_scope( &sub ), LINE( "" ) );
+        test( tausch_iter_next( &sub ) && (sub.tag == 1), LINE( "" ) );
+        test( tausch_iter_next( &sub ) && tausch_iter_is_sized( &sub ) && (sub.vlen == 5), LINE( "" ) );
+        test( !tausch_iter_next( &sub ) && tausch_iter_is_end( &sub ) && (sub.idx == 17), LINE( "" ) );
+        test( tausch_iter_exit_scope( &sub ) && (sub.scope == 0), LINE( "" ) );
+        test( tausch_iter_next( &sub ) && (sub.tag == 4), LINE( "" ) );
+
+        TAUSCH_INDEX_NEW( index, 20 );
+        test( tausch_index_build( &index, sbuf, sizeof(sbuf) ), LINE( "" ) );
+        test( tausch_index_go_to_tag( &index, 0, 4 ) == 6, LINE( "" ) );
+        tausch_iter_t ix;
+        tausch_index_iter( &index, 0, &ix );
+        test( tausch_iter_is_sized( &ix ) && (ix.vlen == 15) && (ix.next == 3), LINE( "" ) );
+        test( tausch_index_build( &index, sbuf, 17 ) == false, LINE( "the scope goes over the buffer" ) );
+        sbuf[10] = 0x84;
+        test( tausch_index_build( &index, sbuf, sizeof(sbuf) ) == false, LINE( "the length is wrong" ) );
+        sbuf[10] = 0x85;
+
+        printf( "   -- Compaction of sized scopes \n" );
+        tausch_writer_iter( &wr, &iter );
+        test( tausch_iter_next( &iter ) && tausch_iter_enter_scope( &iter ), LINE( "" ) );
+        test( tausch_iter_next( &iter ) && tausch_iter_erase( &iter ), LINE( "" ) );
+        test( tausch_iter_next( &iter ) && tausch_iter_enter_scope( &iter ), LINE( "" ) );
+        test( tausch_iter_next( &iter ) && tausch_iter_erase( &iter ), LINE( "" ) );
+        test( tausch_iter_compact( &iter ) == 10, LINE( "" ) );
+        HEXCOMP( sbuf, "17 85 00 1b 81 00 03 03 10 07", LINE( "" ) );
+        test( tausch_index_build( &index, sbuf, sizeof(sbuf) ), LINE( "the lengths must match" ) );
+
+        tausch_writer_iter( &wr, &iter );
+        test( tausch_iter_next( &iter ) && tausch_iter_erase( &iter ), LINE( "" ) );
+        test( tausch_iter_is_stuffing( &iter ) == 8, LINE( "" ) );
+        test( tausch_iter_next( &iter ) && (iter.tag == 4), LINE( "" ) );
+
+        tausch_writer_init( &wr, sbuf, 4 );
+        test( tausch_writer_sized_scope( &wr, 5 ), LINE( "" ) );
+        test( tausch_writer_end( &wr ), LINE( "" ) );
+        HEXCOMP( sbuf, "17 01 03 07", LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Referencing payloads from caller memory \n" );
+        uint8_t rbuf[40];
+        uint8_t flat[200];
+        uint8_t payload[100];
+        tausch_writer_ref_t refs[2];
+        tausch_iovec_t iov[5];
+        tausch_writer_t wr;
+        tausch_iter_t iter;
+        tausch_view_t view;
+        uint32_t u32 = 0x11223344;
+        uint8_t u8 = 0x55;
+        for( int i = 0; i < sizeof(payload); i++ ) payload[i] = (uint8_t)i;
+        tausch_blob_t big = { .buf = payload, .len = 100 };
+        tausch_blob_t small = { .buf = payload, .len = 50 };
+
+        tausch_writer_init( &wr, rbuf, sizeof(rbuf) );
+        test( tausch_writer_blob_ref( &wr, 2, &big ) == 0, LINE( "no table attached" ) );
+        tausch_writer_refs( &wr, refs, 2 );
+        test( tausch_writer_sized_scope( &wr, 5 ), LINE( "" ) );
+        test( tausch_writer_write( &wr, 1, &u32 ), LINE( "" ) );
+        test( tausch_writer_blob_ref( &wr, 2, &big ) == 100, LINE( "" ) );
+        test( tausch_writer_end( &wr ), LINE( "" ) );
+        test( tausch_writer_blob_ref( &wr, 3, &small ) == 50, LINE( "" ) );
+        test( tausch_writer_blob_ref( &wr, 3, &small ) == 0, LINE( "the table is full" ) );
+        test( tausch_writer_write( &wr, 4, &u8 ), LINE( "" ) );
+        test( tausch_writer_len( &wr ) == 167, LINE( "len %d", tausch_writer_len( &wr ) ) );
+        test( tausch_writer_buff_free( &wr ) == 23, LINE( "the payloads do not take the buffer" ) );
+        test( tausch_iter_is_ok( tausch_writer_iter( &wr, &iter ) ) == false, LINE( "" ) );
+
+        test( tausch_writer_iovecs( &wr, iov, 4 ) == 0, LINE( "not enough vectors" ) );
+        test( tausch_writer_iovecs( &wr, iov, 5 ) == 5, LINE( "" ) );
+        test( (iov[1].iov_base == payload) && (iov[1].iov_len == 100) && (iov[3].iov_len == 50), LINE( "" ) );
+        size_t len = 0;
+        for( int i = 0; i < 5; i++ )
+        {
+            memcpy( &flat[len], iov[i].iov_base, iov[i].iov_len );
+            len += iov[i].iov_len;
+        }
+        test( len == 167, LINE( "" ) );
+        HEXCOMP( flat, "17 6d 06 04 44 33 22 11 0a 64 00 01", LINE( "" ) );
+        test( flat[len - 1] == 0x07, LINE( "" ) );
+
+        TAUSCH_INDEX_NEW( index, 8 );
+        test( tausch_index_build( &index, flat, len ), LINE( "the length of the sized scope" ) );
+        tausch_iter_init( &iter, flat, len );
+        test( tausch_iter_next( &iter ) && tausch_iter_is_sized( &iter ) && (iter.vlen == 109), LINE( "" ) );
+        test( tausch_iter_next( &iter ) && tausch_iter_view( &iter, &view ) && (iter.tag == 3), LINE( "" ) );
+        test( (view.len == 50) && (memcmp( view.buf, payload, 50 ) == 0), LINE( "" ) );
+        test( tausch_iter_next( &iter ) && (iter.tag == 4), LINE( "" ) );
+    }
+
+    {
+        printf( "   -- Comparing against the iterator \n" );
+        for( tsch_size_t size = 1; size < 300; size += 7 )
+        {
+            compare_with_iter( size, 1 );
+            compare_with_iter( size, 130 );
+        }
+    }
+
+    printf( " writer done \n\n" );
+    return true;
+}
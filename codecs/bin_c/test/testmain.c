@@ -9,6 +9,15 @@ int main( void )
 {
     test_buf();
     test_flater();
+    test_index();
+    test_writer();
+    test_stream();
+    test_file();
+    test_batch();
+    test_json();
+    test_stats();
+    test_trace();
+    test_structs();
 
     printf("\n\n");
     printf("Number of tests performed: %ld \n", count_tests );
@@ -27,5 +27,14 @@ bool hexcompare( uint8_t *b1, char *b2 );
 
 bool test_buf( void );
 bool test_flater( void );
+bool test_index( void );
+bool test_writer( void );
+bool test_stream( void );
+bool test_file( void );
+bool test_batch( void );
+bool test_json( void );
+bool test_stats( void );
+bool test_trace( void );
+bool test_structs( void );
 
 void printhex( char *prep, uint8_t *start, uint8_t *end );
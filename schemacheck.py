@@ -36,6 +36,8 @@ import argparse
 import sys
 from builtins import isinstance
 import os
+import random
+import struct
 
 
 class SchemaItem:
@@ -825,6 +827,107 @@ class SchemaFactory:
         full_tlv += self.vluint_encode((1<<2)+3)
         
         return self.root._flattlv
+
+    def tlv_encode(self, tag : int, lc : int, value : bytes = None ) -> bytes:
+        """
+        Encode single TLV element, lc is 0 for bool, 1 for scope open and 2 for value.
+        """
+        rv = bytes( self.vluint_encode( (tag<<2) + lc ) )
+        if value != None :
+            rv += bytes( self.vluint_encode( len(value) ) ) + value
+        return rv
+    
+    def produce_corpus(self, count : int = 1, depth : int = 4, fanout : int = 8, 
+                       blob : tuple = (0,32), stuffing : float = 0.0, fill : float = 0.8, 
+                       seed = None ) -> bytes:
+        """
+        Produce synthetic messages that are valid against the schema. The messages are
+        placed back to back, each one is terminated with T7.
+        
+        :param count - number of messages
+        :param depth - maximal nesting of collections and variadics, deeper ones are left empty
+        :param fanout - maximal number of elements in variadic, the number is random from 0 to fanout
+        :param blob - (min,max) length of blob and utf8 values
+        :param stuffing - probability of placing stuffing before each TLV
+        :param fill - probability of each collection member to be present
+        :param seed - seed of the random generator for reproducible corpus
+        
+        :return the corpus
+        """
+        rnd = random.Random( seed )
+        tree = self.generate_flat_tree()
+        
+        def subrows( row : dict ) -> list:
+            rv = list()
+            i = row['sub']
+            while i > 0 :
+                rv.append( tree[i] )
+                i = tree[i]['next']
+            return rv
+        
+        def stuff() -> bytes:
+            if rnd.random() >= stuffing :
+                return b''
+            n = rnd.randint( 1, 8 )
+            if n == 1 :
+                return bytes([0])
+            return self.tlv_encode( 0, 2, bytes(n) )
+        
+        def number( typ : str ) -> bytes:
+            bits = typ.split('-')
+            if len(bits) > 1 :
+                size = int(bits[1]) // 8
+            elif bits[0] == 'FLOAT' :
+                size = rnd.choice( [4,8] )
+            else :
+                size = rnd.choice( [1,2,4,8] )
+            if bits[0] == 'FLOAT' :
+                fmt = '<f' if size == 4 else '<d'
+                return struct.pack( fmt, rnd.uniform( -1e6, 1e6 ) )
+            if bits[0] == 'SINT' :
+                return rnd.randint( -(1<<(size*8-1)), (1<<(size*8-1))-1 ).to_bytes( size, 'little', signed=True )
+            return rnd.getrandbits( size*8 ).to_bytes( size, 'little' )
+        
+        def element( row : dict, level : int ) -> bytes:
+            typ = row['type']
+            tag = row['item']
+            rv = stuff()
+            if typ == 'BOOL' :
+                return rv + self.tlv_encode( tag, 0 ) if rnd.random() < 0.5 else rv + self.tlv_encode( tag, 2, b'' )
+            if typ == 'UTF8' :
+                n = rnd.randint( blob[0], blob[1] )
+                return rv + self.tlv_encode( tag, 2, bytes( rnd.choice( range(0x20,0x7f) ) for _ in range(n) ) )
+            if typ == 'BLOB' :
+                return rv + self.tlv_encode( tag, 2, rnd.randbytes( rnd.randint( blob[0], blob[1] ) ) )
+            if typ in ['COLLECTION','VARIADIC'] :
+                rv += self.tlv_encode( tag, 1 )
+                if level < depth :
+                    rv += scope( row, level + 1 )
+                return rv + stuff() + bytes([3])
+            return rv + self.tlv_encode( tag, 2, number( typ ) )
+        
+        def scope( row : dict, level : int ) -> bytes:
+            subs = subrows( row )
+            rv = b''
+            if len(subs) == 0 :
+                return rv
+            if row['type'] == 'VARIADIC' :
+                for _ in range( rnd.randint( 0, fanout ) ) :
+                    rv += element( rnd.choice( subs ), level )
+                return rv
+            rnd.shuffle( subs )
+            for r in subs :
+                if rnd.random() < fill :
+                    rv += element( r, level )
+            return rv
+        
+        corpus = bytearray()
+        roots = subrows( tree[0] )
+        for _ in range( count ) :
+            if len(roots) > 0 :
+                corpus += element( rnd.choice( roots ), 1 )
+            corpus += stuff() + bytes([7])
+        return bytes( corpus )
         
     def produce_c_flattree(self, options ):
         """
@@ -898,19 +1001,398 @@ class SchemaFactory:
         rv += "\n#endif // _"+factory._schema_name.upper()+"_H_\n"
         return rv
     
+    c_types = {
+        'BOOL'      : 'bool',
+        'UINT'      : 'uint64_t',   'UINT-8'    : 'uint8_t',    'UINT-16'   : 'uint16_t',
+        'UINT-32'   : 'uint32_t',   'UINT-64'   : 'uint64_t',
+        'SINT'      : 'int64_t',    'SINT-8'    : 'int8_t',     'SINT-16'   : 'int16_t',
+        'SINT-32'   : 'int32_t',    'SINT-64'   : 'int64_t',
+        'FLOAT'     : 'double',     'FLOAT-32'  : 'float',      'FLOAT-64'  : 'double',
+        'UTF8'      : 'tausch_view_t',  'BLOB'  : 'tausch_view_t'
+    }
+    """
+    The C types of the primitives in the generated structs. The types without width
+    are read from any width and written with the full width.
+    """
+    
+    def compile_structs(self) -> list:
+        """
+        Collect the structs of the schema for the C struct codecs. The items with the same
+        type share the struct, the struct is named by the scope path of the type definition.
+        The structs are listed in order where the members are declared before use, the
+        root struct is the last.
+        
+        :return list of dict with keys 'name', 'type', 'item' and 'members'
+        """
+        if getattr(self,'_structs',None) != None :
+            return self._structs
+        structs = list()
+        known = dict()
+        
+        def definition( itm : SchemaItem ) -> SchemaItem:
+            while len( itm.type_scope ) > 0 :
+                itm = itm.type_scope[-1]
+            return itm
+        
+        def visit( itm : SchemaItem ) -> dict:
+            d = definition( itm )
+            if id(d) in known :
+                return known[id(d)]
+            path = [ s.name for s in d.name_scope ] + [ d.name ]
+            st = { 
+                'name': "_".join( path ),   # the struct name, empty for the root
+                'type': d.type,             # COLLECTION, VARIADIC or '' for the root
+                'item': d,                  # the type definition
+                'members': list()           # the existing subitems
+            }
+            known[id(d)] = st
+            for k,v in itm.subitems.items() :
+                _ = k
+                if v.item < 1 :
+                    continue
+                if v.type in ['COLLECTION','VARIADIC'] :
+                    v._struct = visit( v )
+                st['members'].append( v )
+            structs.append( st )
+            return st
+        
+        visit( self.root )
+        self._structs = structs
+        return structs
+    
+    def struct_name(self, st : dict, what : str = "" ) -> str:
+        """
+        The C identifier of the struct type or of its codec function
+        """
+        rv = "tausch_" + factory._schema_name
+        if what != "" :
+            rv += "_" + what
+        if st['name'] != "" :
+            rv += "_" + st['name']
+        return rv
+    
+    def struct_max(self, st : dict ) -> str:
+        """
+        The name of the macro that limits number of elements in the variadic
+        """
+        return "TAUSCH_" + factory._schema_name.upper() + "_" + st['name'].upper() + "_MAX"
+    
+    def struct_member_type(self, v : SchemaItem ) -> str:
+        if v.type in ['COLLECTION','VARIADIC'] :
+            return self.struct_name( v._struct ) + "_t"
+        return self.c_types[ v.type ]
+    
+    def struct_desc(self, v : SchemaItem ) -> str:
+        """
+        First line of the description for the comment
+        """
+        for ln in v.desc.split("\n") :
+            ln = ln.strip().replace("*/","* /")
+            if len( ln ) > 0 :
+                return ", " + ln
+        return ""
+    
+    def struct_read(self, v : SchemaItem, lval : str ) -> str:
+        """
+        C expression that reads the item at iterator into the lval, it is true on success
+        """
+        if v.type in ['COLLECTION','VARIADIC'] :
+            return self.struct_name( v._struct, "decode" ) + "( ci, &" + lval + " )"
+        if v.type == 'BOOL' :
+            return "tausch_iter_read_bool( it, &" + lval + " )"
+        if v.type in ['UTF8','BLOB'] :
+            return "tausch_iter_view( it, &" + lval + " )"
+        if v.type in ['UINT','SINT','FLOAT'] :
+            return "tausch_" + factory._schema_name + "_read_" + v.type.lower() + "( it, &" + lval + " )"
+        return "tausch_iter_read( it, &" + lval + " ) > 0"
+    
+    def struct_write(self, v : SchemaItem, lval : str ) -> str:
+        """
+        C expression that writes the lval as the item, it is true on success
+        """
+        tag = str( v.item )
+        if v.type in ['COLLECTION','VARIADIC'] :
+            return self.struct_name( v._struct, "encode" ) + "( wr, " + tag + ", &" + lval + " )"
+        if v.type == 'BOOL' :
+            return "tausch_writer_bool( wr, " + tag + ", (bool*)&" + lval + " )"
+        if v.type in ['UTF8','BLOB'] :
+            return "tausch_writer_typX( wr, " + tag + ", (uint8_t*)" + lval + ".buf, " + lval + ".len )"
+        return "tausch_writer_typX( wr, " + tag + ", (uint8_t*)&" + lval + ", sizeof( " + lval + " ) )"
+    
+    def produce_h_structs(self) -> str:
+        """
+        produce the .h file of the C struct codecs
+        """
+        structs = self.compile_structs()
+        sch = factory._schema_name
+        guard = "_TAUSCHEMA_" + sch.upper() + "_STRUCTS_H_"
+        
+        rv = "\n/* produced with command:\n $ "+ " ".join(sys.argv) + "\n*/\n\n"
+        rv += "#ifndef " + guard + "\n"
+        rv += "#define " + guard + "\n\n"
+        rv += "#include \"tauschema_codec.h\"\n"
+        rv += "#include \"tauschema_writer.h\"\n\n"
+        rv += "/// Default number of elements in the arrays of variadics\n"
+        rv += "#ifndef TAUSCH_" + sch.upper() + "_VARIADIC_MAX\n"
+        rv += "#define TAUSCH_" + sch.upper() + "_VARIADIC_MAX 8\n"
+        rv += "#endif\n"
+        for st in structs :
+            if st['type'] != 'VARIADIC' :
+                continue
+            rv += "#ifndef " + self.struct_max( st ) + "\n"
+            rv += "#define " + self.struct_max( st ) + " TAUSCH_" + sch.upper() + "_VARIADIC_MAX\n"
+            rv += "#endif\n"
+        rv += "\n"
+        
+        for st in structs :
+            members = st['members']
+            desc = self.struct_desc( st['item'] ) or "."
+            if st['type'] == 'VARIADIC' :
+                elem = self.struct_member_type( members[0] ) if len( members ) == 1 else self.struct_name( st ) + "_item_t"
+                if len( members ) != 1 :
+                    rv += "/**\n * Element of the variadic " + st['name'] + ", the tag selects the member of union.\n */\n"
+                    rv += "typedef struct\n{\n"
+                    rv += "    /// tag of the element\n"
+                    rv += "    tsch_size_t tag;\n"
+                    rv += "    union\n    {\n"
+                    for v in members :
+                        rv += "        /// tag " + str( v.item ) + self.struct_desc( v ) + "\n"
+                        rv += "        " + self.struct_member_type( v ) + " " + v.name + ";\n"
+                    if len( members ) == 0 :
+                        rv += "        /// the variadic has no items\n"
+                        rv += "        uint8_t _none;\n"
+                    rv += "    };\n"
+                    rv += "} " + elem + ";\n\n"
+                rv += "/**\n * Variadic " + st['name'] + desc + "\n */\n"
+                rv += "typedef struct\n{\n"
+                rv += "    /// number of elements in the array\n"
+                rv += "    tsch_size_t n;\n"
+                rv += "    /// the elements\n"
+                rv += "    " + elem + " item[" + self.struct_max( st ) + "];\n"
+                rv += "} " + self.struct_name( st ) + "_t;\n\n"
+                continue
+            if st['name'] == "" :
+                rv += "/**\n * Message of the schema " + sch + ".\n */\n"
+            else :
+                rv += "/**\n * Collection " + st['name'] + desc + "\n */\n"
+            rv += "typedef struct\n{\n"
+            for v in members :
+                rv += "    /// the " + v.name + " is present\n"
+                rv += "    unsigned has_" + v.name + " : 1;\n"
+            for v in members :
+                rv += "    /// tag " + str( v.item ) + self.struct_desc( v ) + "\n"
+                rv += "    " + self.struct_member_type( v ) + " " + v.name + ";\n"
+            if len( members ) == 0 :
+                rv += "    /// the collection has no items\n"
+                rv += "    unsigned _none : 1;\n"
+            rv += "} " + self.struct_name( st ) + "_t;\n\n"
+        
+        for st in structs :
+            typ = self.struct_name( st ) + "_t"
+            if st['name'] == "" :
+                rv += "/**\n * Decode the message into the struct. The items unknown to schema and the stuffing\n"
+                rv += " * are skipped, the UTF8 and BLOB values are views into the buffer.\n"
+                rv += " *\n"
+                rv += " * @param msg : " + typ + "* - the struct to fill in\n"
+                rv += " * @param buf : const uint8_t* - the message\n"
+                rv += " * @param len : tsch_size_t - length of the message buffer\n"
+                rv += " * @return bool - false when the message is broken or does not fit into the struct\n"
+                rv += " */\n"
+                rv += "bool " + self.struct_name( st, "decode" ) + "( " + typ + " *msg, const uint8_t *buf, tsch_size_t len );\n\n"
+                rv += "/**\n * Encode the present items of the struct into the message.\n"
+                rv += " *\n"
+                rv += " * @param msg : const " + typ + "* - the struct\n"
+                rv += " * @param buf : uint8_t* - the message buffer\n"
+                rv += " * @param size : tsch_size_t - size of the message buffer\n"
+                rv += " * @return tsch_size_t - length of the message including EOF, 0 on failure\n"
+                rv += " */\n"
+                rv += "tsch_size_t " + self.struct_name( st, "encode" ) + "( const " + typ + " *msg, uint8_t *buf, tsch_size_t size );\n\n"
+                continue
+            rv += "/**\n * Decode the " + st['name'] + " from the scope at the iterator. On success the iterator\n"
+            rv += " * is left after the END of scope, continue with tausch_citer_next().\n"
+            rv += " *\n"
+            rv += " * @param ci : tausch_citer_t* - the iterator at the scope\n"
+            rv += " * @param msg : " + typ + "* - the struct to fill in\n"
+            rv += " * @return bool - false on failure\n"
+            rv += " */\n"
+            rv += "bool " + self.struct_name( st, "decode" ) + "( tausch_citer_t *ci, " + typ + " *msg );\n\n"
+            rv += "/**\n * Encode the " + st['name'] + " as the scope.\n"
+            rv += " *\n"
+            rv += " * @param wr : tausch_writer_t* - the writer\n"
+            rv += " * @param tag : tsch_size_t - the tag of scope\n"
+            rv += " * @param msg : const " + typ + "* - the struct\n"
+            rv += " * @return bool - false on failure\n"
+            rv += " */\n"
+            rv += "bool " + self.struct_name( st, "encode" ) + "( tausch_writer_t *wr, tsch_size_t tag, const " + typ + " *msg );\n\n"
+        
+        rv += "#endif // " + guard + "\n"
+        return rv
+    
+    def produce_c_structs(self) -> str:
+        """
+        produce the .c file of the C struct codecs
+        """
+        structs = self.compile_structs()
+        sch = factory._schema_name
+        
+        used = set()
+        for st in structs :
+            for v in st['members'] :
+                used.add( v.type )
+        
+        rv = "\n/* produced with command:\n $ "+ " ".join(sys.argv) + "\n*/\n\n"
+        rv += "#include \"tauschema_" + sch + "_structs.h\"\n"
+        rv += "#include <string.h>\n\n"
+        
+        if 'UINT' in used or 'SINT' in used :
+            rv += "/**\n * Read the integer of any width up to 8 bytes.\n */\n"
+            rv += "static bool tausch_" + sch + "_read_uint( const tausch_iter_t *it, uint64_t *value )\n{\n"
+            rv += "    tausch_view_t v;\n"
+            rv += "    uint64_t u = 0;\n"
+            rv += "    if( !tausch_iter_view( it, &v ) || (v.len == 0) || (v.len > 8) ) return false;\n"
+            rv += "    for( tsch_size_t i = v.len; i > 0; i-- )\n    {\n"
+            rv += "        u = (u << 8) | v.buf[i - 1];   // little endian\n"
+            rv += "    }\n"
+            rv += "    *value = u;\n"
+            rv += "    return true;\n}\n\n"
+        if 'SINT' in used :
+            rv += "/**\n * Read the signed integer of any width up to 8 bytes.\n */\n"
+            rv += "static bool tausch_" + sch + "_read_sint( const tausch_iter_t *it, int64_t *value )\n{\n"
+            rv += "    uint64_t u;\n"
+            rv += "    unsigned bits = 8 * tausch_iter_vlen( it );\n"
+            rv += "    if( !tausch_" + sch + "_read_uint( it, &u ) ) return false;\n"
+            rv += "    if( (bits < 64) && (u >> (bits - 1)) ) u |= ~(uint64_t)0 << bits;   // sign extension\n"
+            rv += "    *value = (int64_t)u;\n"
+            rv += "    return true;\n}\n\n"
+        if 'FLOAT' in used :
+            rv += "/**\n * Read the float or double.\n */\n"
+            rv += "static bool tausch_" + sch + "_read_float( const tausch_iter_t *it, double *value )\n{\n"
+            rv += "    float f;\n"
+            rv += "    if( tausch_iter_read( it, &f ) > 0 )\n    {\n"
+            rv += "        *value = f;\n"
+            rv += "        return true;\n"
+            rv += "    }\n"
+            rv += "    return tausch_iter_read( it, value ) > 0;\n}\n\n"
+        
+        def collection_cases( members : list ) -> str:
+            rv = "        switch( it->tag )\n        {\n"
+            for v in members :
+                rv += "        case " + str( v.item ) + ":\n"
+                if v.type in ['COLLECTION','VARIADIC'] :
+                    rv += "            if( !" + self.struct_read( v, "msg->" + v.name ) + " ) return false;\n"
+                    rv += "            msg->has_" + v.name + " = 1;\n"
+                else :
+                    rv += "            msg->has_" + v.name + " = " + self.struct_read( v, "msg->" + v.name ) + ";\n"
+                rv += "            break;\n"
+            rv += "        default:\n"
+            rv += "            break;   // stuffing and the items unknown to schema\n"
+            rv += "        }\n"
+            return rv
+        
+        def collection_writes( members : list, fail : str ) -> str:
+            rv = ""
+            for v in members :
+                rv += "    if( msg->has_" + v.name + " && !" + self.struct_write( v, "msg->" + v.name ) + " ) return " + fail + ";\n"
+            return rv
+        
+        for st in structs :
+            typ = self.struct_name( st ) + "_t"
+            members = st['members']
+            dec = self.struct_name( st, "decode" )
+            enc = self.struct_name( st, "encode" )
+            if st['name'] == "" :
+                rv += "bool " + dec + "( " + typ + " *msg, const uint8_t *buf, tsch_size_t len )\n{\n"
+                rv += "    tausch_citer_t root;\n"
+                rv += "    tausch_citer_t *ci = tausch_citer_init( &root, buf, len );\n"
+                rv += "    const tausch_iter_t *it = tausch_citer_get( ci );\n"
+                rv += "    memset( msg, 0, sizeof( *msg ) );\n"
+                rv += "    while( tausch_citer_next( ci ) )\n    {\n"
+                rv += collection_cases( members )
+                rv += "    }\n"
+                rv += "    return tausch_iter_is_ok( it ) && tausch_iter_is_eof( it );\n}\n\n"
+                rv += "tsch_size_t " + enc + "( const " + typ + " *msg, uint8_t *buf, tsch_size_t size )\n{\n"
+                rv += "    tausch_writer_t root;\n"
+                rv += "    tausch_writer_t *wr = tausch_writer_init( &root, buf, size );\n"
+                rv += collection_writes( members, "0" )
+                rv += "    return tausch_writer_is_ok( wr ) ? tausch_writer_len( wr ) : 0;\n}\n\n"
+                continue
+            rv += "bool " + dec + "( tausch_citer_t *ci, " + typ + " *msg )\n{\n"
+            rv += "    const tausch_iter_t *it = tausch_citer_get( ci );\n"
+            if st['type'] == 'VARIADIC' :
+                single = len( members ) == 1
+                rv += "    msg->n = 0;\n"
+                rv += "    if( !tausch_citer_enter_scope( ci ) ) return false;\n"
+                rv += "    while( tausch_citer_next( ci ) )\n    {\n"
+                rv += "        switch( it->tag )\n        {\n"
+                for v in members :
+                    rv += "        case " + str( v.item ) + ":\n"
+                    rv += "            if( msg->n >= " + self.struct_max( st ) + " ) return false;   // the array is full\n"
+                    if single :
+                        rv += "            if( !" + self.struct_read( v, "msg->item[msg->n]" ) + " ) return false;\n"
+                    else :
+                        rv += "            msg->item[msg->n].tag = " + str( v.item ) + ";\n"
+                        rv += "            if( !" + self.struct_read( v, "msg->item[msg->n]." + v.name ) + " ) return false;\n"
+                    rv += "            msg->n += 1;\n"
+                    rv += "            break;\n"
+                rv += "        default:\n"
+                rv += "            break;   // stuffing and the items unknown to schema\n"
+                rv += "        }\n"
+                rv += "    }\n"
+            else :
+                rv += "    memset( msg, 0, sizeof( *msg ) );\n"
+                rv += "    if( !tausch_citer_enter_scope( ci ) ) return false;\n"
+                rv += "    while( tausch_citer_next( ci ) )\n    {\n"
+                rv += collection_cases( members )
+                rv += "    }\n"
+            rv += "    // the scope must end with END, not with EOF\n"
+            rv += "    return tausch_iter_is_ok( it ) && !tausch_iter_is_eof( it ) && tausch_citer_exit_scope( ci );\n}\n\n"
+            
+            rv += "bool " + enc + "( tausch_writer_t *wr, tsch_size_t tag, const " + typ + " *msg )\n{\n"
+            rv += "    if( !tausch_writer_scope( wr, tag ) ) return false;\n"
+            if st['type'] == 'VARIADIC' :
+                rv += "    if( msg->n > " + self.struct_max( st ) + " ) return false;\n"
+                rv += "    for( tsch_size_t i = 0; i < msg->n; i++ )\n    {\n"
+                if len( members ) == 1 :
+                    rv += "        if( !" + self.struct_write( members[0], "msg->item[i]" ) + " ) return false;\n"
+                else :
+                    rv += "        switch( msg->item[i].tag )\n        {\n"
+                    for v in members :
+                        rv += "        case " + str( v.item ) + ":\n"
+                        rv += "            if( !" + self.struct_write( v, "msg->item[i]." + v.name ) + " ) return false;\n"
+                        rv += "            break;\n"
+                    rv += "        default:\n"
+                    rv += "            return false;   // the tag is not in schema\n"
+                    rv += "        }\n"
+                rv += "    }\n"
+            else :
+                rv += collection_writes( members, "false" )
+            rv += "    return tausch_writer_end( wr );\n}\n\n"
+        return rv
+    
     pass
 
     
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='Validate and process Tauria\'s schema files.')
     parser.add_argument('--php', action="store_true", help="Wether to print out PHP flat tree.")
-    parser.add_argument('--C', choices=['full','no-desc','no-name','off'], default='off', 
+    parser.add_argument('--C', choices=['full','no-desc','no-name','structs','off'], default='off', 
                         help="Wether to print out C flat tree."
                         + " Option 'full' does produce full flat tree data."
                         + " Option 'no-desc' discards description strings."
                         + " Option 'no-name' discarrds also names."
+                        + " Option 'structs' produces C structs of the collections with their encode and decode functions."
                         + " Default option 'off' does not produce C output at all.")
     parser.add_argument('--out-path', default=False, help="The path where to produce the output files.")
+    parser.add_argument('--corpus', default=False, 
+                        help="Write synthetic messages of the schema into the file, back to back, each terminated with T7.")
+    parser.add_argument('--count', type=int, default=100, help="Number of messages in the corpus.")
+    parser.add_argument('--depth', type=int, default=4, help="Maximal nesting of collections and variadics in corpus.")
+    parser.add_argument('--fanout', type=int, default=8, help="Maximal number of elements in variadic of corpus.")
+    parser.add_argument('--blob', type=int, nargs=2, default=[0,32], metavar=('MIN','MAX'), 
+                        help="Length range of blob and UTF8 values in corpus.")
+    parser.add_argument('--stuffing', type=float, default=0.0, help="Probability of stuffing before each TLV in corpus.")
+    parser.add_argument('--fill', type=float, default=0.8, help="Probability of collection member being present in corpus.")
+    parser.add_argument('--seed', type=int, default=None, help="Random seed of the corpus.")
     parser.add_argument('fname', type = str, nargs=1, help="The file name to start the schema parsing from.")
     args = parser.parse_args()
     
@@ -940,6 +1422,36 @@ if __name__ == "__main__":
                 f.write(info)
                 f.close()
                 print( "wrote "+ phpfile )
+    elif args.corpus :
+        factory.loadfile( args.fname[0] )
+        corpus = factory.produce_corpus( args.count, args.depth, args.fanout, tuple(args.blob), 
+                                         args.stuffing, args.fill, args.seed )
+        with open( args.corpus, 'wb') as f:
+            f.write(corpus)
+            f.close()
+            print( "wrote "+ args.corpus + " " + str(len(corpus)) + " bytes" )
+    elif args.C == 'structs' :
+        print("/*\n  messages while parsing the schema:\n")
+        factory.loadfile( args.fname[0] )
+        source = factory.produce_c_structs()
+        header = factory.produce_h_structs()
+        print( "*/")
+        if not args.out_path :
+            print("// ----------------- SOURCE_FILE ----------------- ")
+            print( source )
+            print("// ----------------- HEADER_FILE ----------------- ")
+            print( header )
+        else:
+            cfile = od + "tauschema_" + factory._schema_name + "_structs.c"
+            with open( cfile, 'w') as f:
+                f.write(source)
+                f.close()
+                print( "wrote "+ cfile )
+            hfile = od + "tauschema_" + factory._schema_name + "_structs.h"
+            with open( hfile, 'w') as f:
+                f.write(header)
+                f.close()
+                print( "wrote "+ hfile )
     elif args.C != 'off' :
         print("/*\n  messages while parsing the schema:\n")
         factory.loadfile( args.fname[0] )